@@ -8,16 +8,14 @@ as described in the file LICENSE in the TASBE BioCompiler
 distribution's top directory. */
 
 #include "config.h"
+#include <unistd.h>
 #include "biocompiler.h"
 #include "grn_utilities.h"
 #include "grn_optimizers.h"
+#include "outputs/simulator.h"
 
 using namespace grn;
 
-Chemical* chem_error(CompilationElement* i,string err) {
-  compile_error(i,err); return new Chemical("DUMMY");
-}
-
 /*****************************************************************************
  *  GENETIC REGULAORY NETWORK EMITTER                                        *
  *****************************************************************************/
@@ -35,6 +33,23 @@ GRNEmitter::GRNEmitter(NeoCompiler* parent, Args* args) : IRPropagator(false,fal
   circuit_name = (found==-1) ? outstem : outstem.substr(found+1);
   // which modes will we emit in?
   emit_matlab = args->extract_switch("--to-matlab");
+  emit_simulation = args->extract_switch("--simulate");
+  emit_steady_state = args->extract_switch("--truth-table");
+  robustness_samples = args->extract_switch("--robustness")?args->pop_number():0;
+  robustness_spread = args->extract_switch("--robustness-spread")?args->pop_number():0.2;
+  robustness_seed = args->extract_switch("--robustness-seed")?args->pop_number():1;
+  robustness_only = N_PARAMETER_CLASSES;
+  if(args->extract_switch("--robustness-only")) {
+    string name = args->pop_next();
+    const char* classes[] = {"hill","halflife","strength","dissociation","rate"};
+    for(int i=0;i<FIXED;i++) if(name==classes[i]) robustness_only = i;
+    if(robustness_only==N_PARAMETER_CLASSES)
+      compile_error("Unknown parameter class for --robustness-only: "+name);
+  }
+  // steady-state batches share out over one thread per processor by default
+  sim_threads = args->extract_switch("--sim-threads") ? args->pop_number()
+    : sysconf(_SC_NPROCESSORS_ONLN);
+  if(sim_threads<1) sim_threads = 1;
   plot_all_motif_constants = args->extract_switch("--plot-all-motif-constants");
   plot_all_chemicals = args->extract_switch("--plot-all-chemicals");
   emit_sbol = !args->extract_switch("--no-sbol-output");
@@ -43,6 +58,11 @@ GRNEmitter::GRNEmitter(NeoCompiler* parent, Args* args) : IRPropagator(false,fal
     { emit_sbol = emit_dot = false; }
   emit_unoptimized = args->extract_switch("--output-unoptimized");
   emit_intermediate = args->extract_switch("--output-intermediates");
+  explore = args->extract_switch("--explore");
+  while(args->extract_switch("--explore-motifs",false))
+    { explore_motifs.push_back(args->pop_next()); explore = true; }
+  replay_trace = args->extract_switch("--replay-trace")?args->pop_next():"";
+  replay_step = args->extract_switch("--replay-step")?args->pop_number():-1;
   
   // add path extension
   parent->proto_path.add_to_path(BIOCOMPILERDIR);
@@ -73,30 +93,31 @@ void GRNEmitter::optimize() {
   V4<<grn.to_str();
   GRNCertifyBackpointers checker(verbosity);
   if(paranoid) checker.propagate(&grn); // make sure we're starting OK
-  int step = 0;
+  // every rule sweeps the network once, then reruns only on changes
+  GRNRuleScheduler scheduler(rules,&grn);
+  // intermediate networks are recorded as deltas, replayable on demand
+  OptimizationTrace* trace = NULL;
+  if(emit_intermediate) {
+    trace = new OptimizationTrace(get_stream_for("optimization trace","_opt_trace.jsonl"),parent->last_script);
+    trace->record(&grn,"initial");
+  }
   for(int i=0;i<max_loops;i++) {
-    bool changed=false;
     for(int j=0;j<rules.size();j++) {
-      bool local_change = rules[j]->propagate(&grn); terminate_on_error();
-      changed |= local_change; 
+      if(i>0 && !rules[j]->pending()) continue;
+      bool local_change = rules[j]->drain(); terminate_on_error();
       if(local_change) {
         V1<<"  Network changed" << endl;
         V4<<grn.to_str();
-        if(emit_intermediate) {
-          step++;
-          if(emit_sbol)
-            { to_sbol(get_stream_for("SBOL","_opt_"+i2s(step)+".sbol.xml")); }
-          if(emit_dot)
-            { to_dot(get_stream_for("GraphViz","_opt_"+i2s(step)+".dot")); }
-        }
+        if(trace) trace->record(&grn,rules[j]->to_str());
       }
       if(paranoid) checker.propagate(&grn);// make sure we didn't break anything
     }
-    if(!changed) break;
+    if(!scheduler.pending()) break;
     if(i==(max_loops-1))
       compile_warn("GRN optimizer ran "+i2s(max_loops)+" times without finishing: giving up and returning current partially optimized GRN.");
   }
   checker.propagate(&grn); // make sure we didn't break anything
+  if(trace) { trace->finish(); delete trace; }
 }
 
 // post-processing runs just one pass through all post-processing rules
@@ -111,45 +132,206 @@ void GRNEmitter::post_process() {
 }
 
 
-Chemical* GRNEmitter::parse_chemical(SExpr* def, map<string,Chemical*> *locals, OperatorInstance* oi) {
+/*****************************************************************************
+ *  MOTIF TEMPLATES                                                          *
+ *****************************************************************************/
+// Each operator's :grn-motif is compiled once into a list of steps, with
+// every chemical it names given a slot.  Instantiating the motif for an
+// operator instance is then one pass over the steps, binding slots as it
+// goes, rather than a fresh walk and parse of the S-expression.
+
+namespace grn {
+
+// A chemical named in a motif: argK, a ?local, or a global
+struct MotifSlot {
+  string name;
+  int arg; // K for argK, else -1
+  MotifSlot(string name) {
+    this->name=name; arg=-1;
+    if(name.substr(0,3)=="arg") {
+      int k = atoi(name.c_str()+3);
+      if(k>=0 && "arg"+i2s(k)==name) arg=k;
+    }
+  }
+};
+
+// Properties given where a motif mentions a chemical
+struct MotifProperty {
+  enum { TYPE, HALFLIFE, HILL } kind;
+  ProtoType* type; double value;
+};
+
+struct MotifChemical {
+  int slot; // -1 for an identifier that couldn't be read as a chemical
+  vector<MotifProperty> properties;
+  MotifChemical() { slot=-1; }
+};
+
+struct MotifStep {
+  enum Kind { RXN, PROMOTER, REGULATION, VALUE, TERMINATOR, CDS, ABORT } kind;
+  vector<MotifChemical> chemicals; // regulator & substrate for RXN
+  bool repress; // RXN & REGULATION
+  float strength, dissociation; // REGULATION
+  bool scalar_rate; float rate; // PROMOTER: a number, or else high/low
+  MotifStep(Kind k) { kind=k; repress=scalar_rate=false; rate=0;
+    strength=DEFAULT_STRENGTH; dissociation=DEFAULT_DISSOCIATION; }
+};
+
+struct MotifProgram {
+  uint32_t source_id; // elmt_id of the template, never reused
+  vector<MotifSlot> slots;
+  vector<int> slots_by_name; // order of the untyped chemical report
+  vector<vector<MotifStep> > units; // one per functional unit or reaction
+  bool output_used;
+};
+
+}
+
+static void compile_motif_chemical(SExpr* def, MotifChemical* mc, MotifProgram* prog, map<string,int> *slot_of, Operator* op) {
   if(def->isSymbol()) {
     string cname = ((SE_Symbol*)def)->name;
-    // first, try lookup
-    if(locals->count(cname)) return (*locals)[cname]; // argK, defined ? vars
-    if(grn.chemicals.count(cname)) return grn.chemicals[cname];
-    // if lookup fails, create local or global chemical
-    Chemical* c;
-    if(cname[0]=='?') { c = new Chemical(); (*locals)[cname] = c; } // local
-    else { c = new Chemical(cname);  // global: assume is a motif-constant
-      c->attributes[":motif-constant"]=new MarkerAttribute(true);
-      (*locals)[cname] = c; // add to "local" list for things used locally
-    }
-    grn.chemicals[c->name]=c; return c;
+    if(!slot_of->count(cname))
+      { (*slot_of)[cname] = prog->slots.size(); prog->slots.push_back(MotifSlot(cname)); }
+    mc->slot = (*slot_of)[cname];
   } else if(def->isList()) {
     SE_List_iter li((SE_List*)def);
-    Chemical* c = parse_chemical(li.get_next("chemical"),locals,oi);
+    compile_motif_chemical(li.get_next("chemical"),mc,prog,slot_of,op);
     while(li.has_next()) { // parse properties list
+      MotifProperty p;
       if(li.on_token("|")) { // type
-        convert_sexp_to_type(li.get_next("type"), c, oi); continue;
+        p.kind = MotifProperty::TYPE;
+        p.type = sexp_to_chemical_type(li.get_next("type"),op);
       } else if(li.on_token("t")) { // halflife
-        c->halflife = li.get_num("halflife"); continue;
+        p.kind = MotifProperty::HALFLIFE; p.value = li.get_num("halflife");
       } else if(li.on_token("H")) { // Hill coefficient
-        c->hill_coefficient = li.get_num("Hill coefficient"); continue;
+        p.kind = MotifProperty::HILL; p.value = li.get_num("Hill coefficient");
       } else {
         SExpr* i = li.get_next();
-        compile_error(i,"Unknown chemical property: "+i->to_str());
+        compile_error(i,"Unknown chemical property: "+i->to_str()); continue;
       }
+      mc->properties.push_back(p);
     }
-    return c;
   } else {
-    return chem_error(def,"Expecting a chemical identifier here, but don't know to interpret this as a chemical: "+def->to_str());
+    compile_error(def,"Expecting a chemical identifier here, but don't know to interpret this as a chemical: "+def->to_str());
   }
 }
 
 // want to check to see if we have type information -
 // check for the | and then consume the next SExpr as a type.
-void look_for_chemical_type(Chemical* c,SE_List_iter *i,OperatorInstance* oi){
-  if(i->on_token("|")) { convert_sexp_to_type(i->get_next("type"), c, oi); }
+static void look_for_chemical_type(MotifChemical* mc,SE_List_iter *i,Operator* op){
+  if(i->on_token("|")) {
+    MotifProperty p; p.kind = MotifProperty::TYPE;
+    p.type = sexp_to_chemical_type(i->get_next("type"),op);
+    mc->properties.push_back(p);
+  }
+}
+
+static MotifProgram* compile_motif(Operator* op, SE_List* tmpl) {
+  MotifProgram* prog = new MotifProgram();
+  prog->source_id = tmpl->elmt_id; prog->output_used = false;
+  map<string,int> slot_of;
+  for(int x=0;x<tmpl->len();x++) {
+    prog->units.push_back(vector<MotifStep>());
+    vector<MotifStep>* unit = &prog->units.back();
+    if(!(*tmpl)[x]->isList()) {
+      compile_error((*tmpl)[x],"In GRN motif, expected a list specifying functional unit or reaction, but got "+(*tmpl)[x]->to_str());
+      unit->push_back(MotifStep(MotifStep::ABORT)); break;
+    }
+    SE_List_iter li((SE_List*)(*tmpl)[x]);
+    while(li.has_next()) {
+      if(li.on_token("RXN")) {
+        // Pattern: 'chemical ["activates"|"represses"] chemical'
+        // first chemical is regulator
+        MotifStep step(MotifStep::RXN); step.chemicals.resize(2);
+        compile_motif_chemical(li.get_next("chemical"),&step.chemicals[0],prog,&slot_of,op);
+        look_for_chemical_type(&step.chemicals[0], &li, op);
+        // then get regulation type
+        step.repress = li.on_token("represses");
+        if(!step.repress && !li.on_token("activates")) { 
+          SExpr* e = li.get_next();
+          compile_error(e,"'"+e->to_str()+"' was not expected keyword 'represses' or 'activates'");
+          unit->push_back(MotifStep(MotifStep::ABORT)); break;
+        }
+        // finally, regulated substrate
+        compile_motif_chemical(li.get_next("chemical"),&step.chemicals[1],prog,&slot_of,op);
+        look_for_chemical_type(&step.chemicals[1], &li, op);
+        unit->push_back(step);
+      } else if(li.on_token("P")) {
+        MotifStep step(MotifStep::PROMOTER); // default is low promoter
+        if(li.peek_next()->isScalar()) {
+          step.scalar_rate = true; step.rate = li.get_num("type");
+        } else if(li.on_token("high")) { step.rate = 1;
+        } else if(li.on_token("low")) { step.rate = 0;
+        }
+        unit->push_back(step);
+      } else if(li.on_token("R+") || li.on_token("R-")) {
+        li.unread();
+        MotifStep step(MotifStep::REGULATION); step.chemicals.resize(1);
+        step.repress = (li.get_token()=="R-");
+        compile_motif_chemical(li.get_next("chemical"),&step.chemicals[0],prog,&slot_of,op);
+        look_for_chemical_type(&step.chemicals[0], &li, op);
+        if(li.peek_next()->isScalar()) step.strength = li.get_num();
+        if(li.peek_next()->isScalar()) step.dissociation = li.get_num();
+        unit->push_back(step);
+      } else if(li.on_token("value")) {
+        prog->output_used = true;
+        unit->push_back(MotifStep(MotifStep::VALUE));
+      } else if(li.on_token("T")) {
+        unit->push_back(MotifStep(MotifStep::TERMINATOR));
+      } else { // all others are assumed to be coding sequences
+        MotifStep step(MotifStep::CDS); step.chemicals.resize(1);
+        compile_motif_chemical(li.get_next("chemical"),&step.chemicals[0],prog,&slot_of,op);
+        look_for_chemical_type(&step.chemicals[0], &li, op);
+        unit->push_back(step);
+      }
+    }
+    if(!unit->empty() && unit->back().kind==MotifStep::ABORT) break;
+  }
+  for(map<string,int>::iterator i=slot_of.begin();i!=slot_of.end();i++)
+    prog->slots_by_name.push_back(i->second);
+  return prog;
+}
+
+// The compiled motif for an operator, compiling it on first use
+MotifProgram* GRNEmitter::motif_program(Operator* op, SE_List* tmpl) {
+  MotifProgram*& prog = motif_programs[op];
+  // recompile if the operator's motif has been replaced
+  if(prog==NULL || prog->source_id!=tmpl->elmt_id)
+    { delete prog; prog = compile_motif(op,tmpl); }
+  return prog;
+}
+
+GRNEmitter::~GRNEmitter() {
+  map<Operator*,MotifProgram*,CompilationElement_cmp>::iterator i;
+  for(i=motif_programs.begin();i!=motif_programs.end();i++) delete i->second;
+}
+
+// Find or create the chemical for a motif's slot, then apply properties
+Chemical* GRNEmitter::bind_chemical(MotifProgram* prog, MotifChemical* mc, vector<Chemical*> *ins, vector<Chemical*> *bound, vector<bool> *created) {
+  Chemical* c;
+  if(mc->slot<0) { c = new Chemical("DUMMY");
+  } else if((*bound)[mc->slot]) { c = (*bound)[mc->slot];
+  } else {
+    MotifSlot* s = &prog->slots[mc->slot];
+    if(s->arg>=0 && s->arg<ins->size()) { // argK
+      c = (*ins)[s->arg]; (*created)[mc->slot] = true;
+    } else if(grn.chemicals.count(s->name)) { c = grn.chemicals[s->name];
+    } else { // create local or global chemical
+      if(s->name[0]=='?') { c = new Chemical(); } // local
+      else { c = new Chemical(s->name);  // global: assume is a motif-constant
+        c->attributes[":motif-constant"]=new MarkerAttribute(true);
+      }
+      grn.add_chemical(c); (*created)[mc->slot] = true;
+    }
+    (*bound)[mc->slot] = c;
+  }
+  for(int i=0;i<mc->properties.size();i++) {
+    MotifProperty* p = &mc->properties[i];
+    if(p->kind==MotifProperty::TYPE) assign_chemical_type(c,p->type);
+    else if(p->kind==MotifProperty::HALFLIFE) c->halflife = p->value;
+    else c->hill_coefficient = p->value;
+  }
+  return c;
 }
 
 // Attach any regulations that have been waiting for something to regulate
@@ -168,85 +350,63 @@ void clear_targets_unless(set<DNAComponent*> *targets,string type) {
     targets->clear();
 }
 
-void GRNEmitter::interpret_template(OperatorInstance* oi, SE_List* tmpl,vector<Chemical*> *ins, vector<Chemical*> *outs) {
+void GRNEmitter::instantiate_motif(OperatorInstance* oi, MotifProgram* prog,vector<Chemical*> *ins, vector<Chemical*> *outs) {
   if(verbosity>=3){*cpout<<"Operator Instance: "; oi->op->signature->print(cpout); *cpout<<endl;}
   
-  map<string,Chemical*> locals;
-  for(int i=0;i<ins->size();i++) locals["arg"+i2s(i)] = (*ins)[i];// ins -> argK
-  bool output_used = false;
+  // slot bindings; created marks those argK or made by this instance
+  vector<Chemical*> bound(prog->slots.size(),(Chemical*)NULL);
+  vector<bool> created(prog->slots.size(),false);
 
-  for(int x=0;x<tmpl->len();x++) {
-    if(!(*tmpl)[x]->isList()) {
-      compile_error((*tmpl)[x],"In GRN motif, expected a list specifying functional unit or reaction, but got "+(*tmpl)[x]->to_str());
-      return;
-    }
-    SE_List_iter li((SE_List*)(*tmpl)[x]);
+  for(int x=0;x<prog->units.size();x++) {
+    vector<MotifStep>* unit = &prog->units[x];
     FunctionalUnit* fu = new FunctionalUnit();
     set<DNAComponent*> targets;
     vector<ExpressionRegulation*> pending;
     bool after_first_regs = false, reg_last = false;
-    while(li.has_next()) {
+    for(int k=0;k<unit->size();k++) {
+      MotifStep* step = &(*unit)[k];
       attach_pending_regulations(&targets,&pending);
-      if(li.on_token("RXN")) {
-        // Pattern: 'chemical ["activates"|"represses"] chemical'
-        // first chemical is regulator
-        Chemical* regulator=parse_chemical(li.get_next("chemical"),&locals,oi);
-        look_for_chemical_type(regulator, &li, oi);
-        // then get regulation type
-        bool represses = li.on_token("represses");
-        if(!represses && !li.on_token("activates")) { 
-          SExpr* e = li.get_next();
-          compile_error(e,"'"+e->to_str()+"' was not expected keyword 'represses' or 'activates'"); return;
-        }
-        // finally, regulated substrate
-        Chemical* substrate=parse_chemical(li.get_next("chemical"),&locals,oi);
-        look_for_chemical_type(substrate, &li, oi);
+      if(step->kind==MotifStep::ABORT) {
+        return; // the motif was malformed past this point
+      } else if(step->kind==MotifStep::RXN) {
+        Chemical* regulator = bind_chemical(prog,&step->chemicals[0],ins,&bound,&created);
+        Chemical* substrate = bind_chemical(prog,&step->chemicals[1],ins,&bound,&created);
         // add it to the set of reactions
-        grn.reactions.insert(new RegulatoryReaction(regulator,substrate,represses));
-      } else if(li.on_token("P")) {
+        grn.reactions.insert(new RegulatoryReaction(regulator,substrate,step->repress));
+      } else if(step->kind==MotifStep::PROMOTER) {
         if(after_first_regs) pending.clear();
         after_first_regs = true;
-        ProtoScalar* type = new ProtoBoolean(false); // default is low promoter
-        if(li.peek_next()->isScalar()) {
-          type=new ProtoScalar(li.get_num("type"));
-        } else if(li.on_token("high")) { type=new ProtoBoolean(true);
-        } else if(li.on_token("low")) { type=new ProtoBoolean(false);
-        }
+        ProtoScalar* type = step->scalar_rate ? new ProtoScalar(step->rate)
+          : new ProtoBoolean(step->rate!=0);
         Promoter* promoter = new Promoter(type);
         targets.clear(); targets.insert(promoter); 
-        if(verbosity>=3){*cpout<<"promoter type: ";if (type==NULL)*cpout<<"null";else type->print(cpout);*cpout<<endl;}
+        if(verbosity>=3){*cpout<<"promoter type: "; type->print(cpout); *cpout<<endl;}
         fu->add(promoter);
         reg_last = true;
-      } else if(li.on_token("R+") || li.on_token("R-")) {
-        li.unread(); bool repress = (li.get_token()=="R-");
-        Chemical* c = parse_chemical(li.get_next("chemical"),&locals,oi);
-        look_for_chemical_type(c, &li, oi);
-        float str=li.peek_next()->isScalar() ? li.get_num():DEFAULT_STRENGTH;
-        float d=li.peek_next()->isScalar()?li.get_num():DEFAULT_DISSOCIATION;
-        ExpressionRegulation* er = new ExpressionRegulation(c,NULL,repress,str,d);
+      } else if(step->kind==MotifStep::REGULATION) {
+        Chemical* c = bind_chemical(prog,&step->chemicals[0],ins,&bound,&created);
+        ExpressionRegulation* er = new ExpressionRegulation(c,NULL,step->repress,step->strength,step->dissociation);
         pending.push_back(er);
         reg_last = true;
-      } else if(li.on_token("value")) {
+      } else if(step->kind==MotifStep::VALUE) {
         if(after_first_regs && reg_last) targets.clear();
         clear_targets_unless(&targets,"CodingSequence");
         after_first_regs = true;
-        output_used = true;
         for(int i=0;i<outs->size();i++) {
           CodingSequence* cds = new CodingSequence((*outs)[i]);
           fu->add(cds);
           targets.insert(cds);
         }
         reg_last = false;
-      } else if(li.on_token("T")) {
+      } else if(step->kind==MotifStep::TERMINATOR) {
         after_first_regs = true;
         fu->add(new Terminator());
         reg_last = false;
-      } else { // all others are assumed to be coding sequences
+      } else { // coding sequence
         if(after_first_regs && reg_last) targets.clear();
         clear_targets_unless(&targets,"CodingSequence");
         after_first_regs = true;
-        Chemical* c = parse_chemical(li.get_next("chemical"),&locals,oi);
-        look_for_chemical_type(c, &li, oi);
+        Chemical* c = bind_chemical(prog,&step->chemicals[0],ins,&bound,&created);
         CodingSequence* cds = new CodingSequence(c);
         fu->add(cds); 
         targets.insert(cds);
@@ -257,24 +417,15 @@ void GRNEmitter::interpret_template(OperatorInstance* oi, SE_List* tmpl,vector<C
     attach_pending_regulations(&targets,&pending);
     for(int i=0;i<pending.size();i++) { delete pending[i]; } // not attachable
     // only add if there's content (e.g. not for reactions)
-    if(fu->sequence.size()>0) grn.dnacomponents.insert(fu);
+    if(fu->sequence.size()>0) grn.add_functional_unit(fu);
   }
   // check to make sure every chemical got a type
-  map<string,Chemical*>::iterator it;
-  for(it=locals.begin(); it!=locals.end(); it++) {
-    if (!((*it).second->attributes["type"]))
-      compile_error(oi,"Chemical "+(*it).first+" was not assigned a type");
+  for(int i=0;i<prog->slots_by_name.size();i++) {
+    int s = prog->slots_by_name[i];
+    if(created[s] && !bound[s]->attributes["type"])
+      compile_error(oi,"Chemical "+prog->slots[s].name+" was not assigned a type");
   }
-  // check to make sure all inputs and outputs are used
-  for(int i=0;i<ins->size();i++) {
-    bool found=false;
-    map<string,Chemical*>::iterator it;
-    for(it=locals.begin(); it!=locals.end(); it++) {
-      if((*it).second == (*ins)[i]) found=true;
-    }
-    if(!found) compile_error(oi,"Input "+i2s(i)+" is not used in GRN motif");
-  }
-  if(!output_used) compile_error(oi,"Output is not used in GRN motif");
+  if(!prog->output_used) compile_error(oi,"Output is not used in GRN motif");
 }
 
 void add_standard_completion(FunctionalUnit* fu,vector<Chemical*> *outs) {
@@ -299,7 +450,7 @@ void GRNEmitter::add_template(OperatorInstance *oi,vector<Chemical*> *ins, vecto
   if(oi->op->isA("Primitive")) {
     // First: is there a template attached to the primitive?
     SE_List* tmpl = get_template(oi->op);
-    if(tmpl) { interpret_template(oi, tmpl,ins,outs); return; }
+    if(tmpl) { instantiate_motif(oi,motif_program(oi->op,tmpl),ins,outs); return; }
     // if not, see if we have a special-case handler:
     string name = ((Primitive*)oi->op)->name;
     if(name=="all") {
@@ -308,7 +459,7 @@ void GRNEmitter::add_template(OperatorInstance *oi,vector<Chemical*> *ins, vecto
       new ExpressionRegulation((*ins)[ins->size()-1],p);
       fu->add(p);
       add_standard_completion(fu,outs); 
-      grn.dnacomponents.insert(fu); return;
+      grn.add_functional_unit(fu); return;
     }
   } else if(oi->op->isA("Literal")) {
     ProtoType* type = ((Literal*)oi->op)->value;
@@ -318,25 +469,22 @@ void GRNEmitter::add_template(OperatorInstance *oi,vector<Chemical*> *ins, vecto
       ProtoBoolean* b = dynamic_cast<ProtoBoolean*>(type);
       fu->add(new Promoter(b));
       add_standard_completion(fu,outs);
-      grn.dnacomponents.insert(fu); return;
+      grn.add_functional_unit(fu); return;
     } else if(type->isA("ProtoScalar")) {
       compile_warn(oi,"Operator "+oi->op->to_str()+" has at least one instance that returns a number, rather than a Boolean value.  Numbers are not yet fully supported, and may produce incorrect GRNs.");
       ProtoScalar* sc = dynamic_cast<ProtoScalar*>(type);
       FunctionalUnit* fu = new FunctionalUnit();
       fu->add(new Promoter(sc));
       add_standard_completion(fu,outs);
-      grn.dnacomponents.insert(fu); return;
+      grn.add_functional_unit(fu); return;
     }
   } // fall-through case = error
   compile_error("Don't know how to make a GRN motif from "+oi->op->to_str());
 }
 
-uint8_t* GRNEmitter::emit_from(DFG* g, int* len) {
-  V1 << "Starting GRN emitter..."<<endl;
-  // Extract relevant portions from DFG
-  if(g->relevant.size()!=1) {
-    compile_error("All functions must be expanded into primitive operations, but some could not be.");
-  }
+// translate the DFG into a fresh, unoptimized GRN
+void GRNEmitter::build_grn(DFG* g) {
+  grn.clear(); // free any network from an earlier build, e.g. when exploring
   AMset spaces; g->output->domain->all_spaces(&spaces);
   Fset edges; g->output->domain->all_fields(&edges);
   OIset nodes; g->output->domain->all_ois(&nodes);
@@ -351,7 +499,7 @@ uint8_t* GRNEmitter::emit_from(DFG* g, int* len) {
     for(;i!=(*fit)->consumers.end();i++) {
       j++;
       string name = (*fit)->nicename()+(((*fit)->consumers.size()>1)?i2s(j):"");
-      grn.chemicals[name] = new Chemical(name);
+      grn.add_chemical(new Chemical(name));
       ProtoType* type = (*fit)->range;
       grn.chemicals[name]->attributes["type"] = new ProtoTypeAttribute(type);
       signals[*fit][(*i).first] = grn.chemicals[name];
@@ -373,6 +521,16 @@ uint8_t* GRNEmitter::emit_from(DFG* g, int* len) {
     // now translate the template into DNA components and reactions
     add_template(*oit,&ins,&outs);
   }
+}
+
+uint8_t* GRNEmitter::emit_from(DFG* g, int* len) {
+  V1 << "Starting GRN emitter..."<<endl;
+  if(replay_trace!="") { replay_optimization_trace(); return NULL; }
+  // Extract relevant portions from DFG
+  if(g->relevant.size()!=1) {
+    compile_error("All functions must be expanded into primitive operations, but some could not be.");
+  }
+  build_grn(g);
   terminate_on_error(); // quit here if we've encountered an error
 
   // check to see if we want to emit unoptimized sbol
@@ -394,6 +552,24 @@ uint8_t* GRNEmitter::emit_from(DFG* g, int* len) {
 
   V1 << "Linearizing GRN to output streams..."<<endl;
   // render the network into a string, possibly printing to output stream
+  string net = linearize();
+  if(parent->is_dump_code) {
+    *cpout<<"Genetic Regulatory Network:\n"<<net;
+    *cpout<<"End of Genetic Regulatory Network\n" << flush; 
+  }
+
+  // and output to files
+  if(emit_matlab) { to_matlab(net); }
+  if(emit_simulation) { simulate(); }
+  if(emit_steady_state) { steady_state_table(); }
+  if(robustness_samples>0) { robustness_analysis(); }
+  if(emit_sbol) { to_sbol(get_stream_for("SBOL",".sbol.xml")); }
+  if(emit_dot) { to_dot(get_stream_for("GraphViz",".dot")); }
+  if(explore) { explore_design_space(g); }
+  return NULL;
+}
+
+string GRNEmitter::linearize() {
   ostringstream net;
   vector<string> grns;
   for(set<DNAComponent*>::iterator i=grn.dnacomponents.begin();i!=grn.dnacomponents.end();i++)
@@ -404,16 +580,7 @@ uint8_t* GRNEmitter::emit_from(DFG* g, int* len) {
   sort(grns.begin(), grns.end());
   for(vector<string>::iterator i=grns.begin();i!=grns.end();i++)
     { net<<*i;net<<endl; }
-  if(parent->is_dump_code) {
-    *cpout<<"Genetic Regulatory Network:\n"<<net.str();
-    *cpout<<"End of Genetic Regulatory Network\n" << flush; 
-  }
-
-  // and output to files
-  if(emit_matlab) { to_matlab(net.str()); }
-  if(emit_sbol) { to_sbol(get_stream_for("SBOL",".sbol.xml")); }
-  if(emit_dot) { to_dot(get_stream_for("GraphViz",".dot")); }
-  return NULL;
+  return net.str();
 }
 
 // Note: assumes file will get cleaned up by termination
@@ -18,6 +18,22 @@ distribution's top directory. */
 
 namespace grn {
 
+/* Compact record of an optimization run: one JSONL line per rewrite,
+ holding only the elements that rule changed (see trace.cpp) */
+typedef map<string,string> TraceSnapshot; // element key -> JSON record
+class OptimizationTrace {
+ public:
+  OptimizationTrace(ostream* out, string program);
+  void record(GRN* net, string rule); // write the delta since last record
+  void finish() { *out << flush; }
+ private:
+  ostream* out; string program; int step;
+  TraceSnapshot last[3]; // chemicals, functional units, reactions
+  void snapshot(GRN* net, TraceSnapshot* snap);
+};
+
+struct MotifProgram; struct MotifChemical; // compiled :grn-motif templates
+
 class GRNEmitter : public CodeEmitter, public IRPropagator {
   reflection_sub2(GRNEmitter, CodeEmitter, IRPropagator);
 
@@ -28,26 +44,44 @@ class GRNEmitter : public CodeEmitter, public IRPropagator {
   vector<GRNPropagator*> rules;
   vector<GRNPropagator*> postprocessing;
   int max_loops, verbosity;
-  bool paranoid, emit_matlab,emit_intermediate, emit_sbol,emit_unoptimized,emit_dot,emit_to_stdout;
+  bool paranoid, emit_matlab,emit_simulation,emit_steady_state,emit_intermediate, emit_sbol,emit_unoptimized,emit_dot,emit_to_stdout;
   bool plot_all_chemicals, plot_all_motif_constants; // all motif-constants or just I/O?
+  int robustness_samples, robustness_seed, robustness_only; // 0 samples = off
+  double robustness_spread;
+  int sim_threads; // worker threads for steady-state tables (truth table,
+                   // robustness, exploration)
+  bool explore; // design-space exploration over motifs & optimizer settings
+  vector<string> explore_motifs; // alternative motif libraries to explore
+  string replay_trace; int replay_step; // trace to rebuild; -1 = last step
+  map<Operator*,MotifProgram*,CompilationElement_cmp> motif_programs;
   // These need to be extracted into an abstract GRN:
   GRN grn;
 
  public:
   GRNEmitter(NeoCompiler* parent, Args* args);
+  ~GRNEmitter();
   uint8_t* emit_from(DFG* g, int* len);
 
  private:
+  void build_grn(DFG* g);
   void optimize();
   void post_process();
+  void explore_design_space(DFG* g);
+  void replay_optimization_trace();
+  string linearize(); // sorted, one-element-per-line network description
+  string replay_program; // script named by a replayed trace
 
   void add_template(OperatorInstance *oi,vector<Chemical*> *in,vector<Chemical*> *outs);
-  Chemical* parse_chemical(SExpr* def, map<string,Chemical*> *locals,OperatorInstance* oi);
-  void interpret_template(OperatorInstance *oi,SE_List* s,vector<Chemical*> *ins, vector<Chemical*> *outs);
+  MotifProgram* motif_program(Operator* op, SE_List* tmpl);
+  Chemical* bind_chemical(MotifProgram* prog, MotifChemical* mc, vector<Chemical*> *ins, vector<Chemical*> *bound, vector<bool> *created);
+  void instantiate_motif(OperatorInstance *oi,MotifProgram* prog,vector<Chemical*> *ins, vector<Chemical*> *outs);
 
   void initialize_grn_optimizers(Args* args);
     // Output functions
   void to_matlab(string net_description);
+  void simulate();
+  void steady_state_table();
+  void robustness_analysis();
   void to_sbol(ostream* out);
   void to_dot(ostream* out);
   void print(ostream *out) { *out << "GRN Emitter"; }
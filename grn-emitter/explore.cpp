@@ -0,0 +1,240 @@
+/* Design-space exploration
+Copyright (C) 2009-2011, Raytheon BBN Technologies and contributors listed
+in the AUTHORS file in TASBE BioCompiler distribution's top directory.
+
+This file is part of the TASBE BioCompiler, and is distributed under
+the terms of the GNU General Public License, with a linking exception,
+as described in the file LICENSE in the TASBE BioCompiler
+distribution's top directory. */
+
+// Compiles one program under several motif libraries and optimizer
+// settings, scores each resulting GRN, and reports the Pareto front.
+// The variants all reuse the program's DFG: only the GRN is rebuilt.
+// Compiling is sequential, since the compiler keeps global state, but the
+// variants' truth tables are then settled concurrently.
+
+#include "config.h"
+#include <pthread.h>
+#include "biocompiler.h"
+#include "grn_utilities.h"
+#include "outputs/simulator.h"
+
+using namespace grn;
+
+// The :grn-motif of every operator in a DFG (NULL if it has none)
+typedef map<Operator*,Attribute*,CompilationElement_cmp> MotifLibrary;
+
+static void snapshot_motifs(OIset* nodes, MotifLibrary* lib) {
+  for_set(OperatorInstance*,*nodes,i) {
+    Operator* op = (*i)->op;
+    (*lib)[op] = op->attributes.count(":grn-motif") ?
+      op->attributes[":grn-motif"] : NULL;
+  }
+}
+
+static void install_motifs(MotifLibrary* lib) {
+  for(MotifLibrary::iterator i=lib->begin();i!=lib->end();i++) {
+    if(i->second) i->first->attributes[":grn-motif"] = i->second;
+    else i->first->attributes.erase(":grn-motif");
+  }
+}
+
+// Scores of one variant; all are to be minimized
+struct DesignPoint {
+  string motifs, optimizers;
+  int functional_units, repressors, parts, distinct_parts, errors;
+  bool pareto;
+  // steady-state truth table, by signal name
+  vector<string> inputs, outputs;
+  vector<char> truth; // rows x outputs
+  vector<char> settled; // per row
+  SteadyStateTable* table; // from measure() until score()
+
+  DesignPoint(string m, string o)
+    { motifs=m; optimizers=o; pareto=false; table=NULL; }
+  /// Count the network's parts and set up its truth table
+  void measure(GRN* net, int threads);
+  /// Read the settled truth table, then free it
+  void score();
+  bool dominates(DesignPoint* d);
+  // output level for a row of the other point's table, or -1 if unknown
+  int lookup(DesignPoint* other, int row, string output);
+};
+
+void DesignPoint::measure(GRN* net, int threads) {
+  functional_units = net->dnacomponents.size();
+  set<Chemical*,CompilationElement_cmp> repressing;
+  set<string> kinds;
+  parts = 0;
+  for_set(DNAComponent*,net->dnacomponents,i) {
+    FunctionalUnit* fu = (FunctionalUnit*)*i;
+    for(int j=0;j<fu->sequence.size();j++) {
+      parts++; kinds.insert(fu->sequence[j]->to_str());
+      for_adj(ExpressionRegulation*,fu->sequence[j]->regulators,er)
+        if((*er)->repressor) repressing.insert((*er)->signal);
+    }
+  }
+  repressors = repressing.size(); distinct_parts = kinds.size();
+  // the table's model is a copy, so it outlives the network's next rebuild
+  table = new SteadyStateTable(net,threads);
+}
+
+void DesignPoint::score() {
+  GRNModel* m = &table->model;
+  for(int i=0;i<m->inputs.size();i++) inputs.push_back(m->names[m->inputs[i]]);
+  for(int i=0;i<m->outputs.size();i++)
+    outputs.push_back(m->names[m->outputs[i]]);
+  truth.resize(table->level.size());
+  for(int i=0;i<truth.size();i++) truth[i] = table->level[i]>1e2;
+  for(int r=0;r<table->n_rows;r++)
+    settled.push_back(table->settle_time[r]>=0);
+  delete table; table = NULL;
+}
+
+// Design points whose truth tables are waiting to be settled
+struct PointQueue {
+  vector<DesignPoint>* points;
+  int next;
+  pthread_mutex_t lock;
+};
+
+static void* settle_points(void* arg) {
+  PointQueue* q = (PointQueue*)arg;
+  while(true) {
+    pthread_mutex_lock(&q->lock);
+    int p = q->next++;
+    pthread_mutex_unlock(&q->lock);
+    if(p>=q->points->size()) return NULL;
+    (*q->points)[p].table->run();
+  }
+}
+
+int DesignPoint::lookup(DesignPoint* other, int row, string output) {
+  int k = find(outputs.begin(),outputs.end(),output)-outputs.begin();
+  if(k==outputs.size()) return -1;
+  // inputs this variant lacks don't matter to it; ones it adds are off
+  int r = 0;
+  for(int i=0;i<inputs.size();i++) {
+    int j = find(other->inputs.begin(),other->inputs.end(),inputs[i])
+      - other->inputs.begin();
+    if(j<other->inputs.size() && ((row>>j)&1)) r |= 1<<i;
+  }
+  if(!settled[r]) return -1;
+  return truth[r*outputs.size()+k];
+}
+
+bool DesignPoint::dominates(DesignPoint* d) {
+  int mine[] = {functional_units,repressors,distinct_parts,errors};
+  int theirs[] = {d->functional_units,d->repressors,d->distinct_parts,d->errors};
+  bool better = false;
+  for(int i=0;i<4;i++) {
+    if(mine[i]>theirs[i]) return false;
+    if(mine[i]<theirs[i]) better = true;
+  }
+  return better;
+}
+
+void GRNEmitter::explore_design_space(DFG* g) {
+  V1 << "Exploring design space..."<<endl;
+  double start = get_real_secs();
+  // optimizer settings: everything enabled, nothing, and each rule left out
+  vector<string> opt_names; vector<vector<GRNPropagator*> > opt_sets;
+  opt_names.push_back("all"); opt_sets.push_back(rules);
+  opt_names.push_back("none"); opt_sets.push_back(vector<GRNPropagator*>());
+  for(int j=0;rules.size()>1 && j<rules.size();j++) {
+    vector<GRNPropagator*> others = rules;
+    others.erase(others.begin()+j);
+    opt_names.push_back("-"+rules[j]->to_str()); opt_sets.push_back(others);
+  }
+  // motif libraries: as loaded, then each alternative annotated over it
+  OIset nodes; g->output->domain->all_ois(&nodes);
+  vector<string> lib_names; vector<MotifLibrary> libs(1);
+  lib_names.push_back("default"); snapshot_motifs(&nodes,&libs[0]);
+  for(int i=0;i<explore_motifs.size();i++) {
+    SExpr* s = read_sexpr("Motif library","(include "+explore_motifs[i]+")");
+    if(s==NULL) { compile_error("Could not read motif library "+explore_motifs[i]); continue; }
+    // clear the motifs, so that the library annotates them afresh
+    for(MotifLibrary::iterator j=libs[0].begin();j!=libs[0].end();j++)
+      j->first->attributes.erase(":grn-motif");
+    // interpreting replaces the DFG's output with the file's; put it back
+    Field* program = g->output;
+    parent->interpreter->interpret(s); terminate_on_error();
+    g->output = program; g->determine_relevant();
+    libs.push_back(MotifLibrary()); lib_names.push_back(explore_motifs[i]);
+    snapshot_motifs(&nodes,&libs.back());
+    // operators the library leaves alone keep their default motifs
+    for(MotifLibrary::iterator j=libs.back().begin();j!=libs.back().end();j++)
+      if(!j->second) j->second = libs[0][j->first];
+    install_motifs(&libs[0]);
+  }
+
+  // compile every combination; the threads are shared out among the
+  // variants, with any to spare going to each one's rows
+  int n_points = libs.size()*opt_sets.size();
+  int table_threads = max(1,sim_threads/n_points);
+  vector<GRNPropagator*> configured = rules;
+  bool intermediate = emit_intermediate; emit_intermediate = false;
+  vector<DesignPoint> points;
+  for(int l=0;l<libs.size();l++) {
+    install_motifs(&libs[l]);
+    for(int o=0;o<opt_sets.size();o++) {
+      V2 << "Compiling with motifs "<<lib_names[l]<<", optimizers "
+         <<opt_names[o]<<endl;
+      build_grn(g); terminate_on_error();
+      rules = opt_sets[o];
+      optimize(); post_process();
+      points.push_back(DesignPoint(lib_names[l],opt_names[o]));
+      points.back().measure(&grn,table_threads);
+    }
+  }
+  install_motifs(&libs[0]);
+  rules = configured; emit_intermediate = intermediate;
+
+  // settle the variants' truth tables, one variant per worker thread
+  PointQueue q; q.points = &points; q.next = 0;
+  pthread_mutex_init(&q.lock,NULL);
+  vector<pthread_t> workers(min(sim_threads,n_points)-1);
+  for(int w=0;w<workers.size();w++)
+    if(pthread_create(&workers[w],NULL,settle_points,&q))
+      { workers.resize(w); break; } // carry on with the threads we have
+  settle_points(&q);
+  for(int w=0;w<workers.size();w++) pthread_join(workers[w],NULL);
+  pthread_mutex_destroy(&q.lock);
+  for(int p=0;p<points.size();p++) points[p].score();
+
+  // correctness is agreement with the unoptimized default network, which
+  // implements the program most directly
+  DesignPoint* ref = &points[1];
+  int n_rows = 1<<ref->inputs.size();
+  for(int p=0;p<points.size();p++) {
+    points[p].errors = 0;
+    for(int r=0;r<n_rows;r++)
+      for(int k=0;k<ref->outputs.size();k++) {
+        int want = ref->lookup(ref,r,ref->outputs[k]);
+        if(want<0 || points[p].lookup(ref,r,ref->outputs[k])!=want)
+          points[p].errors++;
+      }
+  }
+  for(int p=0;p<points.size();p++) {
+    points[p].pareto = true;
+    for(int q=0;q<points.size() && points[p].pareto;q++)
+      if(points[q].dominates(&points[p])) points[p].pareto = false;
+  }
+
+  V1<<"Explored "<<points.size()<<" design variants in "
+    <<(get_real_secs()-start)<<" secs; Pareto front:"<<endl;
+  ostream* out = get_stream_for("design space","_design_space.csv");
+  *out<<"Motifs,Optimizers,FunctionalUnits,Repressors,Parts,DistinctParts,"
+      <<"Errors,Pareto\n";
+  for(int p=0;p<points.size();p++) {
+    DesignPoint* d = &points[p];
+    *out<<d->motifs<<","<<d->optimizers<<","<<d->functional_units<<","
+        <<d->repressors<<","<<d->parts<<","<<d->distinct_parts<<","
+        <<d->errors<<","<<d->pareto<<"\n";
+    if(d->pareto)
+      V1<<"  "<<d->motifs<<" / "<<d->optimizers<<": "<<d->functional_units
+        <<" FUs, "<<d->repressors<<" repressors, "<<d->distinct_parts
+        <<" distinct parts, "<<d->errors<<" errors"<<endl;
+  }
+  *out<<flush;
+}
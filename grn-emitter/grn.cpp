@@ -18,26 +18,26 @@ using namespace grn;
  *****************************************************************************/
 
 void DNAComponent::print_regulators(ostream* out) { 
-  for_set(ExpressionRegulation*, regulators, i) { (*i)->print(out); }
+  for_adj(ExpressionRegulation*, regulators, i) { (*i)->print(out); }
 }
 
 DNAComponent::~DNAComponent() {
-  set<ExpressionRegulation*,CompilationElement_cmp> deletesafe_regulators = regulators;
-  for_set(ExpressionRegulation*, deletesafe_regulators, i) { 
+  GRNAdjacency<ExpressionRegulation*> deletesafe_regulators = regulators;
+  for_adj(ExpressionRegulation*, deletesafe_regulators, i) { 
     (*i)->signal->consumers.erase(*i);
   }
 }
 
 DNAComponent* CodingSequence::clone() { 
   CodingSequence* cds = new CodingSequence(product);
-  for_set(ExpressionRegulation*, regulators, i) 
+  for_adj(ExpressionRegulation*, regulators, i) 
     { cds->regulators.insert((*i)->clone(cds)); }
   return cds;
 }
 
 DNAComponent* Promoter::clone() { 
   Promoter* p  = new Promoter(rate); 
-  for_set(ExpressionRegulation*, regulators, i) 
+  for_adj(ExpressionRegulation*, regulators, i) 
     { p->regulators.insert((*i)->clone(p)); }
   return p;
 }
@@ -53,31 +53,61 @@ void GRN::print(ostream* out) {
  *  COMPLEX GRN MANIPULATION FUNCTIONS                                       *
  *****************************************************************************/
 
+void GRN::add_chemical(Chemical* c) {
+  if(chemicals.count(c->name)) chemical_ids.remove(chemicals[c->name]);
+  chemicals[c->name] = c; chemical_ids.add(c);
+}
+
+void GRN::add_functional_unit(FunctionalUnit* fu) {
+  if(dnacomponents.insert(fu).second) functional_unit_ids.add(fu);
+}
+
+void GRN::clear() {
+  // regulations first, so that units and reactions can go without leaving
+  // relations behind on the chemicals, which go last
+  for_set(DNAComponent*,dnacomponents,i) {
+    FunctionalUnit* fu = (FunctionalUnit*)*i;
+    for(int j=0;j<fu->sequence.size();j++) {
+      GRNAdjacency<ExpressionRegulation*> regs = fu->sequence[j]->regulators;
+      for_adj(ExpressionRegulation*,regs,er) delete *er;
+    }
+    delete fu;
+  }
+  for_set(RegulatoryReaction*,reactions,i) delete *i;
+  // a chemical still related to something is referenced from outside the
+  // network (e.g. by a deleted unit), so leave it be
+  for_map(string,Chemical*,chemicals,i) {
+    Chemical* c = i->second;
+    if(c->producers.empty() && c->consumers.empty() &&
+       c->regulatedBy.empty() && c->regulatorFor.empty()) delete c;
+  }
+  dnacomponents.clear(); reactions.clear(); chemicals.clear();
+  chemical_ids = GRNSlotMap<Chemical>();
+  functional_unit_ids = GRNSlotMap<FunctionalUnit>();
+}
+
 void GRN::delete_chemical(Chemical* c) {
   /// ADA: products! need this to check for the flag too!
   /// ADA: if(c->consumers.size() && c->producers.size()) ierror("Attempted to delete non-redundant chemical");
   if(c->consumers.size() || c->regulatorFor.size())
     ierror("Attempted to delete chemical that is still required by network");
   // delete all producer PCSs
-  set<CodingSequence*> to_delete;
-  set<CodingSequence*>::iterator pi=c->producers.begin();
-  for( ;pi!=c->producers.end();pi++) 
-    { delete_feature(*pi); to_delete.insert(*pi); }
-  for_set(CodingSequence*,to_delete,pi) { delete *pi; }
-  // delete all regulator reactions
-  set<RegulatoryReaction*>::iterator ri=c->regulatedBy.begin();
-  for( ;ri!=c->regulatedBy.end();ri++) delete (*ri);
+  GRNAdjacency<CodingSequence*> to_delete = c->producers;
+  for_adj(CodingSequence*,to_delete,pi) { delete_feature(*pi); delete *pi; }
+  // delete all regulator reactions; each unlinks itself from regulatedBy
+  GRNAdjacency<RegulatoryReaction*> reactions_to_delete = c->regulatedBy;
+  for_adj(RegulatoryReaction*,reactions_to_delete,ri) delete (*ri);
 
   /// ADA delete all consumer RRs
   /// ADA set<RegulatoryRegion*>::iterator rr=c->consumers.begin();
   /// ADA for( ;rr!=c->consumers.end();rr++) delete_feature(*rr);
 
-  chemicals.erase(c->name);
+  chemicals.erase(c->name); chemical_ids.remove(c);
 }
 void  GRN::delete_functional_unit(FunctionalUnit* fu) {
   // change links w. chemicals
   for(int i=0;i<fu->sequence.size();i++) {
-    for_set(ExpressionRegulation*, fu->sequence[i]->regulators, er) {
+    for_adj(ExpressionRegulation*, fu->sequence[i]->regulators, er) {
       (*er)->signal->consumers.erase(*er);
     }
     if(fu->sequence[i]->isA("CodingSequence")) {
@@ -85,14 +115,14 @@ void  GRN::delete_functional_unit(FunctionalUnit* fu) {
       pcs->product->producers.erase(pcs);
     }
   }
-  dnacomponents.erase(fu);
+  dnacomponents.erase(fu); functional_unit_ids.remove(fu);
 }
 
 
 // invert all regulation in entire functional unit
 void GRN::invert_regulation(FunctionalUnit* target,int verbosity) {
   for(int i=0;i<target->sequence.size();i++) {
-    for_set(ExpressionRegulation*, target->sequence[i]->regulators, er) {
+    for_adj(ExpressionRegulation*, target->sequence[i]->regulators, er) {
       (*er)->repressor = !(*er)->repressor;
     }
     if(target->sequence[i]->isA("Promoter")) {
@@ -117,7 +147,7 @@ void GRN::invert_regulation(ExpressionRegulation* er,int verbosity) {
   Promoter* p = NULL;
   bool all_repressors = true;
   for(int i=0;i<fu->sequence.size();i++) {
-    for_set(ExpressionRegulation*, fu->sequence[i]->regulators, er) {
+    for_adj(ExpressionRegulation*, fu->sequence[i]->regulators, er) {
       V4<<"Checking for repression: "<<(*er)->to_str()<<" = "<<b2s((*er)->repressor)<<endl;
       if(!(*er)->repressor) all_repressors = false;
     }
@@ -156,7 +186,7 @@ void GRN::replace_inputs(FunctionalUnit* dst, FunctionalUnit* src,DNAComponent*
       if(src->sequence[i]==src_cds || src_cds==NULL) {
         if(first_cds==NULL) {
           V4<<"Copying CDS regulations: "<<src->sequence[i]->to_str()<<endl;
-          for_set(ExpressionRegulation*, src->sequence[i]->regulators, er)
+          for_adj(ExpressionRegulation*, src->sequence[i]->regulators, er)
             { cds_regs.push_back(*er); }
           first_cds = src->sequence[i];
         } else { // Subsequence CDS: confirm equality
@@ -179,8 +209,8 @@ void GRN::replace_inputs(FunctionalUnit* dst, FunctionalUnit* src,DNAComponent*
       if(dst->sequence[i]->isA("CodingSequence")) {
         V4<<"Replacing regulation on: "<<dst->sequence[i]->to_str()<<endl;
         // kill old regulations
-        set<ExpressionRegulation*,CompilationElement_cmp> deletesafe_regulators = dst->sequence[i]->regulators;
-        for_set(ExpressionRegulation*, deletesafe_regulators, er)
+        GRNAdjacency<ExpressionRegulation*> deletesafe_regulators = dst->sequence[i]->regulators;
+        for_adj(ExpressionRegulation*, deletesafe_regulators, er)
           { delete *er; }
         // replace with new regulations
         for(int j=0;j<cds_regs.size();j++) {
@@ -206,26 +236,26 @@ void GRN::replace_inputs(FunctionalUnit* dst, FunctionalUnit* src,DNAComponent*
 
 void GRNCertifyBackpointers::act(Chemical* c) {
   if(verbosity>=4) *cpout<<"Certifying chemical "<<c->to_str()<<endl;
-  for_set(ExpressionRegulation*, c->consumers, ci) {
+  for_adj(ExpressionRegulation*, c->consumers, ci) {
     if((*ci)->signal==NULL) ierror(c,"GRN data structure corrupted: null consumer backpointer");
     if((*ci)->target==NULL) ierror(c,"GRN data structure corrupted: null consumer target");
     if((*ci)->signal!=c)
       { bad=true; ierror(c,"GRN data structure corrupted: bad consumer backpointer: "+c->to_str());}
     if((*ci)->target->container==NULL) ierror(c,"GRN data structure corrupted: null target container");
-    if(!grn->dnacomponents.count((*ci)->target->container)) {
+    if(!grn->is_live((*ci)->target->container)) {
       bad=true;
       ierror(c,"GRN data structure corrupted: ghost consumer for "+c->to_str()+" in "+(*ci)->target->container->to_str());
     }
   }
-  for_set(CodingSequence*, c->producers, pi) {
+  for_adj(CodingSequence*, c->producers, pi) {
     if((*pi)->product!=c)
       { bad=true; ierror(c,"GRN data structure corrupted: bad producer backpointer: "+c->to_str());}
-    if(!grn->dnacomponents.count((*pi)->container)) {
+    if(!grn->is_live((*pi)->container)) {
       bad=true; string tmp = (*pi)->container->to_str();
       ierror(c,"GRN data structure corrupted: ghost producer: "+tmp+" for "+c->to_str());
     }
   }
-  for_set(RegulatoryReaction*, c->regulatorFor, ri) {
+  for_adj(RegulatoryReaction*, c->regulatorFor, ri) {
     if((*ri)->regulator!=c) {
       bad=true;
       ierror(c,"GRN data structure corrupted: bad regulation backpointer: "+c->to_str());
@@ -235,7 +265,7 @@ void GRNCertifyBackpointers::act(Chemical* c) {
       ierror(c,"GRN data structure corrupted: ghost regulation: "+tmp+" for "+c->to_str());
     }
   }
-  for_set(RegulatoryReaction*, c->regulatedBy, ri) {
+  for_adj(RegulatoryReaction*, c->regulatedBy, ri) {
     if((*ri)->substrate!=c) {
       bad=true;
       ierror(c,"GRN data structure corrupted: bad regulator backpointer: "+c->to_str());
@@ -253,7 +283,7 @@ void GRNCertifyBackpointers::act(Chemical* c) {
 void GRNCertifyBackpointers::act(FunctionalUnit* fu) {
   if(verbosity>=4) *cpout<<"Certifying functional unit "<<fu->to_str()<<endl;
   for(int i=0;i<fu->sequence.size();i++) {
-    for_set(ExpressionRegulation*,fu->sequence[i]->regulators,er) {
+    for_adj(ExpressionRegulation*,fu->sequence[i]->regulators,er) {
       if((*er)->signal==NULL) ierror(fu,"GRN data structure corrupted: null regulator backpointer");
       if((*er)->target==NULL) ierror(fu,"GRN data structure corrupted: null regulator target");
       if((*er)->target!=fu->sequence[i]) ierror(fu,"GRN data structure corrupted: bad target backpointer: "+(*er)->to_str());
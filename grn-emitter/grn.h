@@ -10,6 +10,7 @@ distribution's top directory. */
 #ifndef __GRN__
 #define __GRN__
 
+#include <algorithm>
 #include <proto/compiler.h>
 #include <proto/nicenames.h>
 
@@ -36,10 +37,81 @@ namespace grn {
 
 string scalar_to_str(ProtoScalar* s);
 
+/// Slot map giving each live element of a GRN a small dense integer ID,
+/// so that per-element data can live in flat arrays.  It is an index
+/// only: the GRN's set and map still own the elements and fix the order
+/// passes visit them in.  IDs of deleted elements are reused; each slot's
+/// generation count tells a stale (id,generation) handle from the slot's
+/// current occupant.
+template<class T> class GRNSlotMap {
+ public:
+  int add(T* x) {
+    int id;
+    if(free_ids.empty())
+      { id = items.size(); items.push_back(x); generations.push_back(0); }
+    else { id = free_ids.back(); free_ids.pop_back(); items[id] = x; }
+    x->grn_id = id; x->grn_generation = generations[id];
+    return id;
+  }
+  void remove(T* x) {
+    if(!contains(x)) return;
+    items[x->grn_id] = NULL; generations[x->grn_id]++;
+    free_ids.push_back(x->grn_id);
+  }
+  bool live(int id, unsigned generation) const {
+    return id>=0 && id<items.size() && items[id]!=NULL &&
+      generations[id]==generation;
+  }
+  bool contains(T* x) const
+  { return live(x->grn_id,x->grn_generation) && items[x->grn_id]==x; }
+  T* operator[](int id) const { return items[id]; } // NULL for a free slot
+  int capacity() const { return items.size(); } // all IDs are below this
+  int size() const { return items.size()-free_ids.size(); }
+ private:
+  vector<T*> items;
+  vector<unsigned> generations;
+  vector<int> free_ids;
+};
+
+/// Flat adjacency list for one side of a GRN relation: a vector kept in
+/// CompilationElement order, so it iterates in the same (creation) order
+/// as the std::sets it replaced.  Relations are few per element, so the
+/// sorted insert or erase done by each relation's constructor and
+/// destructor only moves a handful of contiguous pointers.  As with any
+/// vector, an insert or erase invalidates iterators: a loop that changes
+/// the list it walks must walk a copy.
+template<class T> class GRNAdjacency {
+ public:
+  typedef typename vector<T>::iterator iterator;
+  iterator begin() { return items.begin(); }
+  iterator end() { return items.end(); }
+  int size() const { return items.size(); }
+  bool empty() const { return items.empty(); }
+  void clear() { items.clear(); }
+  void insert(T x) {
+    iterator i = lower_bound(items.begin(),items.end(),x,
+                             CompilationElement_cmp());
+    if(i==items.end() || *i!=x) items.insert(i,x);
+  }
+  void erase(T x) {
+    iterator i = lower_bound(items.begin(),items.end(),x,
+                             CompilationElement_cmp());
+    if(i!=items.end() && *i==x) items.erase(i);
+  }
+  int count(T x) const {
+    return binary_search(items.begin(),items.end(),x,CompilationElement_cmp());
+  }
+ private:
+  vector<T> items;
+};
+
+#define for_adj(t, x, i)                                        \
+  for (grn::GRNAdjacency<t>::iterator i = (x).begin() ; i != (x).end(); ++i)
+
 class FunctionalUnit; class ExpressionRegulation; 
 class DNAComponent : public CompilationElement {
  public:
-  set<ExpressionRegulation*,CompilationElement_cmp> regulators;
+  GRNAdjacency<ExpressionRegulation*> regulators;
   FunctionalUnit* container;
   
   virtual bool isA(string c){ return (c=="DNAComponent")?true:CompilationElement::isA(c); }
@@ -75,15 +147,16 @@ class Chemical : public CompilationElement {
   double halflife; // in seconds; range is ~ 5 min - 1 day
   float hill_coefficient; // ~1-4
   
-  set<CodingSequence*,CompilationElement_cmp> producers;
-  set<ExpressionRegulation*,CompilationElement_cmp> consumers;
-  set<RegulatoryReaction*,CompilationElement_cmp> regulatedBy;
-  set<RegulatoryReaction*,CompilationElement_cmp> regulatorFor;
+  GRNAdjacency<CodingSequence*> producers;
+  GRNAdjacency<ExpressionRegulation*> consumers;
+  GRNAdjacency<RegulatoryReaction*> regulatedBy;
+  GRNAdjacency<RegulatoryReaction*> regulatorFor;
+  int grn_id; unsigned grn_generation; // dense ID, assigned by GRN
   
   Chemical(float hill=DEFAULT_HILL, float halflife=DEFAULT_HALFLIFE) 
-    { name=this->nicename(); hill_coefficient=hill; this->halflife=halflife; }
+    { name=this->nicename(); hill_coefficient=hill; this->halflife=halflife; grn_id=-1; grn_generation=0; }
   Chemical(string name,float hill=DEFAULT_HILL,float halflife=DEFAULT_HALFLIFE) 
-    { this->name=name; hill_coefficient=hill; this->halflife=halflife; }
+    { this->name=name; hill_coefficient=hill; this->halflife=halflife; grn_id=-1; grn_generation=0; }
   virtual ~Chemical() {
     if(!producers.empty() || !consumers.empty() || 
        !regulatedBy.empty() || !regulatorFor.empty())
@@ -205,13 +278,12 @@ class RegulatoryReaction : public CompilationElement {
 class FunctionalUnit : public DNAComponent {
 public:
   vector<DNAComponent*> sequence;
+  int grn_id; unsigned grn_generation; // dense ID, assigned by GRN
+  FunctionalUnit() { grn_id=-1; grn_generation=0; }
   void add(DNAComponent* b) { b->container=this; sequence.push_back(b); }
   void remove(DNAComponent* b) { // remove first instance of b in FU
-    bool found = false;
-    for(int i=0;i<sequence.size();i++) {
-      if(found) sequence[i-1] = sequence[i]; // shuffle back
-      if(sequence[i]==b) found=true;
-    }
+    vector<DNAComponent*>::iterator i = find(sequence.begin(),sequence.end(),b);
+    if(i!=sequence.end()) sequence.erase(i);
   }
   void print(ostream* out) { 
     for(int i=0;i<sequence.size();i++) 
@@ -232,9 +304,19 @@ class GRN { public: reflection_base(GRN);
   set<DNAComponent*,CompilationElement_cmp> dnacomponents; // generally a set of functional units
   set<RegulatoryReaction*,CompilationElement_cmp> reactions;
   map<string,Chemical*> chemicals;
-  // need to add lists of Chemicals
-  // also backpointers to allow network crawling
+  // dense IDs for chemicals and functional units, indexing the containers
+  // above: add them through add_chemical and add_functional_unit so these
+  // stay in step
+  GRNSlotMap<Chemical> chemical_ids;
+  GRNSlotMap<FunctionalUnit> functional_unit_ids;
 
+  void add_chemical(Chemical* c);
+  void add_functional_unit(FunctionalUnit* fu);
+  /// Free every element of the network and empty it, ready to be rebuilt
+  void clear();
+  /// Is the element still part of the network?  O(1), unlike a lookup
+  bool is_live(Chemical* c) { return chemical_ids.contains(c); }
+  bool is_live(FunctionalUnit* fu) { return functional_unit_ids.contains(fu); }
   void delete_functional_unit(FunctionalUnit* fu);
   void delete_chemical(Chemical* c);
   void replace_inputs(FunctionalUnit* target, FunctionalUnit* src, DNAComponent* src_cds=NULL,int verbosity=0);
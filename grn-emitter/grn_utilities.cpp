@@ -105,8 +105,8 @@ bool equivalent_promoters(Promoter* p1, Promoter* p2) {
 
 bool equivalent_regulation(DNAComponent* a, DNAComponent* b) {
   if(a->regulators.size() != b->regulators.size()) return false;
-  std::set<ExpressionRegulation*>::iterator ai = a->regulators.begin();
-  std::set<ExpressionRegulation*>::iterator bi = b->regulators.begin();
+  GRNAdjacency<ExpressionRegulation*>::iterator ai = a->regulators.begin();
+  GRNAdjacency<ExpressionRegulation*>::iterator bi = b->regulators.begin();
   for ( ; ai != a->regulators.end(); ++ai, ++bi) {
     if(!(*ai)->same_regulation(*bi)) return false;
   }
@@ -148,18 +148,21 @@ float force_promoter_rate(Promoter* p) {
   }
 }
 
-// Given a chemical and a SExpr that should specify type, 
-// convert SExpr to ProtoType (which does error checking internally)
-// Then make sure that the chemical is not already typed
-// with a conflicting type. 
-void convert_sexp_to_type(SExpr* type, Chemical* chem, OperatorInstance* oi) {
+// Convert a SExpr specifying a chemical's type in one of op's motifs
+// to ProtoType (which does error checking internally)
+ProtoType* sexp_to_chemical_type(SExpr* type, Operator* op) {
   ProtoType* pt = NULL;
   // Check if type is a reference
   if(type->isSymbol())
-    pt = oi->op->signature->parameter_type((SE_Symbol*)type,false);
+    pt = op->signature->parameter_type((SE_Symbol*)type,false);
   // If that fails, interpret as type
   if(pt==NULL) pt = ProtoInterpreter::sexp_to_type(type);
-  
+  return pt;
+}
+
+// Type a chemical, making sure that it is not already typed
+// with a conflicting type. 
+void assign_chemical_type(Chemical* chem, ProtoType* pt) {
   // need to check to see if this conflicts with the type we 
   // have for chemical c
   if (chem->attributes["type"] == NULL)
@@ -186,7 +189,7 @@ bool sole_regulator(ExpressionRegulation* er) {
   FunctionalUnit* fu = er->target->container;
   bool found = false;
   for(int i=0;i<fu->sequence.size();i++) { 
-    for_set(ExpressionRegulation*,fu->sequence[i]->regulators,er2) {
+    for_adj(ExpressionRegulation*,fu->sequence[i]->regulators,er2) {
       if(er->same_regulation(*er2)) { found = true;
       } else { return false;
       }
@@ -241,22 +244,22 @@ public:
 
     // Walk all neighbors to get new value
     int newvalue = oldvalue;
-    for_set(CodingSequence*,c->producers,i) {
+    for_adj(CodingSequence*,c->producers,i) {
       FunctionalUnit *fu = (*i)->container;
       if(fu->marked(TAG)) 
         newvalue = min(newvalue,1+((IntAttribute*)fu->attributes[TAG])->value);
     }
-    for_set(ExpressionRegulation*,c->consumers,i) {
+    for_adj(ExpressionRegulation*,c->consumers,i) {
       FunctionalUnit *fu = (*i)->target->container;
       if(fu->marked(TAG)) 
         newvalue = min(newvalue,1+((IntAttribute*)fu->attributes[TAG])->value);
     }
-    for_set(RegulatoryReaction*,c->regulatedBy,i) {
+    for_adj(RegulatoryReaction*,c->regulatedBy,i) {
       Chemical* c = (*i)->regulator;
       if(c->marked(TAG)) 
         newvalue = min(newvalue,1+((IntAttribute*)c->attributes[TAG])->value);
     }
-    for_set(RegulatoryReaction*,c->regulatorFor,i) {
+    for_adj(RegulatoryReaction*,c->regulatorFor,i) {
       Chemical* c = (*i)->substrate;
       if(c->marked(TAG)) 
         newvalue = min(newvalue,1+((IntAttribute*)c->attributes[TAG])->value);
@@ -279,7 +282,7 @@ public:
     int newvalue = oldvalue;
     for(int i=0;i<fu->sequence.size();i++) {
       DNAComponent* dc = fu->sequence[i];
-      for_set(ExpressionRegulation*,dc->regulators,er) {
+      for_adj(ExpressionRegulation*,dc->regulators,er) {
         Chemical* c = (*er)->signal;
         if(c->marked(TAG)) 
           newvalue = min(newvalue,1+((IntAttribute*)c->attributes[TAG])->value);
@@ -313,66 +316,81 @@ int estimate_diameter(GRN* net) {
  *****************************************************************************/
 
 bool GRNPropagator::propagate(GRN* net) {
+  seed(net);
+  return drain();
+}
+
+void GRNPropagator::seed(GRN* net) {
+  grn=net; is_seeded=true;
+  worklist_f.clear(); worklist_c.clear();
+  if(interests&ON_FUNCTIONAL_UNITS) worklist_f = net->dnacomponents;
+  if(interests&ON_CHEMICALS) {
+    map<string,Chemical*>::iterator i=net->chemicals.begin();
+    for( ;i!=net->chemicals.end();i++) worklist_c.insert((*i).second);
+  }
+}
+
+bool GRNPropagator::drain() {
   if(verbosity>=1) *cpout << "Executing GRN analyzer " << to_str() << endl;
-  any_changes=false; grn=net;
+  any_changes=false;
   
   // check for an empty network:
-  if (net->dnacomponents.empty() && net->chemicals.empty()) {
+  if (grn->dnacomponents.empty() && grn->chemicals.empty()) {
     compile_error("Optimization reduced the network to an empty network.  Does your program have sensors and actuators?"); 
     terminate_on_error();
   }
     
-  // initialize worklists
-  worklist_f.clear(); worklist_f = net->dnacomponents;
-  worklist_c.clear(); 
-  map<string,Chemical*>::iterator i=net->chemicals.begin();
-  for( ;i!=net->chemicals.end();i++) worklist_c.insert((*i).second);
   // walk through worklists until empty
   preprop();
-  int steps_remaining = loop_abort*(worklist_c.size()+worklist_f.size());
+  int steps_remaining = 
+    loop_abort*(grn->chemicals.size()+grn->dnacomponents.size());
   while(steps_remaining>0 && (!worklist_c.empty() || !worklist_f.empty())) {
     // each time through, try executing one from each worklist
     if(!worklist_c.empty()) {
       Chemical* c = *worklist_c.begin(); worklist_c.erase(c); 
-      if(grn->chemicals.count(c->name)) // ignore deleted
+      if(grn->is_live(c)) // ignore deleted
         { act(c); steps_remaining--; }
     }
     if(!worklist_f.empty()) {
       FunctionalUnit* f = (FunctionalUnit*)*worklist_f.begin(); worklist_f.erase(f); 
-      if(grn->dnacomponents.count(f)) // ignore deleted
+      if(grn->is_live(f)) // ignore deleted
         { act(f); steps_remaining--; }
     }
     V5<<grn->to_str();
   }
   if(steps_remaining<=0) ierror("A GRN analyzer aborted due to apparent infinite loop.");
-  postprop();
+  worklist_c.insert(revisit_c.begin(),revisit_c.end()); revisit_c.clear();
+  worklist_f.insert(revisit_f.begin(),revisit_f.end()); revisit_f.clear();
+  postprop(); is_seeded=false;
   if(verbosity>=3) *cpout << "Done executing GRN analyzer " << to_str() << endl;
   return any_changes;
 }
 
 enum { FU_MARK=1, C_MARK=2 };
-CompilationElement* bsrc;
-set<CompilationElement*,CompilationElement_cmp> bqueued;
 void GRNPropagator::queue_nbrs(Chemical* c, int marks) {
-  if(marks&C_MARK || bqueued.count(c)) return;   bqueued.insert(c);
-  if(c!=bsrc) { worklist_c.insert(c); marks |= C_MARK; }
+  if(marks&C_MARK || nbr_queued.count(c)) return;   nbr_queued.insert(c);
+  if(c!=nbr_src) { enqueue(c); marks |= C_MARK; }
+  else if(scheduler) // news to other rules now, and to this one next time
+    { scheduler->enqueue(c,this); revisit_c.insert(c); }
 
-  for_set(ExpressionRegulation*,c->consumers,ci)
+  for_adj(ExpressionRegulation*,c->consumers,ci)
     { queue_nbrs((*ci)->target->container,marks); }
-  for_set(CodingSequence*,c->producers,pi)
+  for_adj(CodingSequence*,c->producers,pi)
     { queue_nbrs((*pi)->container,marks); }
-  for_set(RegulatoryReaction*,c->regulatorFor,ri)
-    { worklist_c.insert((*ri)->substrate); }
-  for_set(RegulatoryReaction*,c->regulatedBy,ri)
-    { worklist_c.insert((*ri)->regulator); }
+  for_adj(RegulatoryReaction*,c->regulatorFor,ri)
+    { enqueue((*ri)->substrate); }
+  for_adj(RegulatoryReaction*,c->regulatedBy,ri)
+    { enqueue((*ri)->regulator); }
 }
 void GRNPropagator::queue_nbrs(FunctionalUnit* fu, int marks) {
-  if(marks&FU_MARK || bqueued.count(fu)) return;   bqueued.insert(fu);
-  if(fu!=bsrc) { worklist_f.insert(fu); marks |= FU_MARK; }
+  if(marks&FU_MARK || nbr_queued.count(fu)) return;   nbr_queued.insert(fu);
+  if(fu!=nbr_src) { enqueue(fu); marks |= FU_MARK; }
+  else if(scheduler) // news to other rules now, and to this one next time
+    { scheduler->enqueue(fu,this); revisit_f.insert(fu); }
 
   for(int i=0;i<fu->sequence.size();i++) {
     DNAComponent* dc = fu->sequence[i];
-    for_set(ExpressionRegulation*,dc->regulators,er) {
+    for_adj(ExpressionRegulation*,dc->regulators,er) {
       queue_nbrs((*er)->signal,marks);
     }
     if(dc->isA("CodingSequence")) {
@@ -381,9 +399,47 @@ void GRNPropagator::queue_nbrs(FunctionalUnit* fu, int marks) {
   }
 }
 
+void GRNPropagator::enqueue(Chemical* c) {
+  if(scheduler) scheduler->enqueue(c); else worklist_c.insert(c);
+}
+void GRNPropagator::enqueue(FunctionalUnit* fu) {
+  if(scheduler) scheduler->enqueue(fu); else worklist_f.insert(fu);
+}
+
 void GRNPropagator::note_change(Chemical* c) 
-{ bqueued.clear(); any_changes=true; bsrc=c; queue_nbrs(c); }
+{ nbr_queued.clear(); any_changes=true; nbr_src=c; queue_nbrs(c); }
 void GRNPropagator::note_change(FunctionalUnit* f) 
-{ bqueued.clear(); any_changes=true; bsrc=f; queue_nbrs(f); }
+{ nbr_queued.clear(); any_changes=true; nbr_src=f; queue_nbrs(f); }
+
+/*****************************************************************************
+ *  RULE SCHEDULER                                                           *
+ *****************************************************************************/
+
+GRNRuleScheduler::GRNRuleScheduler(vector<GRNPropagator*>& rules, GRN* net) {
+  this->rules = rules;
+  for(int i=0;i<rules.size();i++) 
+    { rules[i]->seed(net); rules[i]->scheduler=this; }
+}
+
+GRNRuleScheduler::~GRNRuleScheduler() {
+  for(int i=0;i<rules.size();i++) rules[i]->scheduler=NULL;
+}
+
+bool GRNRuleScheduler::pending() {
+  for(int i=0;i<rules.size();i++) if(rules[i]->pending()) return true;
+  return false;
+}
+
+void GRNRuleScheduler::enqueue(Chemical* c, GRNPropagator* except) {
+  for(int i=0;i<rules.size();i++)
+    if(rules[i]!=except && (rules[i]->interests&ON_CHEMICALS))
+      rules[i]->worklist_c.insert(c);
+}
+
+void GRNRuleScheduler::enqueue(FunctionalUnit* fu, GRNPropagator* except) {
+  for(int i=0;i<rules.size();i++)
+    if(rules[i]!=except && (rules[i]->interests&ON_FUNCTIONAL_UNITS))
+      rules[i]->worklist_f.insert(fu);
+}
 
 }
@@ -28,7 +28,8 @@ extern bool equivalent_regulation(DNAComponent* a, DNAComponent* b);
 extern string scalar_to_str(ProtoScalar* s);
 extern float force_promoter_rate(Promoter* p);
 
-extern void convert_sexp_to_type(SExpr* type, Chemical* chem, OperatorInstance* oi);
+extern ProtoType* sexp_to_chemical_type(SExpr* type, Operator* op);
+extern void assign_chemical_type(Chemical* chem, ProtoType* pt);
 
 extern ProtoType* get_chemical_type(Chemical* chem);
 
@@ -40,19 +41,32 @@ extern void delete_feature(DNAComponent* dc);
 extern int estimate_diameter(GRN* net);
 
 /***** Propagator for walking GRNs *****/
+class GRNRuleScheduler;
+
+// Kinds of element a propagator acts on
+enum { ON_CHEMICALS=1, ON_FUNCTIONAL_UNITS=2 };
+
 class GRNPropagator : public CompilationElement {
  public:
   // behavior variables
   int verbosity;
   int loop_abort; // # equivalent passes through worklist before assuming loop
+  int interests; // ON_CHEMICALS and/or ON_FUNCTIONAL_UNITS
   // propagation work variables
   set<Chemical*,CompilationElement_cmp> worklist_c;
   set<DNAComponent*,CompilationElement_cmp> worklist_f;
   bool any_changes;
+  bool is_seeded; // worklists hold the whole network, until drained
   GRN* grn;
+  GRNRuleScheduler* scheduler; // if set, changes are shared with its rules
   
-  GRNPropagator(int abort=10) { loop_abort=abort; verbosity = 0;}
+  GRNPropagator(int abort=10) { loop_abort=abort; verbosity = 0; 
+    interests=ON_CHEMICALS|ON_FUNCTIONAL_UNITS; scheduler=NULL;
+    is_seeded=false; }
   bool propagate(GRN* net); // fill worklist, then act until empty
+  void seed(GRN* net); // fill worklist with every element of interest
+  bool drain(); // act until worklist is empty
+  bool pending() { return !worklist_c.empty() || !worklist_f.empty(); }
   virtual void preprop() {} virtual void postprop() {} // hooks
   // action routines to be filled in by inheritors
   virtual void act(Chemical* c) {}
@@ -61,8 +75,32 @@ class GRNPropagator : public CompilationElement {
   void note_change(Chemical* c);
   void note_change(FunctionalUnit* fu);
  private:
+  // neighbor walk of the note_change in progress
+  CompilationElement* nbr_src;
+  set<CompilationElement*,CompilationElement_cmp> nbr_queued;
+  // elements this rule changed, to be revisited on its next drain
+  set<Chemical*,CompilationElement_cmp> revisit_c;
+  set<DNAComponent*,CompilationElement_cmp> revisit_f;
   void queue_nbrs(Chemical* c, int marks=0);
   void queue_nbrs(FunctionalUnit* c, int marks=0);
+  void enqueue(Chemical* c);
+  void enqueue(FunctionalUnit* fu);
+};
+
+/* Change-driven scheduling for a set of propagators: after one sweep of
+ the whole network, a rule is only run again on the elements near a
+ change, which are queued for every rule interested in their kind.  The
+ cost of reaching a fixed point thus follows the number of rewrites,
+ rather than (passes x network size x rules). */
+class GRNRuleScheduler {
+ public:
+  vector<GRNPropagator*> rules;
+  GRNRuleScheduler(vector<GRNPropagator*>& rules, GRN* net);
+  ~GRNRuleScheduler(); // releases the rules
+  bool pending(); // does any rule have queued work?
+  // queue an element for interested rules, other than the one given
+  void enqueue(Chemical* c, GRNPropagator* except=NULL);
+  void enqueue(FunctionalUnit* fu, GRNPropagator* except=NULL);
 };
 
 /***** Certify Backpointers *****/
@@ -77,6 +115,11 @@ class GRNCertifyBackpointers : public GRNPropagator {
   virtual void print(ostream* out=0) { *out << "CertifyBackpointers"; }
   void preprop() { bad=false; }
   void postprop() {
+    if(grn->chemical_ids.size()!=grn->chemicals.size() ||
+       grn->functional_unit_ids.size()!=grn->dnacomponents.size()) {
+      bad=true;
+      ierror("GRN data structure corrupted: dense IDs out of step with network");
+    }
     if(bad) {
       ierror("GRN data structure corrupted: backpointer certification failed");
     }
@@ -12,6 +12,7 @@ distribution's top directory. */
 GRNConstantEliminator::GRNConstantEliminator(GRNEmitter* parent, Args* args) {
   verbosity = args->extract_switch("--grn-constant-eliminator-verbosity") ? 
     args->pop_number() : parent->verbosity;
+  interests = ON_FUNCTIONAL_UNITS;
 }
 
 void GRNConstantEliminator::act(FunctionalUnit* fu) {
@@ -24,7 +25,7 @@ void GRNConstantEliminator::act(FunctionalUnit* fu) {
       }
     
     for(int i=0;i<fu->sequence.size();i++) {
-      for_set(ExpressionRegulation*,fu->sequence[i]->regulators,er) {
+      for_adj(ExpressionRegulation*,fu->sequence[i]->regulators,er) {
         ProtoType* ct = NULL;
         if((*er)->signal->attributes.count("type"))
           ct = ((ProtoTypeAttribute*)(*er)->signal->attributes["type"])->type;
@@ -47,7 +48,7 @@ void GRNConstantEliminator::act(FunctionalUnit* fu) {
   // Delete FUs with an always-high repressor
   { bool constant_repressor = false;
     for(int i=0;i<fu->sequence.size();i++)
-      for_set(ExpressionRegulation*,fu->sequence[i]->regulators,er) {
+      for_adj(ExpressionRegulation*,fu->sequence[i]->regulators,er) {
         ProtoType* pt = get_chemical_type((*er)->signal);
         if((*er)->repressor && is_constitutive_true(pt))
           constant_repressor = true;
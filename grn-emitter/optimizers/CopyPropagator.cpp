@@ -12,6 +12,7 @@ distribution's top directory. */
 GRNCopyPropagator::GRNCopyPropagator(GRNEmitter* parent, Args* args) {
   verbosity = args->extract_switch("--grn-copy-propagator-verbosity") ? 
     args->pop_number() : parent->verbosity;
+  interests = ON_CHEMICALS;
 }
 
 void GRNCopyPropagator::act(Chemical* c) {
@@ -50,7 +50,7 @@ void GRNDeadCodeEliminator::act(FunctionalUnit* fu) {
   for(int i=0;i<fu->sequence.size();i++) {
     // collect elements to delete
     set<ExpressionRegulation*> deletes;
-    for_set(ExpressionRegulation*,fu->sequence[i]->regulators,er) {
+    for_adj(ExpressionRegulation*,fu->sequence[i]->regulators,er) {
       if((*er)->signal->producers.size()==0 && // not producible
          !(*er)->signal->attributes.count(":motif-constant")) { // and not I/O
         if(verbosity>=2) *cpout<<"Eliminating unused regulatory region "<<(*er)->to_str()<<" in "<<fu->to_str()<<endl;
@@ -73,7 +73,7 @@ void GRNDeadCodeEliminator::act(FunctionalUnit* fu) {
   }
   // Delete constitutively low FUs with inputs that can't be produced
   for(int i=0;i<fu->sequence.size();i++) {
-    for_set(ExpressionRegulation*,fu->sequence[i]->regulators,er) {
+    for_adj(ExpressionRegulation*,fu->sequence[i]->regulators,er) {
       if((*er)->signal->producers.size() || // producible
          (*er)->signal->attributes.count(":motif-constant")) // or I/O
         input=true; // possible input
@@ -13,6 +13,7 @@ distribution's top directory. */
 DoubleNegativeEliminator::DoubleNegativeEliminator(GRNEmitter* parent, Args* args) {
   verbosity = args->extract_switch("--double-negative-verbosity") ? 
     args->pop_number() : parent->verbosity;
+  interests = ON_FUNCTIONAL_UNITS;
 }
 
 // one-one chemical relation returns producer CDS; else returns null.
@@ -20,7 +21,7 @@ CodingSequence* DoubleNegativeEliminator::isInverter(FunctionalUnit* fu, bool st
   // Find the input
   ExpressionRegulation* input=NULL;
   for(int i=0;i<fu->sequence.size();i++) {
-    for_set(ExpressionRegulation*,fu->sequence[i]->regulators,er) {
+    for_adj(ExpressionRegulation*,fu->sequence[i]->regulators,er) {
       if(input || !(*er)->repressor) return NULL; // multi-input or activator
       input=(*er);
     }
@@ -62,10 +63,10 @@ bool invertible_products(FunctionalUnit* fu) {
       // must not participate in any reactions
       if(!(c->regulatorFor.size()==0 && c->regulatedBy.size()==0)) return false;
       // nothing it regulates can also be regulated by anything else
-      for_set(ExpressionRegulation*,c->consumers,j) {
+      for_adj(ExpressionRegulation*,c->consumers,j) {
         FunctionalUnit* target_fu = (*j)->target->container;
         for(int k=0;k<target_fu->sequence.size();k++) {
-          for_set(ExpressionRegulation*,target_fu->sequence[k]->regulators,tr) {
+          for_adj(ExpressionRegulation*,target_fu->sequence[k]->regulators,tr) {
             if(*tr != *j) return false;
           }
         }
@@ -103,7 +104,7 @@ void DoubleNegativeEliminator::act(FunctionalUnit* fu) {
     for(int i=0;i<fu->sequence.size();i++) {
       if(fu->sequence[i]->isA("CodingSequence")) {
         CodingSequence* cds = (CodingSequence*)fu->sequence[i];
-        for_set(ExpressionRegulation*,cds->product->consumers,i) { 
+        for_adj(ExpressionRegulation*,cds->product->consumers,i) { 
           grn->invert_regulation((*i),verbosity);
           note_change((*i)->target->container);
         }
@@ -13,6 +13,7 @@ distribution's top directory. */
 DuplicateReactionConsolidator::DuplicateReactionConsolidator(GRNEmitter* parent, Args* args) {
   verbosity = args->extract_switch("--duplicate-reaction-consolidator-verbosity") ? 
     args->pop_number() : parent->verbosity;
+  interests = ON_CHEMICALS;
 }
 
 bool same_reaction(RegulatoryReaction* r1, RegulatoryReaction* r2) {
@@ -27,8 +28,8 @@ bool same_reaction(RegulatoryReaction* r1, RegulatoryReaction* r2) {
 void DuplicateReactionConsolidator::act(Chemical* c) {
   // look through the set of reactions, searching for identical reactions
   set<RegulatoryReaction*> to_delete;
-  for_set(RegulatoryReaction*,c->regulatedBy,i) {
-    for_set(RegulatoryReaction*,c->regulatedBy,j) {
+  for_adj(RegulatoryReaction*,c->regulatedBy,i) {
+    for_adj(RegulatoryReaction*,c->regulatedBy,j) {
       if(to_delete.count(*i)) continue; // only check each once
       if(*i==*j) continue; // ignore self
       if(same_reaction(*i,*j))
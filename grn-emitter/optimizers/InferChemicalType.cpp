@@ -16,6 +16,7 @@ distribution's top directory. */
 GRNInferChemicalType::GRNInferChemicalType(GRNEmitter* parent, Args* args) {
   verbosity = args->extract_switch("--grn-chemical-type-inference-verbosity") ? 
     args->pop_number() : parent->verbosity;
+  interests = ON_CHEMICALS;
 }
 void GRNInferChemicalType::act(Chemical* c) {
   if(!c->regulatedBy.empty()) return; // only handle simple TFs
@@ -29,7 +30,7 @@ void GRNInferChemicalType::act(Chemical* c) {
     
   // check if any producer is constitutive-high or all are constitutive-low
   bool not_const_low = false, const_high = false;
-  for_set(CodingSequence*,c->producers,i) {
+  for_adj(CodingSequence*,c->producers,i) {
     FunctionalUnit* fu = (*i)->container;
     bool high_promoter = false, low_promoter = false, regulated = false;
     for(int i=0;i<fu->sequence.size();i++) {
@@ -7,12 +7,14 @@ the terms of the GNU General Public License, with a linking exception,
 as described in the file LICENSE in the TASBE BioCompiler
 distribution's top directory. */
 
+#include <sstream>
 #include "grn_optimizers.h"
 
 // Merges functional units with same inputs and different outputs
 MergeDuplicateInputs::MergeDuplicateInputs(GRNEmitter* parent, Args* args) {
   verbosity = args->extract_switch("--merge-duplicate-inputs-verbosity") ? 
     args->pop_number() : parent->verbosity;
+  interests = ON_FUNCTIONAL_UNITS;
 }
   
 // For this purpose: must have some promoters & expression regulation
@@ -58,6 +60,71 @@ bool MergeDuplicateInputs::input_eqv(FunctionalUnit* a,FunctionalUnit* b) {
   //*cpout<<"  Inputs same"<<endl;
   return true;
 }
+
+// Sorted list of regulations on a component; equal for any two components
+// that are equivalent_regulation
+static void regulation_signature(DNAComponent* dc, ostream& out) {
+  vector<string> regs;
+  for_adj(ExpressionRegulation*,dc->regulators,er) {
+    ostringstream r;
+    r<<(*er)->signal->grn_id<<((*er)->repressor?"-":"+")
+     <<(*er)->strength<<"/"<<(*er)->dissociation;
+    regs.push_back(r.str());
+  }
+  sort(regs.begin(),regs.end());
+  out<<"{";
+  for(int i=0;i<regs.size();i++) out<<regs[i]<<";";
+  out<<"}";
+}
+
+// Summarizes the inputs that input_eqv compares: promoter positions and
+// regulations, and the shared regulation of the CDSs.  Any two FUs that are
+// input_eqv have the same signature; FUs that can never be merged get "".
+string MergeDuplicateInputs::input_signature(FunctionalUnit* fu) {
+  ostringstream sig;
+  bool any_promoter = false;
+  DNAComponent* first_cds = NULL;
+  for(int i=0;i<fu->sequence.size();i++) {
+    DNAComponent* dc = fu->sequence[i];
+    if(dc->isA("Promoter")) {
+      any_promoter = true;
+      sig<<"P"<<i; regulation_signature(dc,sig);
+    } else if(dc->isA("CodingSequence")) {
+      if(first_cds==NULL) first_cds = dc;
+      else if(!equivalent_regulation(first_cds,dc)) return "";
+    }
+  }
+  if(!any_promoter || first_cds==NULL) return "";
+  sig<<"C"; regulation_signature(first_cds,sig);
+  return sig.str();
+}
+
+// Move an FU to the bucket for its current signature
+void MergeDuplicateInputs::reindex(FunctionalUnit* fu) {
+  map<FunctionalUnit*,string>::iterator old = indexed_as.find(fu);
+  if(old!=indexed_as.end()) {
+    candidates[old->second].erase(fu);
+    if(candidates[old->second].empty()) candidates.erase(old->second);
+    indexed_as.erase(old);
+  }
+  if(!grn->dnacomponents.count(fu)) return; // deleted FUs leave the index
+  string sig = input_signature(fu);
+  if(sig.empty()) return;
+  candidates[sig].insert(fu);
+  indexed_as[fu] = sig;
+}
+
+// The index is built when the rule is seeded with the whole network, then
+// kept up to date: between drains, only the FUs queued for this rule (those
+// changed by other rules, and their neighbours) can have new signatures
+void MergeDuplicateInputs::preprop() {
+  if(is_seeded) {
+    candidates.clear(); indexed_as.clear();
+    for_set(DNAComponent*,grn->dnacomponents,i) reindex((FunctionalUnit*)*i);
+  } else {
+    for_set(DNAComponent*,worklist_f,i) reindex((FunctionalUnit*)*i);
+  }
+}
   
 void MergeDuplicateInputs::act(FunctionalUnit* fu) {
   vector<DNAComponent*>::iterator ip = fu->sequence.begin();
@@ -80,11 +147,16 @@ void MergeDuplicateInputs::act(FunctionalUnit* fu) {
   }
   
   V4<<"Checking for equivalence for: "<<fu->to_str()<<endl;
-  // walk rest of FUs, looking for matches
-  set<DNAComponent*>::iterator bi = grn->dnacomponents.begin();
-  for( ;bi!=grn->dnacomponents.end();bi++) {
-    if((*bi)==fu) continue; // can't merge with self
-    FunctionalUnit* f2 = (FunctionalUnit*)*bi;
+  reindex(fu);
+  map<FunctionalUnit*,string>::iterator sig = indexed_as.find(fu);
+  if(sig==indexed_as.end()) return; // nothing can share its inputs
+  // walk the other FUs with the same signature (in network order, since
+  // merging edits the bucket), confirming each match in full
+  set<FunctionalUnit*,CompilationElement_cmp>& bucket = candidates[sig->second];
+  vector<FunctionalUnit*> matches(bucket.begin(),bucket.end());
+  for(int m=0;m<matches.size();m++) {
+    FunctionalUnit* f2 = matches[m];
+    if(f2==fu) continue; // can't merge with self
     if(input_eqv(fu,f2)) {
       V3<<"Merging with equivalent functional unit: "<<f2->to_str()<<endl;
       for(int i=0;i<f2->sequence.size();i++) {
@@ -94,7 +166,7 @@ void MergeDuplicateInputs::act(FunctionalUnit* fu) {
             
           if (verbosity>=3) {
             *cpout<<"before chemical: "<<chem->name<<" with producers: ";
-            set<CodingSequence*>::iterator ci=chem->producers.begin();
+            GRNAdjacency<CodingSequence*>::iterator ci=chem->producers.begin();
             for( ;ci!=chem->producers.end();ci++) {
               (*ci)->print(cpout);
               *cpout<<" ";
@@ -122,7 +194,7 @@ void MergeDuplicateInputs::act(FunctionalUnit* fu) {
 
           if (verbosity>=3) {
             *cpout<<"after chemical: "<<chem->name<<" with producers: ";
-            set<CodingSequence*>::iterator ci=chem->producers.begin();
+            GRNAdjacency<CodingSequence*>::iterator ci=chem->producers.begin();
             for( ;ci!=chem->producers.end();ci++) {
               (*ci)->print(cpout);
               *cpout<<" ";
@@ -131,6 +203,8 @@ void MergeDuplicateInputs::act(FunctionalUnit* fu) {
           }
         }
       }
+      reindex(f2); // f2 has lost its CDSs
     }
   }
+  reindex(fu);
 }
@@ -17,6 +17,7 @@ distribution's top directory. */
 MultiProductEliminator::MultiProductEliminator(GRNEmitter* parent, Args* args) {
   verbosity = args->extract_switch("--multi-product-eliminator-verbosity") ? 
     args->pop_number() : parent->verbosity;
+  interests = ON_FUNCTIONAL_UNITS;
 }
 
 void MultiProductEliminator::act(FunctionalUnit* fu) {
@@ -43,7 +44,7 @@ void MultiProductEliminator::act(FunctionalUnit* fu) {
     for(int j=0;j<suffix_size;j++) // add suffix
       newfu->add(fu->sequence[prefix_size+pcs_count+j]->clone());
     V3 << "Adding Functional Unit " << ce2s(newfu) << endl;
-    grn->dnacomponents.insert(newfu);
+    grn->add_functional_unit(newfu);
     note_change(newfu);
   }
   V3 << "Deleting Functional Unit " << ce2s(fu) << endl;
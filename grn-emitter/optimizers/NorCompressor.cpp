@@ -13,12 +13,13 @@ distribution's top directory. */
 NorCompressor::NorCompressor(GRNEmitter* parent, Args* args) {
   verbosity = args->extract_switch("--nor-compressor-verbosity") ? 
     args->pop_number() : parent->verbosity;
+  interests = ON_CHEMICALS;
 }
 
 Chemical* NorCompressor::is_Or(FunctionalUnit* fu) {
   Chemical* input = NULL;
   for(int i=0;i<fu->sequence.size();i++) { 
-    for_set(ExpressionRegulation*,fu->sequence[i]->regulators,er) {
+    for_adj(ExpressionRegulation*,fu->sequence[i]->regulators,er) {
       if(input!=NULL) return NULL; // can only be one region
       // Make sure it's a live, non-reaction boolean activator 
       if((*er)->signal->producers.size()==0
@@ -42,7 +43,9 @@ void NorCompressor::act(Chemical* c) {
   V2<<"Compressing NOR on chemical "<<c->to_str()<<endl;
   // If so, then replace old producer with producers at OR inputs
   CodingSequence* oldpcs = *c->producers.begin();
-  for_set(CodingSequence*,or_input->producers,i) {
+  // cloning adds to c's producers, so walk a copy in case c is or_input
+  GRNAdjacency<CodingSequence*> or_producers = or_input->producers;
+  for_adj(CodingSequence*,or_producers,i) {
     FunctionalUnit* fu = (*i)->container;
     vector<DNAComponent*>::iterator ip = fu->sequence.begin();
     for( ; ip!=fu->sequence.end(); ip++) {
@@ -13,6 +13,7 @@ distribution's top directory. */
 OutputConsolidator::OutputConsolidator(GRNEmitter* parent, Args* args) {
   verbosity = args->extract_switch("--output-consolidator-verbosity") ? 
     args->pop_number() : parent->verbosity;
+  interests = ON_FUNCTIONAL_UNITS;
 }
 
 void OutputConsolidator::act(FunctionalUnit* fu) {
@@ -31,9 +32,9 @@ void OutputConsolidator::act(FunctionalUnit* fu) {
         if(ss==NULL) { ss=pcs;
         } else { // TODO: make this check for repressor/inducer match
           V2<<"Merging "<<pcs->product->to_str()<<" into "<<ss->product->to_str()<<endl;
-          set<ExpressionRegulation*,CompilationElement_cmp> 
+          GRNAdjacency<ExpressionRegulation*>
             deletesafe_consumers = pcs->product->consumers;
-          for_set(ExpressionRegulation*,deletesafe_consumers,ri) {
+          for_adj(ExpressionRegulation*,deletesafe_consumers,ri) {
             V3<<"Moving consumer "<<(*ri)->to_str()<<" from signal "<<(*ri)->signal->to_str()<<" to "<<ss->product->to_str()<<endl;
             FunctionalUnit* fu2 = (*ri)->target->container;
             (*ri)->signal = ss->product;
@@ -41,7 +42,7 @@ void OutputConsolidator::act(FunctionalUnit* fu) {
             V4<<"Checking consumer FU for duplicates: "<<fu2->to_str()<<endl;
             bool duplicate = false;
             for(int j=0;j<fu2->sequence.size();j++) {
-              for_set(ExpressionRegulation*,fu2->sequence[j]->regulators,ri2) {
+              for_adj(ExpressionRegulation*,fu2->sequence[j]->regulators,ri2) {
                 if((*ri!=*ri2) && (*ri)->same_regulation(*ri2)) {
                   if (verbosity>=4) {(*ri)->print(cpout); *cpout<<" is a duplicate rr"<<endl;}
                   duplicate = true; // ignore the duplicate region
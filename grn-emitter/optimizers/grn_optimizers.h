@@ -58,7 +58,15 @@ public:
   MergeDuplicateInputs(GRNEmitter* parent, Args* args);
   virtual void print(ostream* out=0) { *out << "MergeDuplicateInputs"; }
   bool input_eqv(FunctionalUnit* a,FunctionalUnit* b);
+  void preprop();
   void act(FunctionalUnit* fu);
+ private:
+  // Candidate index: FUs bucketed by input_signature, so that only FUs
+  // that might be input_eqv are ever compared; kept from drain to drain
+  map<string,set<FunctionalUnit*,CompilationElement_cmp> > candidates;
+  map<FunctionalUnit*,string> indexed_as; // current bucket of each FU
+  string input_signature(FunctionalUnit* fu);
+  void reindex(FunctionalUnit* fu);
 };
 
 class MultiProductEliminator : public GRNPropagator {
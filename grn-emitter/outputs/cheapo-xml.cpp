@@ -12,3 +12,22 @@ distribution's top directory. */
 void XMLitem::addComment(string comment) { addElt(new XMLcomment(comment)); }
 void XMLitem::addBreak(int n) { addElt(new XMLbreak(n)); }
 
+
+// Replacement text for characters that can't appear literally in XML
+// content, or NULL for those that can
+static const char** xml_escapes() {
+  static const char* table[256] = {NULL};
+  if(table['&']==NULL) {
+    table['&'] = "&amp;"; table['<'] = "&lt;"; table['>'] = "&gt;";
+    table['"'] = "&quot;";
+  }
+  return table;
+}
+
+void XMLStream::escape(const string& s) {
+  const char** table = xml_escapes();
+  for(int i=0;i<s.size();i++) {
+    const char* e = table[(unsigned char)s[i]];
+    if(e) buf+=e; else buf+=s[i];
+  }
+}
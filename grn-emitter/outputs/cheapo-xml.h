@@ -109,4 +109,36 @@ struct TrivialItem : public XMLitem {
   }
 };
 
+/*************** STREAMING WRITER ***************/
+// Writes XML as a series of open/attribute/close events into one buffer,
+// with no intermediate tree, laid out exactly as XMLitem::emit lays out
+// the equivalent tree.  Attributes must be given in sorted order, as
+// XMLitem's attribute map would produce them.
+class XMLStream {
+ public:
+  XMLStream() { depth = pp_indent().size(); buf.reserve(1<<16); }
+  // start tag: "<name", to be followed by attributes then children() or
+  // empty()
+  void open(const char* name) { indent(); buf+='<'; buf+=name; }
+  void attribute(const char* name, const string& value)
+    { buf+=' '; buf+=name; buf+="=\""; escape(value); buf+='"'; }
+  void children() { buf+=">\n"; depth+=2; }
+  void empty() { buf+="/>\n"; }
+  void close(const char* name)
+    { depth-=2; indent(); buf+="</"; buf+=name; buf+=">\n"; }
+  void element(const char* name, const string& contents) // TrivialItem
+    { indent(); buf+='<'; buf+=name; buf+='>'; escape(contents);
+      buf+="</"; buf+=name; buf+=">\n"; }
+  void comment(const string& contents)
+    { indent(); buf+="<!-- "; buf+=contents; buf+=" -->\n"; }
+  void blank() { indent(); buf+='\n'; }
+  void raw(const string& s) { buf+=s; }
+  void write(ostream* out) { out->write(buf.data(),buf.size()); *out<<flush; }
+ private:
+  string buf;
+  int depth;
+  void indent() { buf.append(depth,' '); }
+  void escape(const string& s);
+};
+
 #endif // __CHEAPO_XML__
@@ -0,0 +1,676 @@
+/* Native GRN simulation
+Copyright (C) 2009-2011, Raytheon BBN Technologies and contributors listed
+in the AUTHORS file in TASBE BioCompiler distribution's top directory.
+
+This file is part of the TASBE BioCompiler, and is distributed under
+the terms of the GNU General Public License, with a linking exception,
+as described in the file LICENSE in the TASBE BioCompiler
+distribution's top directory. */
+
+// Simulate an abstract GRN, producing the same CSV files as the Matlab
+// _sim.m script without leaving the compiler
+#include <float.h>
+#include <math.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include "biocompiler.h"
+#include "grn_utilities.h"
+#include "simulator.h"
+
+using namespace grn;
+
+/*****************************************************************************
+ *  MODEL COMPILATION                                                        *
+ *****************************************************************************/
+
+bool is_motif_constant(Chemical* c) {
+  return c->attributes.count(":motif-constant") &&
+    c->attributes[":motif-constant"]!=NULL;
+}
+
+// Species index of a chemical, through the dense-ID table built from the
+// network's chemicals; a chemical never added to the network has none
+static int species(const vector<int>& by_id, Chemical* c) {
+  int id = c->grn_id;
+  if(id<0 || id>=by_id.size() || by_id[id]<0)
+    ierror("Chemical "+c->name+" is not registered with the GRN");
+  return by_id[id];
+}
+
+int GRNModel::add_parameter(double value, GRNParameterClass c, int sense) {
+  nominal.push_back(value); parameter_class.push_back(c);
+  this->sense.push_back(sense);
+  return nominal.size()-1;
+}
+
+GRNModel::GRNModel(GRN* net) {
+  vector<int> by_id(net->chemical_ids.capacity(),-1); // dense ID -> species index
+  map<string,Chemical*>::iterator i=net->chemicals.begin();
+  for(;i!=net->chemicals.end();i++) {
+    Chemical* c = (*i).second;
+    if(!net->is_live(c))
+      ierror("Chemical "+c->name+" is not registered with the GRN");
+    by_id[c->grn_id] = names.size();
+    names.push_back(sanitized_name(c->name));
+    effective_by.push_back(-1);
+  }
+  P_hill = nominal.size();
+  for(i=net->chemicals.begin();i!=net->chemicals.end();i++)
+    add_parameter((*i).second->hill_coefficient,HILL,1);
+  P_decay = nominal.size();
+  for(i=net->chemicals.begin();i!=net->chemicals.end();i++)
+    add_parameter(log(2.0)/(*i).second->halflife,HALFLIFE,-1);
+
+  vector<double> reg_K, reg_D, prod_rate;
+  vector<char> reg_repressor;
+  for_set(DNAComponent*,net->dnacomponents,i) {
+    FunctionalUnit* f = (FunctionalUnit*)(*i);
+    double rate = 0; int reg_begin = reg_signal.size();
+    for(int j=0;j<f->sequence.size();j++) {
+      DNAComponent* dc = f->sequence[j];
+      // a promoter starts a new transcript; regulations accumulate along it
+      if(dc->isA("Promoter")) {
+        rate = force_promoter_rate((Promoter*)dc); reg_begin = reg_signal.size();
+      }
+      for_adj(ExpressionRegulation*,dc->regulators,er) {
+        reg_signal.push_back(species(by_id,(*er)->signal));
+        reg_repressor.push_back((*er)->repressor);
+        reg_K.push_back((*er)->repressor ? 1/(*er)->strength : (*er)->strength);
+        reg_D.push_back((*er)->dissociation);
+      }
+      if(dc->isA("Promoter")) {
+        // already handled
+      } else if(dc->isA("CodingSequence")) {
+        prod_target.push_back(species(by_id,((CodingSequence*)dc)->product));
+        prod_rate.push_back(rate);
+        prod_reg_begin.push_back(reg_begin);
+        prod_reg_end.push_back(reg_signal.size());
+      } else if(dc->isA("Terminator")) { // ignore
+      } else {
+        ierror("Don't know how to simulate: "+dc->to_str());
+      }
+    }
+  }
+
+  for_set(RegulatoryReaction*,net->reactions,ri) {
+    if((*ri)->substrate->regulatedBy.size()>1)
+      compile_warn("Multiply regulated chemicals are not currently modeled in simulation: model will be incorrect");
+    int s = species(by_id,(*ri)->substrate);
+    effective_by[s] = rxn_substrate.size(); // as in Matlab, the last one wins
+    rxn_regulator.push_back(species(by_id,(*ri)->regulator)); rxn_substrate.push_back(s);
+    rxn_repressor.push_back((*ri)->repressor);
+  }
+  // Reactions use a fixed K=1, as in the Matlab model
+  P_rxn_K = nominal.size();
+  for(int r=0;r<rxn_substrate.size();r++) add_parameter(1.0,FIXED,0);
+  P_rxn_D = nominal.size();
+  for(int r=0;r<rxn_substrate.size();r++)
+    add_parameter(DEFAULT_DISSOCIATION,DISSOCIATION,1);
+  P_reg_K = nominal.size();
+  for(int k=0;k<reg_K.size();k++)
+    add_parameter(reg_K[k],STRENGTH,reg_repressor[k]?-1:1);
+  P_reg_D = nominal.size();
+  for(int k=0;k<reg_D.size();k++) add_parameter(reg_D[k],DISSOCIATION,1);
+  P_rate = nominal.size();
+  for(int p=0;p<prod_rate.size();p++) add_parameter(prod_rate[p],RATE,1);
+
+  // Assume motif-constant chemicals are the ones of interest
+  for(i=net->chemicals.begin();i!=net->chemicals.end();i++) {
+    Chemical* c = (*i).second;
+    if(!is_motif_constant(c)) continue;
+    if(c->consumers.size()==0 && c->regulatorFor.size()==0)
+      outputs.push_back(species(by_id,c));
+    if(c->producers.size()==0) inputs.push_back(species(by_id,c));
+  }
+}
+
+// Hill occupancy term (C/D)^H; concentrations slightly below zero from
+// integration error are treated as absent
+static inline double occupancy(double C, double D, double H) {
+  return (C>0) ? pow(C/D,H) : 0;
+}
+
+void GRNModel::derivatives(const double* y, const double* levels,
+                           const double* P, double* dy, double* eff,
+                           int lanes, int stride) const {
+  #define PARAM(offset,i) (P+((offset)+(i))*stride)
+  int n = size();
+  for(int i=0;i<n;i++) {
+    const double *yi = y+i*stride, *decay = PARAM(P_decay,i);
+    double *ei = eff+i*stride, *di = dy+i*stride;
+    for(int l=0;l<lanes;l++) { ei[l] = yi[l]; di[l] = -decay[l]*yi[l]; }
+  }
+  for(int r=0;r<rxn_substrate.size();r++) {
+    int s = rxn_substrate[r], g = rxn_regulator[r];
+    if(effective_by[s]!=r) continue;
+    const double *ys = y+s*stride, *yg = y+g*stride, *H = PARAM(P_hill,g),
+      *K = PARAM(P_rxn_K,r), *D = PARAM(P_rxn_D,r);
+    double* es = eff+s*stride;
+    for(int l=0;l<lanes;l++) {
+      double free = 1/(1+occupancy(yg[l],D[l],H[l]));
+      es[l] = ys[l]*K[l]*(rxn_repressor[r] ? free : 1-free);
+    }
+  }
+  double* rate = eff+n*stride;
+  for(int p=0;p<prod_target.size();p++) {
+    const double* R = PARAM(P_rate,p);
+    for(int l=0;l<lanes;l++) rate[l] = R[l];
+    for(int k=prod_reg_begin[p];k<prod_reg_end[p];k++) {
+      int c = reg_signal[k];
+      const double *ec = eff+c*stride, *H = PARAM(P_hill,c),
+        *K = PARAM(P_reg_K,k), *D = PARAM(P_reg_D,k);
+      for(int l=0;l<lanes;l++) {
+        double x = occupancy(ec[l],D[l],H[l]);
+        rate[l] *= (1+K[l]*x)/(1+x);
+      }
+    }
+    double* dt = dy+prod_target[p]*stride;
+    for(int l=0;l<lanes;l++) dt[l] += rate[l];
+  }
+  for(int k=0;k<inputs.size();k++) {
+    const double *yi = y+inputs[k]*stride, *lk = levels+k*stride;
+    double* di = dy+inputs[k]*stride;
+    for(int l=0;l<lanes;l++) di[l] += 0.01*((1+499*lk[l])-yi[l]);
+  }
+  #undef PARAM
+}
+
+/*****************************************************************************
+ *  STIFF SOLVER                                                             *
+ *****************************************************************************/
+
+StiffSolver::StiffSolver(const GRNModel* model, int lanes, double rtol,
+                         double atol) {
+  this->model = model; n = model->size();
+  this->lanes = stride = lanes; this->rtol = rtol; this->atol = atol;
+  t = h = 0; steps = rejections = evaluations = 0;
+  int N = n*stride;
+  y.resize(N); dy.resize(N); levels.resize(model->inputs.size()*stride);
+  for(int l=0;l<lanes;l++) row.push_back(l);
+  params.resize(model->n_parameters()*stride);
+  for(int j=0;j<model->n_parameters();j++)
+    for(int l=0;l<lanes;l++) params[j*stride+l] = model->nominal[j];
+  J.resize(n*N); W.resize(n*N); pivot.resize(N);
+  F1.resize(N); F2.resize(N); k1.resize(N); k2.resize(N); k3.resize(N);
+  ynew.resize(N); eff.resize(N+stride); tmp.resize(N); scale.resize(stride);
+}
+
+void StiffSolver::f(const double* y, double* dy) {
+  model->derivatives(y,&levels[0],&params[0],dy,&eff[0],lanes,stride);
+  evaluations++;
+}
+
+// Forward-difference Jacobian around y, whose derivative is already in dy;
+// column j is perturbed in every lane at once
+void StiffSolver::jacobian() {
+  double threshold = atol/rtol;
+  ynew = y;
+  for(int j=0;j<n;j++) {
+    double *yj = &y[j*stride], *pj = &ynew[j*stride];
+    for(int l=0;l<lanes;l++) {
+      scale[l] = sqrt(DBL_EPSILON)*max(fabs(yj[l]),threshold);
+      pj[l] = yj[l]+scale[l];
+    }
+    f(&ynew[0],&tmp[0]);
+    for(int i=0;i<n;i++) {
+      double *Jij = &J[(i*n+j)*stride], *ti = &tmp[i*stride], *di = &dy[i*stride];
+      for(int l=0;l<lanes;l++) Jij[l] = (ti[l]-di[l])/scale[l];
+    }
+    for(int l=0;l<lanes;l++) pj[l] = yj[l];
+  }
+}
+
+// element (i,j) of lane l's matrix
+#define Wx(i,j,l) W[((i)*n+(j))*stride+(l)]
+
+// LU-factor W = I - hd*J in place for each lane, with partial pivoting
+bool StiffSolver::factor(double hd) {
+  for(int i=0;i<n;i++) for(int j=0;j<n;j++) {
+    double *Wij = &W[(i*n+j)*stride], *Jij = &J[(i*n+j)*stride];
+    for(int l=0;l<lanes;l++) Wij[l] = (i==j) - hd*Jij[l];
+  }
+  for(int k=0;k<n;k++) {
+    for(int l=0;l<lanes;l++) {
+      int p = k;
+      for(int i=k+1;i<n;i++) if(fabs(Wx(i,k,l))>fabs(Wx(p,k,l))) p=i;
+      if(Wx(p,k,l)==0) return false;
+      pivot[k*stride+l] = p;
+      if(p!=k) for(int j=0;j<n;j++) swap(Wx(k,j,l),Wx(p,j,l));
+    }
+    for(int i=k+1;i<n;i++) {
+      double *Wik = &Wx(i,k,0), *Wkk = &Wx(k,k,0);
+      for(int l=0;l<lanes;l++) Wik[l] /= Wkk[l];
+      for(int j=k+1;j<n;j++) {
+        double *Wij = &Wx(i,j,0), *Wkj = &Wx(k,j,0);
+        for(int l=0;l<lanes;l++) Wij[l] -= Wik[l]*Wkj[l];
+      }
+    }
+  }
+  return true;
+}
+
+void StiffSolver::solve(double* b) {
+  // rows of L were swapped along with U, so permute b all at once first
+  for(int k=0;k<n;k++) for(int l=0;l<lanes;l++) {
+    int p = pivot[k*stride+l];
+    if(p!=k) swap(b[k*stride+l],b[p*stride+l]);
+  }
+  for(int k=0;k<n;k++) for(int i=k+1;i<n;i++) {
+    double *bi = b+i*stride, *bk = b+k*stride, *Wik = &Wx(i,k,0);
+    for(int l=0;l<lanes;l++) bi[l] -= Wik[l]*bk[l];
+  }
+  for(int k=n-1;k>=0;k--) {
+    double* bk = b+k*stride;
+    for(int j=k+1;j<n;j++) {
+      double *bj = b+j*stride, *Wkj = &Wx(k,j,0);
+      for(int l=0;l<lanes;l++) bk[l] -= Wkj[l]*bj[l];
+    }
+    double* Wkk = &Wx(k,k,0);
+    for(int l=0;l<lanes;l++) bk[l] /= Wkk[l];
+  }
+}
+#undef Wx
+
+void StiffSolver::start(double t0) {
+  t = t0; f(&y[0],&dy[0]);
+  if(h<=0) { // initial step: limit the first change to about rtol^(1/3)
+    double threshold = atol/rtol, rh = 0;
+    for(int i=0;i<n;i++) for(int l=0;l<lanes;l++) {
+      int x = i*stride+l; rh = max(rh,fabs(dy[x])/max(fabs(y[x]),threshold));
+    }
+    rh /= 0.8*pow(rtol,1.0/3);
+    h = (rh>0) ? 1/rh : HUGE_VAL;
+  }
+}
+
+// Follows Shampine & Reichelt, "The MATLAB ODE Suite" (1997).  Inputs
+// only change between calls to start(), so there is no df/dt term.  The
+// lanes share a step size, controlled by the worst lane's error.
+bool StiffSolver::step(double t_end, double max_step) {
+  const double d = 1/(2+sqrt(2.0)), e32 = 6+sqrt(2.0);
+  double threshold = atol/rtol, hmin = 16*DBL_EPSILON*fabs(t);
+  int N = n*stride;
+  jacobian();
+  while(true) { // try steps until one meets tolerance
+    double hs = min(min(h,max_step),t_end-t);
+    bool last = (hs==t_end-t);
+    if(!factor(hs*d)) return false;
+    k1 = dy; solve(&k1[0]);
+    for(int x=0;x<N;x++) tmp[x] = y[x]+0.5*hs*k1[x];
+    f(&tmp[0],&F1[0]);
+    for(int x=0;x<N;x++) k2[x] = F1[x]-k1[x];
+    solve(&k2[0]);
+    for(int x=0;x<N;x++) { k2[x] += k1[x]; ynew[x] = y[x]+hs*k2[x]; }
+    f(&ynew[0],&F2[0]);
+    for(int x=0;x<N;x++) k3[x] = F2[x]-e32*(k2[x]-F1[x])-2*(k1[x]-dy[x]);
+    solve(&k3[0]);
+    double err = 0;
+    for(int i=0;i<n;i++) for(int l=0;l<lanes;l++) {
+      int x = i*stride+l;
+      double sc = max(max(fabs(y[x]),fabs(ynew[x])),threshold);
+      err = max(err,fabs(k1[x]-2*k2[x]+k3[x])/sc);
+    }
+    err *= hs/6;
+    if(err>rtol) {
+      rejections++;
+      if(hs<=hmin) return false;
+      h = max(hmin,hs*max(0.5,0.8*pow(rtol/err,1.0/3)));
+      continue;
+    }
+    // accept, and grow the step by up to a factor of five
+    steps++; t = last ? t_end : t+hs;
+    y.swap(ynew); dy.swap(F2);
+    double grow = 1.25*pow(err/rtol,1.0/3);
+    if(!last || hs>=h) h = (grow>0.2) ? hs/grow : 5*hs;
+    return true;
+  }
+}
+
+bool StiffSolver::integrate(double t1, double max_step) {
+  while(t<t1) if(!step(t1,max_step)) return false;
+  return true;
+}
+
+void StiffSolver::retire(int lane) {
+  int last = --lanes;
+  if(lane==last) return;
+  for(int i=0;i<n;i++) {
+    y[i*stride+lane] = y[i*stride+last]; dy[i*stride+lane] = dy[i*stride+last];
+  }
+  for(int k=0;k<model->inputs.size();k++)
+    levels[k*stride+lane] = levels[k*stride+last];
+  for(int j=0;j<model->n_parameters();j++)
+    params[j*stride+lane] = params[j*stride+last];
+  row[lane] = row[last];
+}
+
+/*****************************************************************************
+ *  BINARY INPUT EXPERIMENT                                                  *
+ *****************************************************************************/
+
+GRNSimulation::GRNSimulation(GRN* net) : model(net) {
+  int layers = 1+estimate_diameter(net);
+  stage_length = DEFAULT_LAYERTIME*layers; time_step = 1e3;
+  n_stages = 1<<model.inputs.size();
+  steps = evaluations = 0;
+}
+
+bool GRNSimulation::run() {
+  int n = model.size(), per_stage = (int)(stage_length/time_step);
+  StiffSolver solver(&model);
+  times.clear(); trajectory.clear(); truth.clear();
+  times.push_back(0);
+  trajectory.insert(trajectory.end(),solver.y.begin(),solver.y.end());
+  for(int s=0;s<n_stages;s++) {
+    for(int k=0;k<model.inputs.size();k++) solver.levels[k] = input_level(s,k);
+    solver.start(s*per_stage*time_step);
+    for(int j=1;j<=per_stage;j++) {
+      double t = (s*per_stage+j)*time_step;
+      if(!solver.integrate(t,time_step)) {
+        compile_error("GRN simulation failed at time "+f2s(solver.t));
+        return false;
+      }
+      times.push_back(t);
+      trajectory.insert(trajectory.end(),solver.y.begin(),solver.y.end());
+    }
+    // Matlab's phase_ends index lands two samples before the stage ends
+    int sample = max(0,(s+1)*per_stage-2);
+    for(int k=0;k<model.outputs.size();k++)
+      truth.push_back(trajectory[sample*n+model.outputs[k]]>1e2);
+  }
+  steps = solver.steps; evaluations = solver.evaluations;
+  return true;
+}
+
+void GRNSimulation::print_timeseries(ostream* out) {
+  int n = model.size();
+  *out<<"Time";
+  for(int i=0;i<n;i++) *out<<","<<model.names[i];
+  *out<<"\n";
+  char buf[32];
+  for(int j=0;j<times.size();j++) {
+    snprintf(buf,sizeof buf,"%.2f",times[j]); *out<<buf;
+    for(int i=0;i<n;i++)
+      { snprintf(buf,sizeof buf,",%.2f",trajectory[j*n+i]); *out<<buf; }
+    *out<<"\n";
+  }
+}
+
+void GRNSimulation::print_truth_table(ostream* out) {
+  bool first = true;
+  for(int i=0;i<model.inputs.size();i++)
+    { *out<<(first?"":",")<<model.names[model.inputs[i]]; first=false; }
+  for(int i=0;i<model.outputs.size();i++)
+    { *out<<(first?"":",")<<model.names[model.outputs[i]]; first=false; }
+  if(first) *out<<"No input or output variables";
+  *out<<"\n";
+  int n_out = model.outputs.size();
+  for(int s=0;s<n_stages;s++) {
+    first = true;
+    for(int i=0;i<model.inputs.size();i++)
+      { *out<<(first?"":",")<<input_level(s,i); first=false; }
+    for(int i=0;i<n_out;i++)
+      { *out<<(first?"":",")<<(int)truth[s*n_out+i]; first=false; }
+    *out<<"\n";
+  }
+}
+
+/*****************************************************************************
+ *  STEADY-STATE TRUTH TABLE                                                 *
+ *****************************************************************************/
+
+SteadyStateTable::SteadyStateTable(GRN* net, int threads) : model(net) {
+  int layers = 1+estimate_diameter(net);
+  n_rows = 1<<model.inputs.size();
+  // a signal needs at least a layer time to cross each layer; beyond
+  // several times the sequential experiment's stage, give up
+  min_time = DEFAULT_LAYERTIME; max_time = 4*DEFAULT_LAYERTIME*layers;
+  steady_rate = 1e-6;
+  // narrow enough to give threads rows to share, wide enough to vectorize
+  batch_lanes = 8; this->threads = max(1,threads);
+  steps = evaluations = 0;
+}
+
+bool SteadyStateTable::settled(StiffSolver* solver, int lane) {
+  if(solver->t<min_time) return false;
+  for(int i=0;i<model.size();i++) {
+    int x = i*solver->stride+lane;
+    if(fabs(solver->dy[x]) >= steady_rate*max(fabs(solver->y[x]),1.0))
+      return false;
+  }
+  return true;
+}
+
+void SteadyStateTable::record(StiffSolver* solver, int lane, double when) {
+  int r = solver->row[lane], n_out = model.outputs.size();
+  for(int k=0;k<n_out;k++)
+    level[r*n_out+k] = solver->y[model.outputs[k]*solver->stride+lane];
+  settle_time[r] = when;
+}
+
+void SteadyStateTable::prepare(StiffSolver* solver) {
+  for(int k=0;k<model.inputs.size();k++)
+    for(int l=0;l<solver->lanes;l++)
+      solver->levels[k*solver->stride+l] = input_level(solver->row[l]%n_rows,k);
+}
+
+int SteadyStateTable::settle(StiffSolver* solver) {
+  solver->start(0);
+  while(solver->lanes>0 && solver->t<max_time) {
+    if(!solver->step(max_time,DEFAULT_LAYERTIME/10)) return -1;
+    for(int l=solver->lanes-1;l>=0;l--) // retiring moves the last lane down
+      if(settled(solver,l)) { record(solver,l,solver->t); solver->retire(l); }
+  }
+  int unsettled = solver->lanes;
+  for(int l=0;l<unsettled;l++) record(solver,l,-1);
+  return unsettled;
+}
+
+// Several tables may be settling at once (design-space exploration settles
+// one per variant), so they report to the compiler one at a time
+static pthread_mutex_t report_lock = PTHREAD_MUTEX_INITIALIZER;
+
+// Batches waiting to be settled, and the totals of those already settled
+struct SettleQueue {
+  SteadyStateTable* table;
+  int n_lanes, per_batch, next; // next batch starts at lane next
+  int steps, evaluations, unsettled;
+  double failed_at; // time an integration failed, or -1
+  pthread_mutex_t lock;
+};
+
+void* SteadyStateTable::settle_worker(void* arg) {
+  SettleQueue* q = (SettleQueue*)arg;
+  SteadyStateTable* table = q->table;
+  while(true) {
+    pthread_mutex_lock(&q->lock);
+    int first = q->next, count = min(q->per_batch,q->n_lanes-first);
+    bool done = (count<=0 || q->failed_at>=0);
+    if(!done) q->next += count;
+    pthread_mutex_unlock(&q->lock);
+    if(done) return NULL;
+
+    StiffSolver solver(&table->model,count);
+    for(int l=0;l<count;l++) solver.row[l] = first+l;
+    table->prepare(&solver);
+    int unsettled = table->settle(&solver);
+
+    pthread_mutex_lock(&q->lock);
+    q->steps += solver.steps; q->evaluations += solver.evaluations;
+    if(unsettled<0) q->failed_at = solver.t; else q->unsettled += unsettled;
+    pthread_mutex_unlock(&q->lock);
+  }
+}
+
+int SteadyStateTable::settle_all(int n_lanes, int unit) {
+  SettleQueue q;
+  q.table = this; q.n_lanes = n_lanes; q.next = 0;
+  q.per_batch = max(1,batch_lanes/unit)*unit;
+  q.steps = q.evaluations = q.unsettled = 0; q.failed_at = -1;
+  pthread_mutex_init(&q.lock,NULL);
+  int n_batches = (n_lanes+q.per_batch-1)/q.per_batch;
+  vector<pthread_t> workers(min(threads,n_batches)-1);
+  for(int w=0;w<workers.size();w++)
+    if(pthread_create(&workers[w],NULL,settle_worker,&q))
+      { workers.resize(w); break; } // carry on with the threads we have
+  settle_worker(&q);
+  for(int w=0;w<workers.size();w++) pthread_join(workers[w],NULL);
+  pthread_mutex_destroy(&q.lock);
+  steps += q.steps; evaluations += q.evaluations;
+  if(q.failed_at>=0) {
+    pthread_mutex_lock(&report_lock);
+    compile_error("GRN steady-state simulation failed at time "+f2s(q.failed_at));
+    terminate_on_error();
+    pthread_mutex_unlock(&report_lock);
+    return -1;
+  }
+  return q.unsettled;
+}
+
+bool SteadyStateTable::run() {
+  level.assign(n_rows*model.outputs.size(),0); settle_time.assign(n_rows,-1);
+  int unsettled = settle_all(n_rows,1);
+  if(unsettled<0) return false;
+  if(unsettled) {
+    pthread_mutex_lock(&report_lock);
+    compile_warn(i2s(unsettled)+" truth table rows did not reach steady state within "+f2s(max_time,0)+" seconds");
+    pthread_mutex_unlock(&report_lock);
+  }
+  return true;
+}
+
+void SteadyStateTable::print(ostream* out) {
+  bool first = true;
+  for(int i=0;i<model.inputs.size();i++)
+    { *out<<(first?"":",")<<model.names[model.inputs[i]]; first=false; }
+  for(int i=0;i<model.outputs.size();i++)
+    { *out<<(first?"":",")<<model.names[model.outputs[i]]; first=false; }
+  *out<<(first?"":",")<<"Settled\n";
+  int n_out = model.outputs.size();
+  char buf[32];
+  for(int r=0;r<n_rows;r++) {
+    for(int i=0;i<model.inputs.size();i++) *out<<input_level(r,i)<<",";
+    for(int i=0;i<n_out;i++) *out<<(level[r*n_out+i]>1e2)<<",";
+    snprintf(buf,sizeof buf,"%.2f",settle_time[r]); *out<<buf<<"\n";
+  }
+}
+
+/*****************************************************************************
+ *  MONTE CARLO ROBUSTNESS                                                   *
+ *****************************************************************************/
+
+RobustnessAnalysis::RobustnessAnalysis(GRN* net, int samples, double spread,
+                                       int only, int threads)
+  : SteadyStateTable(net,threads) {
+  this->samples = samples; this->spread = spread; this->only = only;
+  batch_lanes = 64; failed_samples = unsettled = 0;
+}
+
+// Standard normal deviate, by the Box-Muller transform
+static double gaussian() {
+  double u1 = (rand()+1.0)/(RAND_MAX+2.0), u2 = (rand()+1.0)/(RAND_MAX+2.0);
+  return sqrt(-2*log(u1))*cos(2*M_PI*u2);
+}
+
+// Scale each parameter of the batch's samples (all of each sample's rows'
+// lanes) by that sample's multiplier for it
+void RobustnessAnalysis::prepare(StiffSolver* solver) {
+  SteadyStateTable::prepare(solver);
+  if(nominal_truth.empty()) return; // still deriving the nominal table
+  int n_p = model.n_parameters();
+  for(int l=0;l<solver->lanes;l++) {
+    const double* m = &multiplier[(solver->row[l]/n_rows)*n_p];
+    for(int j=0;j<n_p;j++)
+      solver->params[j*solver->stride+l] = model.nominal[j]*m[j];
+  }
+}
+
+void RobustnessAnalysis::record(StiffSolver* solver, int lane, double when) {
+  if(nominal_truth.empty()) // still deriving the nominal table
+    { SteadyStateTable::record(solver,lane,when); return; }
+  int sample = solver->row[lane]/n_rows, r = solver->row[lane]%n_rows;
+  int n_out = model.outputs.size();
+  for(int k=0;k<n_out;k++) {
+    bool high = solver->y[model.outputs[k]*solver->stride+lane]>1e2;
+    if(high!=nominal_truth[r*n_out+k]) sample_failed[sample*n_out+k] = true;
+  }
+}
+
+bool RobustnessAnalysis::run() {
+  nominal_truth.clear();
+  if(!SteadyStateTable::run()) return false;
+  int n_out = model.outputs.size(), n_p = model.n_parameters();
+  nominal_truth.resize(n_rows*n_out);
+  for(int i=0;i<nominal_truth.size();i++) nominal_truth[i] = level[i]>1e2;
+  // Draw every multiplier up front, in sample order, so that the samples
+  // do not depend on how batches are spread over threads.  The sense maps
+  // each from the biological parameter, e.g. a longer halflife lowers the
+  // decay rate.
+  multiplier.assign(samples*n_p,1);
+  for(int s=0;s<samples;s++)
+    for(int j=0;j<n_p;j++)
+      if(model.sense[j] && (only==N_PARAMETER_CLASSES || only==model.parameter_class[j]))
+        multiplier[s*n_p+j] = exp(spread*gaussian()*model.sense[j]);
+  sample_failed.assign(samples*n_out,false);
+  failures.assign(n_out,0); failed_samples = 0;
+  unsettled = settle_all(samples*n_rows,n_rows);
+  if(unsettled<0) return false;
+  for(int s=0;s<samples;s++) {
+    bool any = false;
+    for(int k=0;k<n_out;k++)
+      if(sample_failed[s*n_out+k]) { failures[k]++; any = true; }
+    if(any) failed_samples++;
+  }
+  if(unsettled)
+    compile_warn(i2s(unsettled)+" perturbed truth table rows did not reach steady state within "+f2s(max_time,0)+" seconds");
+  return true;
+}
+
+void RobustnessAnalysis::print(ostream* out) {
+  char buf[32];
+  *out<<"Output,Failures,Samples,FailureRate\n";
+  for(int k=0;k<model.outputs.size();k++) {
+    snprintf(buf,sizeof buf,"%.4f",samples ? failures[k]/(double)samples : 0);
+    *out<<model.names[model.outputs[k]]<<","<<failures[k]<<","<<samples<<","
+        <<buf<<"\n";
+  }
+  snprintf(buf,sizeof buf,"%.4f",samples ? failed_samples/(double)samples : 0);
+  *out<<"Any,"<<failed_samples<<","<<samples<<","<<buf<<"\n";
+}
+
+void GRNEmitter::simulate() {
+  double start = get_real_secs();
+  GRNSimulation sim(&grn);
+  if(!sim.run()) return;
+  V1<<"Simulated "<<sim.n_stages<<" stages in "<<sim.steps<<" steps, "
+    <<sim.evaluations<<" evaluations, "<<(get_real_secs()-start)<<" secs\n";
+  ostream* ts = get_stream_for("simulation","_timeseries.csv");
+  sim.print_timeseries(ts); *ts<<flush;
+  ostream* tt = get_stream_for("simulation","_truth_table.csv");
+  sim.print_truth_table(tt); *tt<<flush;
+}
+
+void GRNEmitter::steady_state_table() {
+  double start = get_real_secs();
+  SteadyStateTable table(&grn,sim_threads);
+  if(!table.run()) return;
+  V1<<"Settled "<<table.n_rows<<" truth table rows in "<<table.steps
+    <<" steps, "<<table.evaluations<<" evaluations, "
+    <<(get_real_secs()-start)<<" secs\n";
+  ostream* out = get_stream_for("steady state","_steady_state.csv");
+  table.print(out); *out<<flush;
+}
+
+void GRNEmitter::robustness_analysis() {
+  double start = get_real_secs();
+  srand(robustness_seed);
+  RobustnessAnalysis analysis(&grn,robustness_samples,robustness_spread,
+                              robustness_only,sim_threads);
+  if(!analysis.run()) return;
+  V1<<"Analyzed "<<analysis.samples<<" parameter samples in "<<analysis.steps
+    <<" steps, "<<analysis.evaluations<<" evaluations, "
+    <<(get_real_secs()-start)<<" secs\n";
+  ostream* out = get_stream_for("robustness","_robustness.csv");
+  analysis.print(out); *out<<flush;
+}
@@ -0,0 +1,187 @@
+/* Native GRN simulation
+Copyright (C) 2009-2011, Raytheon BBN Technologies and contributors listed
+in the AUTHORS file in TASBE BioCompiler distribution's top directory.
+
+This file is part of the TASBE BioCompiler, and is distributed under
+the terms of the GNU General Public License, with a linking exception,
+as described in the file LICENSE in the TASBE BioCompiler
+distribution's top directory. */
+
+// The simulator compiles a GRN into a flat numeric model, implementing
+// the same equations as the Matlab model from to-matlab.cpp, and
+// integrates it in-process with a stiff solver.
+
+#ifndef __GRN_SIMULATOR__
+#define __GRN_SIMULATOR__
+
+#include "grn.h"
+
+namespace grn {
+
+/// Biological parameters that a sweep may perturb
+enum GRNParameterClass { HILL, HALFLIFE, STRENGTH, DISSOCIATION, RATE,
+                         FIXED, N_PARAMETER_CLASSES };
+
+/* A GRN compiled to parameter arrays with index-based regulation lists.
+ Species are indexed in GRN::chemicals order, as in the Matlab model.
+ Per species i:
+   dy_i = sum(productions of i) - decay_i*y_i  [+ input drive]
+ where a production is rate * prod over its regulations of
+   (1+K*(C/D)^H)/(1+(C/D)^H)
+ with C the effective level of the regulating signal.
+ All numeric parameters live in one block, so that a batch can carry
+ its own copy per lane; the P_* fields are offsets of each group. */
+struct GRNModel {
+  // Per species
+  vector<string> names; // sanitized names
+  vector<int> effective_by; // reaction giving effective level, or -1
+  // Regulatory reactions: eff(substrate) = substrate*K*activity(regulator)
+  vector<int> rxn_regulator, rxn_substrate;
+  vector<char> rxn_repressor;
+  // Expression regulations; K is already inverted for repressors
+  vector<int> reg_signal;
+  // Productions: rate * regulations [reg_begin,reg_end) to target
+  vector<int> prod_target, prod_reg_begin, prod_reg_end;
+  // Inputs are driven toward their stage's level; outputs are read out
+  vector<int> inputs, outputs;
+  // Parameters: Hill coefficient & log(2)/halflife per species, K & D per
+  // reaction and per regulation, rate per production
+  int P_hill, P_decay, P_rxn_K, P_rxn_D, P_reg_K, P_reg_D, P_rate;
+  vector<double> nominal;
+  // Which biological parameter each entry comes from, and the exponent
+  // (+1, -1 or 0) by which scaling that parameter scales the entry
+  vector<char> parameter_class, sense;
+
+  GRNModel(GRN* net);
+  int size() const { return names.size(); }
+  int n_parameters() const { return nominal.size(); }
+  /// dy = f(y) with inputs held at levels (0 or 1), for a batch of lanes
+  /// stored species-major (y[i*stride+lane]), as are the parameters P;
+  /// eff is (size()+1)*stride of scratch
+  void derivatives(const double* y, const double* levels, const double* P,
+                   double* dy, double* eff, int lanes=1, int stride=1) const;
+ private:
+  int add_parameter(double value, GRNParameterClass c, int sense);
+};
+
+/* Linearly implicit Rosenbrock (2,3) integrator: the method of Matlab's
+ ode23s, with a finite-difference Jacobian.  It advances a batch of
+ independent lanes in lockstep, storing every per-lane array
+ species-major so that the inner loops run across lanes. */
+class StiffSolver {
+ public:
+  double rtol, atol;
+  int steps, rejections, evaluations; // statistics
+  double t;
+  int lanes, stride; // active lanes occupy [0,lanes) of each row
+  vector<double> y, levels, dy; // species x stride, inputs x stride
+  vector<double> params; // parameters x stride, initially nominal
+  vector<int> row; // which of the original lanes each active lane is
+
+  StiffSolver(const GRNModel* model, int lanes=1, double rtol=1e-3,
+              double atol=1e-6);
+  /// (Re)start from the current y and levels at time t0
+  void start(double t0);
+  /// Take one accepted step, ending no later than t_end; returns false if
+  /// the step size underflows
+  bool step(double t_end, double max_step);
+  /// Step until t1
+  bool integrate(double t1, double max_step);
+  /// Drop a lane from the batch, moving the last active lane into its place
+  void retire(int lane);
+ private:
+  const GRNModel* model; int n;
+  double h; // proposed step size, carried from step to step
+  vector<double> J, W, F1, F2, k1, k2, k3, ynew, eff, tmp, scale;
+  vector<int> pivot;
+  void f(const double* y, double* dy);
+  void jacobian();
+  bool factor(double hd);
+  void solve(double* b);
+};
+
+/// The Matlab _sim.m experiment: one stage per combination of binary
+/// inputs, each long enough for a signal to cross the network
+struct GRNSimulation {
+  GRNModel model;
+  double stage_length, time_step;
+  int n_stages;
+  vector<double> times, trajectory; // trajectory is times x species
+  vector<char> truth; // stages x outputs
+  int steps, evaluations;
+
+  GRNSimulation(GRN* net);
+  double input_level(int stage, int input) { return (stage>>input)&1; }
+  bool run();
+  void print_timeseries(ostream* out);
+  void print_truth_table(ostream* out);
+};
+
+/// Truth table from steady states: every input combination is simulated
+/// from zero, batch_lanes rows to a batched solve, and each lane stops as
+/// soon as all of its species have settled.  Batches are shared out among
+/// worker threads; since the batching does not depend on the number of
+/// threads, neither do the results.
+struct SteadyStateTable {
+  GRNModel model;
+  int n_rows;
+  double min_time, max_time; // bounds on when a lane may be called settled
+  double steady_rate; // settled when every |dy/dt| < steady_rate*max(y,1)
+  int batch_lanes; // lanes per batched solve
+  int threads; // worker threads settling batches
+  vector<double> level; // rows x outputs, concentration at settling
+  vector<double> settle_time; // per row; -1 if it never settled
+  int steps, evaluations;
+
+  SteadyStateTable(GRN* net, int threads=1);
+  virtual ~SteadyStateTable() {}
+  double input_level(int row, int input) { return (row>>input)&1; }
+  bool run();
+  void print(ostream* out);
+ protected:
+  /// Settle original lanes [0,n_lanes), batched in whole units of unit
+  /// lanes, on the worker threads; returns the number of lanes that never
+  /// settled, or -1 if an integration failed (after reporting it)
+  int settle_all(int n_lanes, int unit);
+  /// Set up a batch's solver: each lane's levels, from its row, where
+  /// row = original lane % n_rows
+  virtual void prepare(StiffSolver* solver);
+  /// Integrate until every lane has settled (or max_time), recording each
+  /// lane as it settles; returns the number of lanes that never settled,
+  /// or -1 if the step size underflowed.  Runs on a worker thread: record
+  /// may only write state belonging to the solver's own lanes.
+  int settle(StiffSolver* solver);
+  bool settled(StiffSolver* solver, int lane);
+  virtual void record(StiffSolver* solver, int lane, double when);
+ private:
+  static void* settle_worker(void* queue);
+};
+
+/// Monte Carlo robustness: each sample scales every parameter by an
+/// independent log-normal multiplier and re-derives the steady-state truth
+/// table; a sample fails an output if any row differs from the nominal
+/// table.  Samples are batched together, n_rows lanes per sample, and the
+/// multipliers are all drawn before any batch runs.
+struct RobustnessAnalysis : public SteadyStateTable {
+  int samples; // number of perturbed parameter sets
+  double spread; // standard deviation of each multiplier's log
+  int only; // GRNParameterClass to perturb, or N_PARAMETER_CLASSES for all
+  vector<char> nominal_truth; // rows x outputs
+  vector<int> failures; // per output, samples failing that output
+  int failed_samples, unsettled;
+
+  RobustnessAnalysis(GRN* net, int samples, double spread, int only,
+                     int threads=1);
+  bool run();
+  void print(ostream* out);
+ protected:
+  void prepare(StiffSolver* solver);
+  void record(StiffSolver* solver, int lane, double when);
+ private:
+  vector<double> multiplier; // samples x parameters
+  vector<char> sample_failed; // samples x outputs
+};
+
+}
+
+#endif // __GRN_SIMULATOR__
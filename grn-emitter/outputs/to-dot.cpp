@@ -73,7 +73,7 @@ string declare_regulation(Chemical* c) {
   bool is_repressor = false, is_activator = false;
   
   // First do the consumers, which will determine color of producer edges
-  for_set(ExpressionRegulation*,c->consumers,er) {
+  for_adj(ExpressionRegulation*,c->consumers,er) {
     if((*er)->repressor) is_repressor = true; else is_activator = true;
 
     string cname = sanitized_name((*er)->signal->name);
@@ -85,7 +85,7 @@ string declare_regulation(Chemical* c) {
   // Now create the producer edges
   string color = (is_repressor ? (is_activator ? "darkorange" : "red")
                   : (is_activator ? "green" : "blue"));
-  for_set(CodingSequence*,c->producers,pcs) {
+  for_adj(CodingSequence*,c->producers,pcs) {
     string cname = sanitized_name((*pcs)->product->name);
     string pcsname = fu_elt_name(*pcs);
     s += "  " + pcsname + " -> " + cname; // declare edge
@@ -93,7 +93,7 @@ string declare_regulation(Chemical* c) {
   }
   
   // Finally, create regulatory reaction edges
-  for_set(RegulatoryReaction*,c->regulatorFor,rr) {
+  for_adj(RegulatoryReaction*,c->regulatorFor,rr) {
     string rname = sanitized_name((*rr)->regulator->name);
     string sname = sanitized_name((*rr)->substrate->name);
     s += "  " + rname + " -> " + sname; // declare edge
@@ -41,7 +41,7 @@ void generate_matlab_equations(GRNEmitter* emitter, ostream* vars, ostream* eqns
         *vars << R << " = " << f2s(force_promoter_rate((Promoter*)dc),5) << ";\n";
         rate += R;
       }
-      for_set(ExpressionRegulation*,dc->regulators,er) {
+      for_adj(ExpressionRegulation*,dc->regulators,er) {
         string C = sanitized_name((*er)->signal->name); // record later
         string H = ("H_"+C); // chemical parameter; record later
         string K = ("K_"+C); paramnames->push_back(K);
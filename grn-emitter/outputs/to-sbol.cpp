@@ -12,97 +12,133 @@ distribution's top directory. */
 #include "cheapo-xml.h"
 #include "sbol.h"
 
-/*************** XML Extension ***************/
-struct SBOL_XML : public XMLitem {
-  SBOL_XML()
-    : XMLitem("s:Collection","SHORT/col/GeneticRegulatoryNetwork")
-  {}
+/*************** SBOL WRITER ***************/
+static const char* SBOL_prefix =
+  "<?xml version=\"1.0\"?>\n"
+  "<rdf:RDF xmlns:rdf=\"http://www.w3.org/1999/02/22-rdf-syntax-ns#\"\n"
+  "  xmlns:rdfs=\"http://www.w3.org/2000/01/rdf-schema#\"\n"
+  "  xmlns:so=\"http://purl.obolibrary.org/obo/\"\n"
+  "  xmlns:s=\"http://sbols.org/v1#\"\n"
+  "  xmlns:grn=\"urn:bbn.com:tasbe:grn\">\n";
 
-  void emit_prefix(ostream* out) {
-    *out << "<?xml version=\"1.0\"?>" << endl;
-    *out << "<rdf:RDF xmlns:rdf=\"http://www.w3.org/1999/02/22-rdf-syntax-ns#\"" << endl;
-    *out << "  xmlns:rdfs=\"http://www.w3.org/2000/01/rdf-schema#\"" << endl;
-    *out << "  xmlns:so=\"http://purl.obolibrary.org/obo/\"" << endl; 
-    *out << "  xmlns:s=\"http://sbols.org/v1#\"" << endl;
-    *out << "  xmlns:grn=\"urn:bbn.com:tasbe:grn\">" << endl;
-  }
-};
+string SO_prefix = "http://purl.obolibrary.org/obo/";
+static int sb_next_id = 0; // part & annotation IDs, unique across files
 
-/*************** XMLIZERS FOR GRN ELEMENTS ***************/
-void sb_add_type_annotation(XMLitem *elt,ProtoType* t) {
-  XMLitem *ext = new XMLitem("grn:design");
-  XMLitem* type = new XMLitem("grn:DataType");
-  if(t->isA("ProtoBoolean")) {
-    type->attributes["grn:logicalType"]="boolean";
-    ProtoBoolean *bt = dynamic_cast<ProtoBoolean*>(t);
-    if(bt->constant) type->attributes["grn:logicalValue"]=b2s(bt->value);
-  } else {
-    compile_warn("Don't know how to XMLize type"+t->to_str()+": type information will be discarded");
+// Serializes GRN elements straight to an XMLStream
+struct SBOLWriter {
+  XMLStream xml;
+  set<grn::Chemical*> described; // chemicals already given in full
+
+  void link_open(const char* relation) { xml.open(relation); xml.children(); }
+
+  void type_annotation(ProtoType* t) {
+    link_open("grn:design");
+    xml.open("grn:DataType");
+    if(t->isA("ProtoBoolean")) {
+      xml.attribute("grn:logicalType","boolean");
+      ProtoBoolean *bt = dynamic_cast<ProtoBoolean*>(t);
+      if(bt->constant) xml.attribute("grn:logicalValue",b2s(bt->value));
+    } else {
+      compile_warn("Don't know how to XMLize type"+t->to_str()+": type information will be discarded");
+    }
+    xml.empty();
+    xml.close("grn:design");
   }
-  ext->addElt(type); elt->addElt(ext);
-}
- 
-set<grn::Chemical*> sb_chem_cache;
-XMLitem* sb_chemical_to_xml(grn::Chemical* c) {
-  XMLitem* x = new XMLitem("grn:ChemicalSpecies");
-  x->attributes["grn:uid"]=c->name;
-  if(!sb_chem_cache.count(c)) {
+
+  void chemical(grn::Chemical* c) {
+    xml.open("grn:ChemicalSpecies"); xml.attribute("grn:uid",c->name);
+    bool typed = false, family = false;
+    if(!described.count(c)) {
+      described.insert(c);
+      typed = c->attributes.count("type");
+      // if it's a motif-constant and produced by something, give its family
+      family = c->attributes.count(":motif-constant") && c->producers.size();
+    }
+    if(!typed && !family) { xml.empty(); return; }
+    xml.children();
     // annotate w. logical type
-    if(c->attributes.count("type"))
-      sb_add_type_annotation(x,((grn::ProtoTypeAttribute*)c->attributes["type"])->type);
-    // if it's a motif-constant and produced by something, annotate its family
-    if(c->attributes.count(":motif-constant") && c->producers.size()) {
-      XMLitem* family = new XMLitem("grn:Family"); 
-      family->attributes["grn:name"]=c->name;
-      x->linkElt("grn:property",family);
+    if(typed) 
+      type_annotation(((grn::ProtoTypeAttribute*)c->attributes["type"])->type);
+    if(family) {
+      link_open("grn:property");
+      xml.open("grn:Family"); xml.attribute("grn:name",c->name); xml.empty();
+      xml.close("grn:property");
     }
     // note: may need to convert to scientific notation
     //x->attributes["gamma"]=f2s(c->halflife,4);
     //x->attributes["H"]=f2s(c->hill_coefficient,4);
-    sb_chem_cache.insert(c);
+    xml.close("grn:ChemicalSpecies");
   }
-  return x;
-}
 
-string SO_prefix = "http://purl.obolibrary.org/obo/";
-XMLitem* sb_dc_to_xml(grn::DNAComponent* dc) {
-  static int next_id = 0;
-  XMLitem* x = new XMLitem("s:DnaComponent","part_"+i2s(++next_id));
-  x->addElt(new TrivialItem("s:displayId","part_"+i2s(next_id))); 
-  XMLitem* type = new XMLitem("rdf:type");
-  if(dc->isA("Promoter")) {
-    x->addElt(new TrivialItem("s:name","Promoter "+i2s(next_id)));
-    type->attributes["rdf:resource"] = SO_prefix+"SO_0000167"; // Promoter
-    sb_add_type_annotation(x,((grn::Promoter*)dc)->rate); // annotate w. logical type
-    //x->attributes["alpha"] = f2s(force_promoter_rate((Promoter*)dc));
-  } else if(dc->isA("CodingSequence")) {
-    grn::Chemical* c = ((grn::CodingSequence*)dc)->product;
-    x->addElt(new TrivialItem("s:name",c->name+" CDS"));
-    type->attributes["rdf:resource"] = SO_prefix+"SO_0000316"; // CDS
-    XMLitem *ext = new XMLitem("grn:regulation"); x->addElt(ext);
-    ext->linkElt("grn:product",sb_chemical_to_xml(c));
-  } else if(dc->isA("Terminator")) {
-    x->addElt(new TrivialItem("s:name","Terminator "+i2s(next_id)));
-    type->attributes["rdf:resource"] = SO_prefix+"SO_0000141"; // terminator
-    // no other information needed for terminator
-  } else {
-    ierror("Don't yet know how to XMLize "+dc->to_str());
+  void regulated_by(bool repressor, grn::Chemical* c) {
+    xml.open("grn:regulatedBy"); xml.attribute("grn:repression",b2s(repressor));
+    xml.children(); chemical(c); xml.close("grn:regulatedBy");
   }
-  x->addElt(type); // put last, after all other elements
-  XMLitem* sa = new XMLitem("s:SequenceAnnotation","SHORT/anot/an_"+i2s(++next_id));
-  sa->linkElt("s:subComponent",x);
-  return sa;
-}
 
-XMLitem* sb_rr_to_xml(grn::RegulatoryReaction* rr) {
-  XMLitem *rxn = new XMLitem("grn:RegulatoryReaction");
-  rxn->linkElt("grn:substrate",sb_chemical_to_xml(rr->substrate));
-  XMLitem *regulator = new XMLitem("grn:regulatedBy");
-  regulator->attributes["grn:repression"] = b2s(rr->repressor);
-  regulator->addElt(sb_chemical_to_xml(rr->regulator));
-  rxn->addElt(regulator);
-  return rxn;
-}
+  // A sequence annotation holding one part; last says whether it ends
+  // its functional unit, or else precedes the next annotation
+  void dna_component(grn::DNAComponent* dc, bool last) {
+    int part = ++sb_next_id, anot = ++sb_next_id;
+    link_open("s:annotation");
+    xml.open("s:SequenceAnnotation");
+    xml.attribute("rdf:about","SHORT/anot/an_"+i2s(anot)); xml.children();
+    if(!last) { // the next part's annotation takes the next two IDs
+      xml.open("s:precedes");
+      xml.attribute("rdf:resource","SHORT/anot/an_"+i2s(anot+2)); xml.empty();
+    }
+    link_open("s:subComponent");
+    xml.open("s:DnaComponent"); xml.attribute("rdf:about","part_"+i2s(part));
+    xml.children();
+    xml.element("s:displayId","part_"+i2s(part));
+    string type;
+    if(dc->isA("Promoter")) {
+      xml.element("s:name","Promoter "+i2s(part));
+      type = SO_prefix+"SO_0000167"; // Promoter
+      type_annotation(((grn::Promoter*)dc)->rate); // annotate w. logical type
+      //x->attributes["alpha"] = f2s(force_promoter_rate((Promoter*)dc));
+    } else if(dc->isA("CodingSequence")) {
+      grn::Chemical* c = ((grn::CodingSequence*)dc)->product;
+      xml.element("s:name",c->name+" CDS");
+      type = SO_prefix+"SO_0000316"; // CDS
+      link_open("grn:regulation"); link_open("grn:product");
+      chemical(c);
+      xml.close("grn:product"); xml.close("grn:regulation");
+    } else if(dc->isA("Terminator")) {
+      xml.element("s:name","Terminator "+i2s(part));
+      type = SO_prefix+"SO_0000141"; // terminator
+      // no other information needed for terminator
+    } else {
+      ierror("Don't yet know how to XMLize "+dc->to_str());
+    }
+    xml.open("rdf:type"); xml.attribute("rdf:resource",type); xml.empty();
+    for_adj(grn::ExpressionRegulation*,dc->regulators,er) {
+      link_open("grn:regulation");
+      regulated_by((*er)->repressor,(*er)->signal);
+      xml.close("grn:regulation");
+    }
+    xml.close("s:DnaComponent"); xml.close("s:subComponent");
+    xml.close("s:SequenceAnnotation"); xml.close("s:annotation");
+  }
+
+  void functional_unit(grn::FunctionalUnit* fu, int idx) {
+    link_open("s:component");
+    xml.open("s:DnaComponent");
+    xml.attribute("rdf:about","SHORT/part/FunctionalUnit_"+i2s(idx));
+    xml.children();
+    xml.element("s:displayId","FunctionalUnit_"+i2s(idx));
+    for(int j=0;j<fu->sequence.size();j++)
+      dna_component(fu->sequence[j],j==fu->sequence.size()-1);
+    xml.close("s:DnaComponent"); xml.close("s:component");
+  }
+
+  void reaction(grn::RegulatoryReaction* rr) {
+    link_open("grn:RegulatoryReaction");
+    link_open("grn:substrate"); chemical(rr->substrate);
+    xml.close("grn:substrate");
+    regulated_by(rr->repressor,rr->regulator);
+    xml.close("grn:RegulatoryReaction");
+  }
+};
 
 void comment(Collection* design, string s) {
   char* prior = getCollectionDescription(design);
@@ -118,49 +154,31 @@ void grn::GRNEmitter::to_sbol(ostream* out) {
   //comment(design, "Genetic regulatory network for Proto: " + string(parent->last_script));
   //comment(design, std::string("Produced by BioCompiler version ")+BIOCOMPILER_VERSION);
 
-  // Old version...
-  sb_chem_cache.clear();
-  SBOL_XML sbol;
-  sbol.addComment("Genetic regulatory network for Proto: "
-                 + string(parent->last_script));
-  sbol.addComment(std::string("Produced by BioCompiler version ")+BIOCOMPILER_VERSION);
-  sbol.addElt(new TrivialItem("s:displayId","GeneticRegulatoryNetwork"));
+  SBOLWriter sbol;
+  XMLStream* xml = &sbol.xml;
+  xml->raw(SBOL_prefix);
+  xml->open("s:Collection");
+  xml->attribute("rdf:about","SHORT/col/GeneticRegulatoryNetwork");
+  xml->children();
+  xml->comment("Genetic regulatory network for Proto: "
+               + string(parent->last_script));
+  xml->comment(std::string("Produced by BioCompiler version ")+BIOCOMPILER_VERSION);
+  xml->element("s:displayId","GeneticRegulatoryNetwork");
   // Serialize all transcriptional units
-  sbol.addBreak(); sbol.addComment("Transcriptional Units");
+  xml->blank(); xml->comment("Transcriptional Units");
   int idx = 0;
   for_set(grn::DNAComponent*,grn.dnacomponents,i) {
-    if(i!=grn.dnacomponents.begin()) sbol.addBreak();
-    FunctionalUnit* fu = (FunctionalUnit*)*i;
-    XMLitem *seq = new XMLitem("s:DnaComponent","SHORT/part/FunctionalUnit_"+i2s(++idx));
-    sbol.linkElt("s:component",seq);
-    seq->addElt(new TrivialItem("s:displayId","FunctionalUnit_"+i2s(idx)));
-    XMLitem *lastdc = NULL;
-    for(int j=0;j<fu->sequence.size();j++) {
-      XMLitem *dc = sb_dc_to_xml(fu->sequence[j]);
-      if(lastdc) { // add precedence link
-        XMLitem* prec = new XMLitem("s:precedes");
-        prec->attributes["rdf:resource"] = dc->attributes["rdf:about"];
-        lastdc->addEltToFront(prec);
-      }
-      seq->linkElt("s:annotation",dc);
-      lastdc=dc;
-      for_set(ExpressionRegulation*,fu->sequence[j]->regulators,er) {
-        XMLitem *reg = new XMLitem("grn:regulatedBy");
-        reg->attributes["grn:repression"]=b2s((*er)->repressor);
-        reg->addElt(sb_chemical_to_xml((*er)->signal)); 
-        XMLitem *ext = new XMLitem("grn:regulation"); ext->addElt(reg);
-        // lastdc always exists:
-        XMLitem *subC = *lastdc->elements.begin();
-          (*subC->elements.begin())->addElt(ext);
-      }
-    }
+    if(i!=grn.dnacomponents.begin()) xml->blank();
+    sbol.functional_unit((FunctionalUnit*)*i,++idx);
   }
   // Serialize all reactions
   if(grn.reactions.size()) {
-    sbol.addBreak(); sbol.addComment("Regulatory Reactions");
-    XMLitem *ext = new XMLitem("grn:regulation"); sbol.addElt(ext);
-    for_set(grn::RegulatoryReaction*,grn.reactions,ri)
-      { ext->addElt(sb_rr_to_xml(*ri)); }
+    xml->blank(); xml->comment("Regulatory Reactions");
+    sbol.link_open("grn:regulation");
+    for_set(grn::RegulatoryReaction*,grn.reactions,ri) { sbol.reaction(*ri); }
+    xml->close("grn:regulation");
   }
-  sbol.emit(out); *out << flush;
+  xml->close("s:Collection");
+  xml->raw("</rdf:RDF>\n");
+  xml->write(out);
 }
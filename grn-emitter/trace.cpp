@@ -0,0 +1,370 @@
+/* Optimization trace recording and replay
+Copyright (C) 2009-2011, Raytheon BBN Technologies and contributors listed
+in the AUTHORS file in TASBE BioCompiler distribution's top directory.
+
+This file is part of the TASBE BioCompiler, and is distributed under
+the terms of the GNU General Public License, with a linking exception,
+as described in the file LICENSE in the TASBE BioCompiler
+distribution's top directory. */
+
+// The trace is JSONL: the first line adds the whole unoptimized network,
+// then each line records one rule's rewrite as the units, chemicals, and
+// reactions it removed and added.  A changed element is removed and
+// re-added under the same key.  Replaying the lines up to a step
+// rebuilds the network as it stood after that step.
+
+#include "config.h"
+#include "biocompiler.h"
+
+using namespace grn;
+
+/*************** RECORDING ***************/
+// Programs span lines, so control characters are escaped too: each trace
+// record must stay on one line
+static string json_string(string s) {
+  string r = "\"";
+  for(int i=0;i<s.size();i++) {
+    unsigned char c = s[i];
+    if(c=='"' || c=='\\') { r += '\\'; r += c; }
+    else if(c=='\n') r += "\\n";
+    else if(c=='\r') r += "\\r";
+    else if(c=='\t') r += "\\t";
+    else if(c<0x20 || c==0x7f)
+      { char buf[8]; snprintf(buf,sizeof buf,"\\u%04x",c); r += buf; }
+    else r += c;
+  }
+  return r+"\"";
+}
+
+static string json_number(double d) { ostringstream s; s<<d; return s.str(); }
+
+static string json_type(ProtoType* t) {
+  string kind = t->isA("ProtoBoolean") ? "boolean" :
+    t->isA("ProtoScalar") ? "scalar" : "";
+  if(kind=="") return "{\"kind\":\"other\",\"text\":"+json_string(t->to_str())+"}";
+  string s = "{\"kind\":\""+kind+"\"";
+  ProtoScalar* st = dynamic_cast<ProtoScalar*>(t);
+  if(st->constant)
+    s += ",\"value\":"+(kind=="boolean" ? b2s(st->value) : json_number(st->value));
+  return s+"}";
+}
+
+static string json_chemical(Chemical* c) {
+  string s = "{\"name\":"+json_string(c->name)+",\"hill\":"+
+    json_number(c->hill_coefficient)+",\"halflife\":"+json_number(c->halflife);
+  if(c->attributes.count("type"))
+    s += ",\"type\":"+json_type(((ProtoTypeAttribute*)c->attributes["type"])->type);
+  if(c->attributes.count(":motif-constant")) s += ",\"motif_constant\":true";
+  return s+"}";
+}
+
+static string json_regulators(DNAComponent* dc) {
+  string s = "[";
+  for_adj(ExpressionRegulation*,dc->regulators,er) {
+    if(s.size()>1) s += ",";
+    s += "{\"signal\":"+json_string((*er)->signal->name)+",\"repressor\":"+
+      b2s((*er)->repressor)+",\"strength\":"+json_number((*er)->strength)+
+      ",\"dissociation\":"+json_number((*er)->dissociation)+"}";
+  }
+  return s+"]";
+}
+
+static string json_unit(FunctionalUnit* fu) {
+  string s = "{\"id\":"+i2s(fu->elmt_id)+",\"parts\":[";
+  for(int i=0;i<fu->sequence.size();i++) {
+    DNAComponent* dc = fu->sequence[i];
+    if(i) s += ",";
+    if(dc->isA("Promoter")) {
+      s += "{\"kind\":\"promoter\",\"rate\":"+json_type(((Promoter*)dc)->rate);
+    } else if(dc->isA("CodingSequence")) {
+      s += "{\"kind\":\"cds\",\"product\":"+
+        json_string(((CodingSequence*)dc)->product->name);
+    } else if(dc->isA("Terminator")) {
+      s += "{\"kind\":\"terminator\"";
+    } else {
+      ierror("Don't know how to trace "+dc->to_str());
+    }
+    s += ",\"regulators\":"+json_regulators(dc)+"}";
+  }
+  return s+"]}";
+}
+
+static string json_reaction(RegulatoryReaction* rr) {
+  return "{\"id\":"+i2s(rr->elmt_id)+",\"regulator\":"+
+    json_string(rr->regulator->name)+",\"substrate\":"+
+    json_string(rr->substrate->name)+",\"repressor\":"+b2s(rr->repressor)+"}";
+}
+
+OptimizationTrace::OptimizationTrace(ostream* out, string program) {
+  this->out = out; this->program = program; step = 0;
+}
+
+void OptimizationTrace::snapshot(GRN* net, TraceSnapshot* snap) {
+  for(int k=0;k<3;k++) snap[k].clear();
+  for_map(string,Chemical*,net->chemicals,i)
+    { snap[0][i->first] = json_chemical(i->second); }
+  for_set(DNAComponent*,net->dnacomponents,i)
+    { snap[1][i2s((*i)->elmt_id)] = json_unit((FunctionalUnit*)*i); }
+  for_set(RegulatoryReaction*,net->reactions,i)
+    { snap[2][i2s((*i)->elmt_id)] = json_reaction(*i); }
+}
+
+void OptimizationTrace::record(GRN* net, string rule) {
+  static const char* kinds[] = {"chemicals","units","reactions"};
+  TraceSnapshot now[3]; snapshot(net,now);
+  string removed, added;
+  for(int k=0;k<3;k++) {
+    string r, a;
+    for(TraceSnapshot::iterator i=last[k].begin();i!=last[k].end();i++) {
+      TraceSnapshot::iterator j = now[k].find(i->first);
+      if(j!=now[k].end() && j->second==i->second) continue;
+      if(r.size()) r += ",";
+      r += (k==0) ? json_string(i->first) : i->first;
+    }
+    for(TraceSnapshot::iterator i=now[k].begin();i!=now[k].end();i++) {
+      TraceSnapshot::iterator j = last[k].find(i->first);
+      if(j!=last[k].end() && j->second==i->second) continue;
+      if(a.size()) a += ",";
+      a += i->second;
+    }
+    if(r.size())
+      removed += string(removed.size()?",":"")+"\""+kinds[k]+"\":["+r+"]";
+    if(a.size())
+      added += string(added.size()?",":"")+"\""+kinds[k]+"\":["+a+"]";
+  }
+  *out<<"{\"step\":"<<step<<",\"rule\":"<<json_string(rule);
+  if(step==0) *out<<",\"program\":"<<json_string(program);
+  *out<<",\"remove\":{"<<removed<<"},\"add\":{"<<added<<"}}\n";
+  step++;
+  for(int k=0;k<3;k++) last[k].swap(now[k]);
+}
+
+/*************** REPLAY ***************/
+// Just enough JSON to read back what the recorder writes
+struct TraceValue {
+  enum { NONE, BOOLEAN, NUMBER, STRING, ARRAY, OBJECT } kind;
+  bool b; double n; string s;
+  vector<TraceValue*> items;
+  map<string,TraceValue*> fields;
+  TraceValue() { kind=NONE; b=false; n=0; }
+  ~TraceValue() {
+    for(int i=0;i<items.size();i++) delete items[i];
+    for(map<string,TraceValue*>::iterator i=fields.begin();i!=fields.end();i++)
+      delete i->second;
+  }
+  TraceValue* get(string field)
+  { return fields.count(field) ? fields[field] : &missing; }
+  static TraceValue missing;
+};
+TraceValue TraceValue::missing;
+
+static void skip_space(const string& s, int* p)
+{ while(*p<s.size() && isspace(s[*p])) (*p)++; }
+
+// Parse one value starting at *p; NULL, having freed any partial value, if
+// the text is malformed
+static TraceValue* parse_trace_value(const string& s, int* p) {
+  skip_space(s,p);
+  if(*p>=s.size()) return NULL;
+  TraceValue* v = new TraceValue();
+  char c = s[*p];
+  if(c=='{' || c=='[') {
+    v->kind = (c=='{') ? TraceValue::OBJECT : TraceValue::ARRAY;
+    char close = (c=='{') ? '}' : ']';
+    (*p)++; skip_space(s,p);
+    if(*p<s.size() && s[*p]==close) { (*p)++; return v; }
+    while(true) {
+      string field;
+      if(v->kind==TraceValue::OBJECT) {
+        TraceValue* key = parse_trace_value(s,p); skip_space(s,p);
+        bool ok = key!=NULL && key->kind==TraceValue::STRING &&
+          *p<s.size() && s[*p]==':';
+        if(ok) field = key->s;
+        delete key;
+        if(!ok) { delete v; return NULL; }
+        (*p)++;
+      }
+      TraceValue* item = parse_trace_value(s,p);
+      if(item==NULL) { delete v; return NULL; }
+      if(v->kind==TraceValue::OBJECT)
+        { delete v->fields[field]; v->fields[field]=item; } // last one wins
+      else v->items.push_back(item);
+      skip_space(s,p);
+      if(*p>=s.size()) { delete v; return NULL; }
+      if(s[*p]==close) { (*p)++; return v; }
+      if(s[*p]!=',') { delete v; return NULL; }
+      (*p)++;
+    }
+  } else if(c=='"') {
+    v->kind = TraceValue::STRING;
+    for((*p)++; *p<s.size() && s[*p]!='"'; (*p)++) {
+      if(s[*p]!='\\') { v->s += s[*p]; continue; }
+      if(++(*p)>=s.size()) break;
+      switch(s[*p]) {
+      case 'n': v->s += '\n'; break;
+      case 'r': v->s += '\r'; break;
+      case 't': v->s += '\t'; break;
+      case 'b': v->s += '\b'; break;
+      case 'f': v->s += '\f'; break;
+      case 'u': { // the recorder only escapes single-byte characters
+        unsigned code = 0;
+        if(*p+4>=s.size() || sscanf(s.c_str()+*p+1,"%4x",&code)!=1 || code>0xff)
+          { delete v; return NULL; }
+        v->s += (char)code; *p += 4; break;
+      }
+      default: v->s += s[*p]; // \" \\ \/
+      }
+    }
+    if(*p>=s.size()) { delete v; return NULL; }
+    (*p)++;
+  } else if(s.compare(*p,4,"true")==0 || s.compare(*p,5,"false")==0) {
+    v->kind = TraceValue::BOOLEAN; v->b = (c=='t'); *p += v->b ? 4 : 5;
+  } else {
+    const char* start = s.c_str()+*p; char* end;
+    v->n = strtod(start,&end);
+    if(end==start) { delete v; return NULL; }
+    v->kind = TraceValue::NUMBER; *p += end-start;
+  }
+  return v;
+}
+
+static ProtoScalar* replay_type(TraceValue* t) {
+  string kind = t->get("kind")->s;
+  TraceValue* value = t->get("value");
+  if(kind=="boolean")
+    return value->kind==TraceValue::NONE ? new ProtoBoolean() :
+      new ProtoBoolean(value->b);
+  if(kind=="scalar")
+    return value->kind==TraceValue::NONE ? new ProtoScalar() :
+      new ProtoScalar(value->n);
+  compile_warn("Can't replay type "+t->get("text")->s+": type information will be discarded");
+  return NULL;
+}
+
+static Chemical* replay_chemical(GRN* net, string name) {
+  if(!net->chemicals.count(name)) {
+    compile_error("Optimization trace refers to unknown chemical "+name);
+    net->add_chemical(new Chemical(name));
+  }
+  return net->chemicals[name];
+}
+
+static void replay_regulators(GRN* net, DNAComponent* dc, TraceValue* regs) {
+  for(int i=0;i<regs->items.size();i++) {
+    TraceValue* r = regs->items[i];
+    new ExpressionRegulation(replay_chemical(net,r->get("signal")->s),dc,
+                             r->get("repressor")->b,r->get("strength")->n,
+                             r->get("dissociation")->n);
+  }
+}
+
+void GRNEmitter::replay_optimization_trace() {
+  ifstream in(replay_trace.c_str());
+  if(!in.is_open()) {
+    compile_error("Can't open optimization trace "+replay_trace);
+    terminate_on_error();
+  }
+  // current elements, by the keys the recorder used
+  static const char* kinds[] = {"chemicals","units","reactions"};
+  map<string,TraceValue*> chemicals; map<int,TraceValue*> elements[3];
+  // the maps point into the parsed lines, which are freed once replayed
+  vector<TraceValue*> lines;
+  string line, program; int step = -1, lineno = 0;
+  while((replay_step<0 || step<replay_step) && getline(in,line)) {
+    lineno++;
+    int pos = 0; TraceValue* v = parse_trace_value(line,&pos);
+    if(v==NULL) {
+      if(line.find_first_not_of(" \t\r")==string::npos) continue;
+      compile_error("Malformed optimization trace line "+i2s(lineno)+" in "+
+                    replay_trace);
+      terminate_on_error();
+    }
+    lines.push_back(v);
+    step = (int)v->get("step")->n;
+    if(step==0) program = v->get("program")->s;
+    V2<<"Replaying step "<<step<<": "<<v->get("rule")->s<<endl;
+    for(int k=0;k<3;k++) {
+      TraceValue* gone = v->get("remove")->get(kinds[k]);
+      for(int i=0;i<gone->items.size();i++) {
+        if(k==0) chemicals.erase(gone->items[i]->s);
+        else elements[k].erase((int)gone->items[i]->n);
+      }
+      TraceValue* added = v->get("add")->get(kinds[k]);
+      for(int i=0;i<added->items.size();i++) {
+        TraceValue* e = added->items[i];
+        if(k==0) chemicals[e->get("name")->s] = e;
+        else elements[k][(int)e->get("id")->n] = e;
+      }
+    }
+  }
+  if(step<0) {
+    compile_error("Optimization trace "+replay_trace+" is empty");
+    terminate_on_error();
+  }
+  if(replay_step>step)
+    compile_warn("Optimization trace ends at step "+i2s(step)+
+                 ": replaying only that far");
+
+  // rebuild the network; units & reactions keep their original order
+  grn.clear();
+  for(map<string,TraceValue*>::iterator i=chemicals.begin();
+      i!=chemicals.end();i++) {
+    TraceValue* e = i->second;
+    Chemical* c = new Chemical(i->first,e->get("hill")->n,
+                               e->get("halflife")->n);
+    if(e->get("type")->kind==TraceValue::OBJECT) {
+      ProtoScalar* t = replay_type(e->get("type"));
+      if(t) c->attributes["type"] = new ProtoTypeAttribute(t);
+    }
+    if(e->get("motif_constant")->b)
+      c->attributes[":motif-constant"] = new MarkerAttribute(true);
+    grn.add_chemical(c);
+  }
+  for(map<int,TraceValue*>::iterator i=elements[1].begin();
+      i!=elements[1].end();i++) {
+    FunctionalUnit* fu = new FunctionalUnit();
+    TraceValue* parts = i->second->get("parts");
+    for(int j=0;j<parts->items.size();j++) {
+      TraceValue* part = parts->items[j]; string kind = part->get("kind")->s;
+      DNAComponent* dc;
+      if(kind=="promoter") {
+        ProtoScalar* rate = replay_type(part->get("rate"));
+        dc = rate ? new Promoter(rate) : new Promoter();
+      } else if(kind=="cds") {
+        dc = new CodingSequence(replay_chemical(&grn,part->get("product")->s));
+      } else if(kind=="terminator") {
+        dc = new Terminator();
+      } else {
+        compile_error("Optimization trace has unknown part kind "+kind);
+        continue;
+      }
+      replay_regulators(&grn,dc,part->get("regulators"));
+      fu->add(dc);
+    }
+    grn.add_functional_unit(fu);
+  }
+  for(map<int,TraceValue*>::iterator i=elements[2].begin();
+      i!=elements[2].end();i++) {
+    TraceValue* e = i->second;
+    grn.reactions.insert
+      (new RegulatoryReaction(replay_chemical(&grn,e->get("regulator")->s),
+                              replay_chemical(&grn,e->get("substrate")->s),
+                              e->get("repressor")->b));
+  }
+  for(int i=0;i<lines.size();i++) delete lines[i];
+  terminate_on_error();
+  GRNCertifyBackpointers checker(verbosity);
+  checker.propagate(&grn); // make sure the trace was consistent
+
+  V1<<"Replayed optimization trace to step "<<step<<endl;
+  // outputs name the program that was traced, not the one given now
+  replay_program = program; parent->last_script = replay_program.c_str();
+  if(parent->is_dump_code) {
+    *cpout<<"Genetic Regulatory Network:\n"<<linearize();
+    *cpout<<"End of Genetic Regulatory Network\n" << flush;
+  }
+  if(emit_sbol)
+    { to_sbol(get_stream_for("SBOL","_replay_"+i2s(step)+".sbol.xml")); }
+  if(emit_dot)
+    { to_dot(get_stream_for("GraphViz","_replay_"+i2s(step)+".dot")); }
+}
@@ -9749,3 +9749,4 @@ m4_include([config/garbagecollection.m4])
 m4_include([config/glut.m4])
 m4_include([config/inbrowser.m4])
 m4_include([config/neocompiler.m4])
+m4_include([config/offscreen.m4])
@@ -0,0 +1,39 @@
+AC_DEFUN([PROTO_WITH_OFFSCREEN], [
+    AC_ARG_WITH([offscreen],  dnl funny spacing here gets the output formatting right
+[AS_HELP_STRING([--with-offscreen], [render headless snapshots with EGL and libpng])
+AS_HELP_STRING([--without-offscreen], [do not render offscreen, even if available])],
+                [use_offscreen=$withval],
+                [use_offscreen=meh])
+
+    # offscreen rendering draws with the same code as the GLUT window
+    WANT_OFFSCREEN=false
+    if $WANT_GLUT && test "$use_offscreen" != "no"; then
+        have_offscreen=yes
+        AC_CHECK_HEADERS([EGL/egl.h png.h], [], [have_offscreen=no])
+        AC_CHECK_LIB([EGL], [eglGetDisplay], [:], [have_offscreen=no])
+        AC_CHECK_LIB([png], [png_create_write_struct], [:], [have_offscreen=no])
+        if test "$have_offscreen" = "yes"; then
+            WANT_OFFSCREEN=true
+        fi
+    fi
+
+    case "$use_offscreen" in
+        yes)
+            if ! $WANT_OFFSCREEN; then
+                AC_MSG_ERROR([Offscreen rendering needs GLUT, EGL, and libpng])
+            fi
+            ;;
+        meh)
+            if $WANT_GLUT && ! $WANT_OFFSCREEN; then
+                AC_MSG_WARN([No EGL or libpng found; no headless snapshots])
+            fi
+            ;;
+    esac
+
+    AM_CONDITIONAL(WANT_OFFSCREEN, $WANT_OFFSCREEN)
+    if $WANT_OFFSCREEN; then
+        AC_DEFINE([WANT_OFFSCREEN], 1,
+                  [Define if headless snapshots can be rendered offscreen])
+        LIBS="-lEGL -lpng ${LIBS}"
+    fi
+])
@@ -19,6 +19,7 @@ in the file LICENSE in the MIT Proto distribution's top directory. */
 
 #include "compiler.h"
 #include "nicenames.h"
+#include "profiler.h"
 
 using namespace std;
 
@@ -390,7 +391,9 @@ class DeadCodeEliminator : public IRPropagator {
   virtual void print(ostream* out=0) { *out << "DeadCodeEliminator"; }
   void preprop() { kill_f = worklist_f; kill_a = worklist_a; }
   void postprop() {
+    // note_change() marked the live elements: count the deletions instead
     any_changes = !kill_f.empty() || !kill_a.empty();
+    num_changes = kill_f.size() + kill_a.size();
     while(!kill_f.empty()) {
       Field* f = *kill_f.begin(); kill_f.erase(f);
       V2<<"Deleting field "<<ce2s(f)<<endl;
@@ -1221,6 +1224,7 @@ void DFGTransformer::transform(DFG* g) {
   CertifyBackpointers checker(verbosity);
   if(paranoid) checker.propagate(g); // make sure we're starting OK
   for(int i=0;i<max_loops;i++) {
+    if(compiler_profiler) compiler_profiler->note_loop();
     bool changed=false;
     for(int j=0;j<rules.size();j++) {
       changed |= rules[j]->propagate(g); terminate_on_error();
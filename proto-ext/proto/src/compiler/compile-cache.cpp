@@ -0,0 +1,213 @@
+/* On-disk cache of compiled scripts
+Copyright (C) 2009, Jacob Beal, and contributors
+listed in the AUTHORS file in the MIT Proto distribution's top directory.
+
+This file is part of MIT Proto, and is distributed under the terms of
+the GNU General Public License, with a linking exception, as described
+in the file LICENSE in the MIT Proto distribution's top directory. */
+
+#include "compile-cache.h"
+
+#include <sys/stat.h>
+#include <sys/types.h>
+
+#include <dirent.h>
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <utime.h>
+
+#include <algorithm>
+#include <fstream>
+#include <sstream>
+#include <vector>
+
+#include "config.h"
+
+using namespace std;
+
+// Entries are one file apiece: a header line, then the full key (checked
+// on lookup, so a hash collision is just a miss), then the files read
+// while compiling with their digests, then the script bytes.
+#define CACHE_MAGIC "PROTO-COMPILE-CACHE 2"
+#define CACHE_SUFFIX ".pcc"
+
+CompileCache::CompileCache(const string &dir, int max_entries, int verbosity) {
+  this->dir = dir; this->max_entries = max_entries;
+  this->verbosity = verbosity;
+  hits = misses = stores = evictions = 0;
+#ifdef _WIN32
+  if(mkdir(dir.c_str())!=0 && errno!=EEXIST)
+#else
+  if(mkdir(dir.c_str(),ACCESSPERMS)!=0 && errno!=EEXIST)
+#endif
+    uerror("Unable to create compile cache directory %s", dir.c_str());
+  load_stats();
+}
+
+uint64_t CompileCache::hash(const string &s) {
+  uint64_t h = 14695981039346656037ULL;
+  for(size_t i=0;i<s.size();i++) { h ^= (uint8_t)s[i]; h *= 1099511628211ULL; }
+  return h;
+}
+
+static string hex(uint64_t h) {
+  char buf[32];
+  snprintf(buf,sizeof buf,"%016llx",(unsigned long long)h);
+  return buf;
+}
+
+string CompileCache::file_digest(const string &path) {
+  ifstream in(path.c_str(), ios::in | ios::binary);
+  if(!in.is_open()) return "-";
+  ostringstream contents; contents << in.rdbuf();
+  return hex(hash(contents.str()));
+}
+
+// Normalized form: single-space separated, with scalars at full precision
+// (SE_Scalar::print rounds, which would make distinct programs collide)
+static void normalize(SExpr *s, ostream *out) {
+  if(s->isList()) {
+    SE_List *l = &dynamic_cast<SE_List &>(*s);
+    *out << "(";
+    for(size_t i=0;i<l->len();i++) {
+      if(i) *out << " ";
+      normalize((*l)[i],out);
+    }
+    *out << ")";
+  } else if(s->isScalar()) {
+    char buf[32];
+    snprintf(buf,sizeof buf,"%.9g",dynamic_cast<SE_Scalar &>(*s).value);
+    *out << buf;
+  } else {
+    *out << dynamic_cast<SE_Symbol &>(*s).name;
+  }
+}
+
+string CompileCache::make_key(SExpr *program, const string &config) {
+  ostringstream key;
+  normalize(program,&key);
+  key << "\n" << config;
+  return key.str();
+}
+
+string CompileCache::entry_path(const string &key) {
+  return dir + "/" + hex(hash(key)) + CACHE_SUFFIX;
+}
+
+uint8_t *CompileCache::lookup(const string &key, int *len) {
+  string path = entry_path(key);
+  ifstream in(path.c_str(), ios::in | ios::binary);
+  string magic; size_t keylen = 0; int buflen = -1;
+  if(in.is_open()) { getline(in,magic); in >> keylen; in.get(); }
+  if(magic==CACHE_MAGIC && keylen==key.size()) {
+    string stored(keylen,'\0');
+    in.read(&stored[0],keylen);
+    int n_files = -1;
+    if(in && stored==key) { in >> n_files; in.get(); }
+    bool is_current = n_files>=0;
+    for(int i=0;i<n_files && is_current;i++) {
+      string file, digest;
+      getline(in,file); getline(in,digest);
+      if(!in || file_digest(file)!=digest) {
+        V1 << "Compile cache entry is stale: " << file << " changed" << endl;
+        is_current = false;
+      }
+    }
+    if(is_current) { in >> buflen; in.get(); }
+  }
+  if(buflen>=0) {
+    uint8_t *buf = static_cast<uint8_t *>(calloc(buflen,sizeof(uint8_t)));
+    in.read(reinterpret_cast<char *>(buf),buflen);
+    if(in) {
+      utime(path.c_str(),NULL); // refresh for least-recently-used eviction
+      hits++; *len = buflen;
+      V1 << "Compile cache hit: " << path << endl;
+      return buf;
+    }
+    free(buf);
+  }
+  misses++;
+  V1 << "Compile cache miss: " << path << endl;
+  return NULL;
+}
+
+void CompileCache::store(const string &key, uint8_t *buf, int len,
+                         const vector<string> &files) {
+  string path = entry_path(key), tmp = path + ".tmp";
+  { // write to a temporary, then rename, so readers never see partial entries
+    ofstream out(tmp.c_str(), ios::out | ios::binary | ios::trunc);
+    if(!out.is_open())
+      { compile_warn("Unable to write compile cache entry "+path); return; }
+    out << CACHE_MAGIC << "\n" << key.size() << "\n" << key
+        << files.size() << "\n";
+    for(int i=0;i<files.size();i++)
+      out << files[i] << "\n" << file_digest(files[i]) << "\n";
+    out << len << "\n";
+    out.write(reinterpret_cast<const char *>(buf),len);
+  }
+  if(rename(tmp.c_str(),path.c_str())!=0)
+    { remove(tmp.c_str()); compile_warn("Unable to store "+path); return; }
+  stores++;
+  V2 << "Stored compile cache entry " << path << endl;
+  evict();
+}
+
+// Collect (mtime, path) for every entry in the directory
+static void list_entries(const string &dir, vector<pair<time_t,string> > *out) {
+  DIR *d = opendir(dir.c_str());
+  if(d==NULL) return;
+  string suffix = CACHE_SUFFIX;
+  struct dirent *e;
+  while((e=readdir(d))!=NULL) {
+    string name = e->d_name;
+    if(name.size()<=suffix.size() ||
+       name.compare(name.size()-suffix.size(),suffix.size(),suffix)!=0)
+      continue;
+    string path = dir + "/" + name;
+    struct stat st;
+    if(stat(path.c_str(),&st)==0)
+      out->push_back(make_pair(st.st_mtime,path));
+  }
+  closedir(d);
+}
+
+int CompileCache::num_entries() {
+  vector<pair<time_t,string> > entries;
+  list_entries(dir,&entries);
+  return entries.size();
+}
+
+// Least-recently-used eviction: lookups touch entries, so the oldest
+// modification times are the ones no one has asked for lately
+void CompileCache::evict() {
+  vector<pair<time_t,string> > entries;
+  list_entries(dir,&entries);
+  if(entries.size()<=max_entries) return;
+  sort(entries.begin(),entries.end());
+  for(int i=0;i<entries.size()-max_entries;i++) {
+    V2 << "Evicting compile cache entry " << entries[i].second << endl;
+    if(remove(entries[i].second.c_str())==0) evictions++;
+  }
+}
+
+void CompileCache::load_stats() {
+  ifstream in(stats_path().c_str());
+  if(in.is_open()) in >> hits >> misses >> stores >> evictions;
+  if(!in) hits = misses = stores = evictions = 0;
+}
+
+void CompileCache::save_stats() {
+  ofstream out(stats_path().c_str(), ios::out | ios::trunc);
+  if(out.is_open())
+    out << hits << " " << misses << " " << stores << " " << evictions << endl;
+}
+
+void CompileCache::print_stats(ostream *out) {
+  int lookups = hits + misses;
+  *out << "Compile cache " << dir << ": " << num_entries() << "/"
+       << max_entries << " entries, " << hits << " hits, " << misses
+       << " misses";
+  if(lookups) *out << " (" << f2s(100.0*hits/lookups,1) << "% hit rate)";
+  *out << ", " << stores << " stores, " << evictions << " evictions" << endl;
+}
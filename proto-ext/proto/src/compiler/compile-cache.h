@@ -0,0 +1,64 @@
+/* On-disk cache of compiled scripts
+Copyright (C) 2009, Jacob Beal, and contributors
+listed in the AUTHORS file in the MIT Proto distribution's top directory.
+
+This file is part of MIT Proto, and is distributed under the terms of
+the GNU General Public License, with a linking exception, as described
+in the file LICENSE in the MIT Proto distribution's top directory. */
+
+// The compile cache lets repeated compilations of the same program
+// (parameter sweeps, regenerated tests, re-loads in the simulator) skip
+// interpretation, analysis, and emission.  Entries are content-addressed:
+// the key is the normalized S-expression plus a fingerprint of the compiler
+// configuration, and the value is the emitted script.  Files the program
+// pulls in while compiling (includes, library definitions) are only known
+// afterward, so each entry also lists them with a digest of their contents,
+// and a lookup whose files have since changed is a miss.
+
+#ifndef PROTO_COMPILER_COMPILE_CACHE_H
+#define PROTO_COMPILER_COMPILE_CACHE_H
+
+#include <stdint.h>
+
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "sexpr.h"
+
+class CompileCache {
+ public:
+  /// Statistics: cumulative over every process sharing the directory
+  int hits, misses, stores, evictions;
+  int verbosity;
+
+  CompileCache(const std::string &dir, int max_entries, int verbosity);
+
+  /// Normalized text of a program plus configuration; this is the real key
+  std::string make_key(SExpr *program, const std::string &config);
+  /// Returns a calloc'd copy of the cached script, or NULL on a miss
+  uint8_t *lookup(const std::string &key, int *len);
+  /// files are those read while compiling, checked again by lookup
+  void store(const std::string &key, uint8_t *buf, int len,
+             const std::vector<std::string> &files);
+
+  int num_entries();
+  void save_stats();
+  void print_stats(std::ostream *out = cpout);
+
+  /// 64-bit FNV-1a: stable across platforms and runs, unlike pointer hashes
+  static uint64_t hash(const std::string &s);
+  /// Hex digest of a file's contents, or "-" if it can't be read
+  static std::string file_digest(const std::string &path);
+
+ private:
+  std::string dir;
+  int max_entries;
+
+  std::string entry_path(const std::string &key);
+  std::string stats_path() { return dir + "/cache.stats"; }
+  void load_stats();
+  void evict();
+};
+
+#endif  // PROTO_COMPILER_COMPILE_CACHE_H
@@ -32,6 +32,32 @@ SExpr::isKeyword() const
 
 bool SExpr::NO_LINE_BREAKS = true;
 
+map<string, int> &
+SymbolTable::ids()
+{
+  static map<string, int> table;
+  return table;
+}
+
+vector<string> &
+SymbolTable::names()
+{
+  static vector<string> table;
+  return table;
+}
+
+int
+SymbolTable::intern(const string &name)
+{
+  map<string, int>::const_iterator i = ids().find(name);
+  if (i != ids().end())
+    return i->second;
+  int id = names().size();
+  names().push_back(name);
+  ids()[name] = id;
+  return id;
+}
+
 // Compiler output streams
 
 ostream *cpout = &cout;
@@ -196,6 +222,10 @@ test_compiler_utils()
   out = read_sexpr("cmdline", "this|is|bar|separated");
   if (out) *cpout << out->to_str() << endl; else *cpout << "Parse failed!\n";
 
+  SE_Symbol s1("sym"), s2("sym"), s3("other"); // interning: same name, same ID
+  *cpout << "interned: " << b2s(s1.id == s2.id) << " " << b2s(s1 == &s2)
+         << " " << b2s(s1 == &s3) << endl;
+
   *cpout << flush;
   exit(0);
   //ierror(&foo,"Behold the fail!");
@@ -15,13 +15,18 @@ in the file LICENSE in the MIT Proto distribution's top directory. */
 #include <sys/types.h>
 
 #include <errno.h>
+#include <string.h>
 
 #include <fstream>
+#include <set>
 
 #include "config.h"
+#include "proto_version.h"
 
+#include "compile-cache.h"
 #include "nicenames.h"
 #include "plugin_manager.h"
+#include "profiler.h"
 
 using namespace std;
 
@@ -42,12 +47,27 @@ using namespace std;
 // len is filled in w. output length... eventually
 uint8_t* NeoCompiler::compile(const char *str, int* len) {
   last_script=str;
+  // the compiler's switches have all been consumed by now
+  if(arg_log) { arg_log->log_removals(NULL); arg_log = NULL; }
+  int n_setup_files = proto_path.files_read.size();
   V1 << "Parsing expression...\n";
-  compile_phase = "parsing"; // PHASE: text-> sexpr
+  begin_phase("parsing"); // PHASE: text-> sexpr
   SExpr* sexpr = read_sexpr("command-line",str);
   compiler_error|=!sexpr; terminate_on_error();
+  string cache_key;
+  if(cache && cacheable()) {
+    begin_phase("cache lookup"); // PHASE: skip the rest if seen before
+    cache_key = cache->make_key(sexpr,config_fingerprint(n_setup_files));
+    uint8_t* cached = cache->lookup(cache_key,len);
+    if(cached) {
+      end_profile(str,*len);
+      cache->save_stats();
+      if(is_print_cache_stats) cache->print_stats(cpout);
+      return cached;
+    }
+  }
   V1 << "Interpreting parsed expression into DFG...\n";
-  compile_phase = "interpretation"; // PHASE: sexpr -> IR
+  begin_phase("interpretation"); // PHASE: sexpr -> IR
   interpreter->interpret(sexpr); // terminates on error internally
   if(interpreter->dfg->output==NULL)
     { compile_error("Program has no content."); terminate_on_error(); }
@@ -57,10 +77,11 @@ uint8_t* NeoCompiler::compile(const char *str, int* len) {
     if(dotstream.is_open()) interpreter->dfg->printdot(&dotstream,is_dotfields);
   }
   if(is_early_terminate==3) 
-    { *cperr << "Stopping before analysis" << endl; exit(0); }
+    { end_profile(str,0);
+      *cperr << "Stopping before analysis" << endl; exit(0); }
   
   V1 << "Analyzing and optimizing DFG...\n";
-  compile_phase = "analysis"; // PHASE: IR manipulation
+  begin_phase("analysis"); // PHASE: IR manipulation
   analyzer->transform(interpreter->dfg); // terminates on error internally
   if(is_dump_analyzed) interpreter->dfg->print(cpout);
   if(is_dump_dotfiles) {
@@ -68,14 +89,15 @@ uint8_t* NeoCompiler::compile(const char *str, int* len) {
     if(dotstream.is_open()) interpreter->dfg->printdot(&dotstream,is_dotfields);
   }
   if(is_early_terminate==2) 
-    { *cperr << "Stopping before localization" << endl; exit(0); }
+    { end_profile(str,0);
+      *cperr << "Stopping before localization" << endl; exit(0); }
   
-  compile_phase = "legality check"; // PHASE: legality check
+  begin_phase("legality check"); // PHASE: legality check
   IRPropagator *p = new CheckTypeConcreteness();
   p->propagate(interpreter->dfg);
   
   V1 << "Global-to-local transformation of DFG...\n";
-  compile_phase = "localization"; // PHASE: Global-to-local transformation
+  begin_phase("localization"); // PHASE: Global-to-local transformation
   localizer->transform(interpreter->dfg); // terminates on error internally
   if(is_dump_raw_localized) interpreter->dfg->print(cpout);
   if(is_dump_dotfiles) {
@@ -83,7 +105,7 @@ uint8_t* NeoCompiler::compile(const char *str, int* len) {
     if(dotstream.is_open()) interpreter->dfg->printdot(&dotstream,is_dotfields);
   }
   V1 << "Analyzing and optimizing localized DFG\n";
-  compile_phase = "local analysis"; // PHASE: IR manipulation
+  begin_phase("local analysis"); // PHASE: IR manipulation
   analyzer->transform(interpreter->dfg); // terminates on error internally
   if(is_dump_localized) interpreter->dfg->print(cpout);
   if(is_dump_dotfiles) {
@@ -91,17 +113,82 @@ uint8_t* NeoCompiler::compile(const char *str, int* len) {
     if(dotstream.is_open()) interpreter->dfg->printdot(&dotstream,is_dotfields);
   }
   if(is_early_terminate==1) 
-    { *cperr << "Stopping before emission" << endl; exit(0); }
+    { end_profile(str,0);
+      *cperr << "Stopping before emission" << endl; exit(0); }
   
   V1 << "Emitting DFG to executable form...\n";
-  compile_phase = "emission"; // PHASE: code emission
-  return emitter->emit_from(interpreter->dfg, len);
+  begin_phase("emission"); // PHASE: code emission
+  uint8_t* buf = emitter->emit_from(interpreter->dfg, len);
+  end_profile(str,*len);
+  if(!cache_key.empty()) {
+    vector<string> files; set<string> seen;
+    for(int i=n_setup_files;i<proto_path.files_read.size();i++)
+      if(seen.insert(proto_path.files_read[i]).second)
+        files.push_back(proto_path.files_read[i]);
+    cache->store(cache_key,buf,*len,files); cache->save_stats();
+    if(is_print_cache_stats) cache->print_stats(cpout);
+  }
+  return buf;
+}
+
+void NeoCompiler::begin_phase(const char *name) {
+  compile_phase = name;
+  if(compiler_profiler) compiler_profiler->begin_phase(name,interpreter->dfg);
+}
+
+void NeoCompiler::end_profile(const char *str, int len) {
+  if(compiler_profiler) compiler_profiler->finish(interpreter->dfg,str,len);
+}
+
+// The cache only holds the script itself: any request to see intermediate
+// results, or an emitter with outputs of its own, needs the full pipeline
+bool NeoCompiler::cacheable() {
+  if(is_dump_code || is_dump_interpreted || is_dump_analyzed ||
+     is_dump_raw_localized || is_dump_localized || is_dump_dotfiles ||
+     is_early_terminate)
+    return false;
+  if(emitter==NULL || !emitter->isA("ProtoKernelEmitter")) return false;
+  return !((ProtoKernelEmitter*)emitter)->is_dump_hex;
+}
+
+// Switches that only affect where diagnostics go, never what is emitted;
+// they are left out of the compile cache key
+static const char* output_only_switches[] = {
+  "-D", "--test-mode", "--compile-cache-stats", NULL };
+static const char* output_only_args[] = {
+  "-dump-dir", "-dump-stem", "--verbosity", "--profile-compiler",
+  "--compile-cache", "--compile-cache-size", NULL };
+
+static bool in_list(const char** list, const string &s) {
+  for(int i=0; list[i]!=NULL; i++) if(s==list[i]) return true;
+  return false;
+}
+
+// The switches the compiler consumed, less the output-only ones, plus the
+// contents of every file read while setting up (the standard library,
+// opcode files); arguments left for the simulator don't matter.
+string NeoCompiler::config_fingerprint(int n_setup_files) {
+  string config = string("PROTO v") + PROTO_VERSION + "\n" + platform_config;
+  for(int i=0;i<config_args.size();i++) {
+    if(in_list(output_only_args,config_args[i])) { i++; continue; }
+    if(!in_list(output_only_switches,config_args[i]))
+      config += "\n" + config_args[i];
+  }
+  set<string> seen;
+  for(int i=0;i<n_setup_files;i++) {
+    const string &file = proto_path.files_read[i];
+    if(seen.insert(file).second)
+      config += "\nfile " + file + " " + CompileCache::file_digest(file);
+  }
+  return config;
 }
 
 /*****************************************************************************
  *  COMPILER OBJECT API                                                      *
  *****************************************************************************/
 NeoCompiler::NeoCompiler(Args* args) : Compiler(args) {
+  // note the switches consumed from here until the first compilation
+  arg_log = args; args->log_removals(&config_args);
   is_dump_all = args->extract_switch("-CDall");
   is_dump_interpreted = args->extract_switch("-CDinterpreted") | is_dump_all;
   is_dump_analyzed = args->extract_switch("-CDanalyzed") | is_dump_all;
@@ -118,6 +205,20 @@ NeoCompiler::NeoCompiler(Args* args) : Compiler(args) {
   paranoid = args->extract_switch("--paranoid");
   infile = (args->extract_switch("--infile"))?args->pop_next():"";
   verbosity = (args->extract_switch("--verbosity")?args->pop_int():0);
+  cache = NULL;
+  if(args->extract_switch("--compile-cache")) {
+    string dir = args->pop_next();
+    int max_entries = (args->extract_switch("--compile-cache-size")
+                       ? args->pop_int() : 256);
+    cache = new CompileCache(dir,max_entries,verbosity);
+  }
+  is_print_cache_stats = args->extract_switch("--compile-cache-stats");
+  // the profiler exists before the interpreter, so loading of the
+  // standard library is charged to its own phase
+  if(args->extract_switch("--profile-compiler")) {
+    compiler_profiler = new CompilerProfiler(args->pop_next());
+    compiler_profiler->begin_phase("initialization",NULL);
+  }
   
   // Set up paths
   // srcdir is an undocumented option used for uninstalled execution
@@ -137,7 +238,9 @@ NeoCompiler::NeoCompiler(Args* args) : Compiler(args) {
 }
 
 NeoCompiler::~NeoCompiler() {
+  if(arg_log) arg_log->log_removals(NULL);
   delete interpreter;
+  delete compiler_profiler; compiler_profiler = NULL;
 }
 
 static int
@@ -205,11 +308,13 @@ void
 NeoCompiler::set_platform(const string &path)
 {
   cerr << "WARNING: NeoCompiler platform handling not yet implemented\n";
+  platform_config += "platform " + path + "\n";
 }
 
 void
 NeoCompiler::setDefops(const string &defops)
 {
+  platform_config += defops;
   if(emitter->isA("ProtoKernelEmitter")) {
     ((ProtoKernelEmitter*)emitter)->setDefops(defops);
   } else {
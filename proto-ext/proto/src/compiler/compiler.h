@@ -27,7 +27,7 @@ in the file LICENSE in the MIT Proto distribution's top directory. */
 #include "reader.h"
 #include "utils.h"
 
-struct ProtoInterpreter; class NeoCompiler;
+struct ProtoInterpreter; class NeoCompiler; class CompileCache;
 
 /*****************************************************************************
  *  INTERPRETER                                                              *
@@ -38,24 +38,31 @@ struct ProtoInterpreter; class NeoCompiler;
  */
 struct Env {
   Env* parent; ProtoInterpreter* cp;
-  std::map<std::string,CompilationElement*> bindings;
+  /// keyed by interned symbol ID (see SymbolTable)
+  std::map<int,CompilationElement*> bindings;
 
   Env(ProtoInterpreter* cp) { parent=NULL; this->cp = cp; }
   Env(Env* parent) { this->parent=parent; cp = parent->cp; }
-  void bind(std::string name, CompilationElement* value);
-  void force_bind(std::string name, CompilationElement* value);
+  void bind(int id, CompilationElement* value);
+  void bind(std::string name, CompilationElement* value)
+    { bind(SymbolTable::intern(name),value); }
+  void force_bind(int id, CompilationElement* value);
+  void force_bind(std::string name, CompilationElement* value)
+    { force_bind(SymbolTable::intern(name),value); }
 
   /**
    * Lookups: w/o type, returns NULL on failure; w. type, checks, returns dummy
    */
-  CompilationElement* lookup(std::string name, bool recursed=false);
+  CompilationElement* lookup(int id, bool recursed=false);
+  CompilationElement* lookup(std::string name, bool recursed=false)
+    { return lookup(SymbolTable::intern(name),recursed); }
   CompilationElement* lookup(SE_Symbol* sym, std::string type);
 
   /**
    * Operators needed to be accessed unshadowed by compiler. These are gathered
    * after initialization, but before user code is loaded.
    */
-  static std::map<std::string,Operator*> core_ops;
+  static std::map<int,Operator*> core_ops;
   static void record_core_ops(Env* toplevel);
   static Operator* core_op(std::string name);
 };
@@ -150,7 +157,7 @@ class Block;
 
 class ProtoKernelEmitter : public CodeEmitter { public: reflection_sub(ProtoKernelEmitter, CodeEmitter);
  public:
-  bool is_dump_hex, paranoid;
+  bool is_dump_hex, paranoid, is_superinstructions;
   static bool op_debug;
   int max_loops, verbosity, print_compact;
   NeoCompiler *parent;
@@ -260,6 +267,13 @@ class NeoCompiler : public Compiler {
   CodeEmitter* emitter;
   /// the last piece of text fed to start the compiler
   const char* last_script;
+  /// optional on-disk cache of emitted scripts (NULL if disabled)
+  CompileCache* cache;
+  bool is_print_cache_stats;
+  /// the arguments consumed by the compiler, in order
+  std::vector<std::string> config_args;
+  Args* arg_log; // where config_args come from, until the first compile
+  std::string platform_config;
 
  public:
   NeoCompiler(Args* args);
@@ -269,6 +283,12 @@ class NeoCompiler : public Compiler {
   uint8_t* compile(const char *str, int* len);
   void set_platform(const std::string &path);
   void setDefops(const std::string &defops);
+
+ private:
+  bool cacheable();
+  std::string config_fingerprint(int n_setup_files);
+  void begin_phase(const char *name);
+  void end_profile(const char *str, int len);
 };
 
 /// list of internal tests:
@@ -21,6 +21,7 @@ in the file LICENSE in the MIT Proto distribution's top directory. */
 
 #include "compiler.h"
 #include "plugin_manager.h"
+#include "profiler.h"
 #include "proto_opcodes.h"
 #include "scoped_ptr.h"
 
@@ -43,6 +44,8 @@ struct Instruction : public CompilationElement { reflection_sub(Instruction,CE);
   Block* container;
   /// index in opcode chain, unknown=-1
   int location; 
+  /// position in the emitter's flattened layout, -1 if never laid out
+  int layout_index;
   /// instructions "neighboring" this one
   set<Instruction*, CompilationElement_cmp> dependents;
   /// instruction's opcode
@@ -56,7 +59,7 @@ struct Instruction : public CompilationElement { reflection_sub(Instruction,CE);
 
   Instruction(OPCODE op, int ed=0) {
     this->op=op; stack_delta=op_stackdeltas[op]; env_delta=ed; 
-    location=-1; next=prev=NULL; container = NULL;
+    location=-1; layout_index=-1; next=prev=NULL; container = NULL;
   }
   virtual void print(ostream* out=0) {
     *out << (opnames.count(op) ? opnames[op] : "<UNKNOWN OP>");
@@ -628,6 +631,26 @@ struct Feedback : public Instruction {
   }
 };
 
+/// A pair of parameterless instructions fused into one VM superinstruction
+struct Superinstruction : public Instruction {
+  reflection_sub(Superinstruction,Instruction);
+  Instruction *first, *second;
+  Superinstruction(OPCODE op, Instruction* first, Instruction* second)
+    : Instruction(op) {
+    this->first=first; this->second=second;
+    stack_delta = first->net_stack_delta() + second->net_stack_delta();
+    env_delta = first->net_env_delta() + second->net_env_delta();
+  }
+  virtual int max_env_delta() {
+    return max(first->max_env_delta(),
+               first->net_env_delta() + second->max_env_delta());
+  }
+  virtual int max_stack_delta() {
+    return max(first->max_stack_delta(),
+               first->net_stack_delta() + second->max_stack_delta());
+  }
+};
+
 /*****************************************************************************
  *  PROPAGATOR                                                               *
  *****************************************************************************/
@@ -639,11 +662,11 @@ class InstructionPropagator : public CompilationElement {
   int loop_abort; // # equivalent passes through worklist before assuming loop
   // propagation work variables
   set<Instruction*, CompilationElement_cmp> worklist_i;
-  bool any_changes;
+  bool any_changes; int num_changes;
   Instruction* root;
   
   InstructionPropagator(int abort=10) { loop_abort=abort; }
-  bool propagate(Instruction* chain); // act on worklist until empty
+  virtual bool propagate(Instruction* chain); // act on worklist until empty
   virtual void preprop() {} virtual void postprop() {} // hooks
   // action routines to be filled in by inheritors
   virtual void act(Instruction* i) {}
@@ -657,7 +680,7 @@ class InstructionPropagator : public CompilationElement {
 CompilationElement* isrc;
 set<CompilationElement*, CompilationElement_cmp> iqueued;
 void InstructionPropagator::note_change(Instruction* i) 
-{ iqueued.clear(); any_changes=true; isrc=i; queue_nbrs(i); }
+{ iqueued.clear(); any_changes=true; num_changes++; isrc=i; queue_nbrs(i); }
 void InstructionPropagator::queue_nbrs(Instruction* i, int marks) {
   if(i->prev) worklist_i.insert(i->prev); // sequence neighbors
   if(i->next) worklist_i.insert(i->next);
@@ -677,12 +700,14 @@ void InstructionPropagator::queue_chain(Instruction* chain) {
 
 bool InstructionPropagator::propagate(Instruction* chain) {
   V1 << "Executing analyzer " << to_str() << ":"; V2 << endl;
-  any_changes=false; root = chain_start(chain);
+  double start = compiler_profiler ? get_real_secs() : 0;
+  any_changes=false; num_changes=0; root = chain_start(chain);
   // initialize worklists
   worklist_i.clear(); queue_chain(chain); 
   // walk through worklists until empty
   preprop();
   int steps_remaining = loop_abort*(worklist_i.size());
+  int steps_allotted = steps_remaining;
   while(steps_remaining>0 && !worklist_i.empty()) {
     // each time through, try executing one from each worklist
     if(!worklist_i.empty()) {
@@ -692,6 +717,10 @@ bool InstructionPropagator::propagate(Instruction* chain) {
   }
   if(steps_remaining<=0) ierror("Aborting due to apparent infinite loop.");
   postprop();
+  if(compiler_profiler)
+    compiler_profiler->note_rule(to_str(),"InstructionPropagator",
+                                 steps_allotted-steps_remaining,num_changes,
+                                 any_changes,get_real_secs()-start);
   V2 << "Finished analyzer " << to_str() << ":";
   V1 << " changes = " << b2s(any_changes) << endl;
   return any_changes;
@@ -1193,129 +1222,279 @@ public:
   }
 };
 
-class ResolveISizes : public InstructionPropagator {
+// Resolves instruction sizes, global indices, and locations.  The chain is
+// flattened into a vector (blocks before their contents), then laid out in
+// three linear passes rather than iterated to a fixed point:
+//  1. global indices, and the references that depend on them;
+//  2. sizes, back to front: branch offsets and function sizes only cover
+//     instructions later in the same chain, so these are always sized first
+//     and a change in branch size needs no relaxation of anything earlier;
+//  3. locations, front to back.
+// Sizes that are still unknown (e.g. let references not yet sized by
+// StackEnvSizer) leave dependent values alone until the next pass.
+class LayoutInstructions : public InstructionPropagator {
 public:
-  ResolveISizes(ProtoKernelEmitter* parent,Args* args) 
-  { verbosity = parent->verbosity; }
-  void print(ostream* out=0) { *out<<"ResolveISizes"; }
-  void act(Instruction* i) {
-    if(i->isA("iDEF_FUN")) {
-      iDEF_FUN *df = &dynamic_cast<iDEF_FUN &>(*i);
-      bool ok=true; int size=1; // return's size
-      Instruction* j = df->next;
-      while(j!=df->ret) {
-        if(j->size()>=0) size += j->size(); else ok=false;
-        j=j->next;  if(!j) ierror("DEF_FUN_OP can't find matching RET_OP");
-      }
-      if(size>0 && df->fun_size != size) {
-        V2 << "Fun size is " << size << endl;
-        df->fun_size=size; df->parameters.clear();
-        // now adjust the op
-        if(df->fun_size>1 && df->fun_size<=MAX_DEF_FUN_OPS) 
-          df->op=(DEF_FUN_2_OP+(df->fun_size-2));
-        else
-          { df->op = DEF_FUN_OP; df->padd(df->fun_size); }
-        note_change(i);
+  ProtoKernelEmitter* emitter;
+  LayoutInstructions(ProtoKernelEmitter* parent,Args* args) {
+    verbosity = parent->verbosity;
+    emitter = parent;
+  }
+  void print(ostream* out=0) { *out<<"LayoutInstructions"; }
+
+  bool propagate(Instruction* chain) {
+    V1 << "Executing analyzer " << to_str() << ":"; V2 << endl;
+    double start = compiler_profiler ? get_real_secs() : 0;
+    any_changes=false; num_changes=0; root = chain_start(chain);
+    layout.clear(); flatten(root,-1);
+    resolve_indices(); resolve_sizes(); resolve_locations();
+    if(compiler_profiler)
+      compiler_profiler->note_rule(to_str(),"InstructionPropagator",
+                                   layout.size(),num_changes,any_changes,
+                                   get_real_secs()-start);
+    V2 << "Finished analyzer " << to_str() << ":";
+    V1 << " changes = " << b2s(any_changes) << endl;
+    return any_changes;
+  }
+
+private:
+  struct Slot {
+    Instruction* i;
+    int parent; // index of containing block, -1 at top level
+    int next; // index of next instruction in the same chain, -1 at end
+    int size; // -1 if not yet known
+    // bytes from the start of this instruction to the end of its chain,
+    // and how many instructions in that span are of unknown size
+    int tail_bytes, tail_unknown;
+  };
+  vector<Slot> layout;
+
+  void changed() { any_changes=true; num_changes++; }
+
+  void flatten(Instruction* chain, int parent) {
+    int prev=-1;
+    for(Instruction* i=chain; i; i=i->next) {
+      int k = layout.size();
+      Slot s; s.i=i; s.parent=parent; s.next=-1; s.size=-1;
+      s.tail_bytes=0; s.tail_unknown=0;
+      layout.push_back(s); i->layout_index=k;
+      if(prev>=0) layout[prev].next=k;
+      prev=k;
+      if(i->isA("Block")) flatten(dynamic_cast<Block &>(*i).contents,k);
+    }
+  }
+
+  // Slot of an instruction that must follow slot k in the same chain
+  int later_sibling(int k, Instruction* i) {
+    int j = i->layout_index;
+    if(j<=k || j>=layout.size() || layout[j].i!=i ||
+       layout[j].parent!=layout[k].parent)
+      ierror("Instruction "+ce2s(layout[k].i)+" refers outside its chain to "+
+             ce2s(i));
+    return j;
+  }
+  int bytes_after(int k)
+  { return layout[k].next<0 ? 0 : layout[layout[k].next].tail_bytes; }
+  int unknown_after(int k)
+  { return layout[k].next<0 ? 0 : layout[layout[k].next].tail_unknown; }
+
+  // Each global's index is its position among the globals of its chain
+  void resolve_indices() {
+    vector<int> n_globals(layout.size()+1,0); // indexed by parent+1
+    g_max = 0;
+    for(int k=0;k<layout.size();k++) {
+      if(!layout[k].i->isA("Global")) continue;
+      Global* g = &dynamic_cast<Global &>(*layout[k].i);
+      int index = n_globals[layout[k].parent+1]++;
+      g_max = max(g_max, index+1);
+      if(g->index!=index) {
+        V4 << "Setting index of "<<ce2s(g)<<" to "<<index<<endl;
+        g->index=index; changed();
       }
     }
-    if(i->isA("Reference")) {
-      Reference* r = &dynamic_cast<Reference &>(*i);
-      if(r->offset==-1 && r->store->isA("Global") && 
-         dynamic_cast<Global &>(*r->store).index >= 0) {
-        V2<<"Global index to "<<ce2s(r->store)<<" is "<<
-          dynamic_cast<Global &>(*r->store).index << endl;
-        r->set_offset(dynamic_cast<Global &>(*r->store).index);
-        note_change(i);
-      }
-    } 
-    if(i->isA("Branch")) {
-      Branch* b = &dynamic_cast<Branch &>(*i);
-      Instruction* target = b->after_this;
-      V5<<"Sizing branch: "<<ce2s(b)<<" over "<<ce2s(target)<<endl;
-      if(b->start_location()>=0 && target->start_location()>=0) {
-        int diff = target->next_location() - b->next_location();
-        if(diff!=b->offset) {
-          V2<<"Branch offset to follow "<<ce2s(target)<<" is "<<diff<<endl;
-          b->set_offset(diff); note_change(i);
+    for(int k=0;k<layout.size();k++) {
+      Instruction* i = layout[k].i;
+      if(i->isA("Reference")) {
+        Reference* r = &dynamic_cast<Reference &>(*i);
+        if(r->offset==-1 && r->store->isA("Global") && 
+           dynamic_cast<Global &>(*r->store).index >= 0) {
+          V2<<"Global index to "<<ce2s(r->store)<<" is "<<
+            dynamic_cast<Global &>(*r->store).index << endl;
+          r->set_offset(dynamic_cast<Global &>(*r->store).index);
+          changed();
         }
       }
-    }
-  }
-};
-
-class ResolveLocations : public InstructionPropagator {
-public:
-  // Note: a possible concern: it's theoretically possible
-  // to end up in an infinite loop when location is being nudged
-  // such that reference lengths change, which could change op size
-  // and therefore location...
-  ProtoKernelEmitter* emitter;
-  ResolveLocations(ProtoKernelEmitter* parent,Args* args) { 
-     verbosity = parent->verbosity; 
-     emitter = parent;
-  }
-  void print(ostream* out=0) { *out<<"ResolveLocations"; }
-  void maybe_set_location(Instruction* i, int l) {
-    if(i->start_location() != l) { 
-      V4 << "Setting location of "<<ce2s(i)<<" to "<<l<<endl;
-      i->set_location(l); note_change(i);
-    } 
-  }
-  void maybe_set_index(Instruction* i, int l) {
-    g_max = max(g_max, l + 1);
-    if(dynamic_cast<Global &>(*i).index != l) {
-      V4 << "Setting index of "<<ce2s(i)<<" to "<<l<<endl;
-      dynamic_cast<Global &>(*i).index = l;
-      note_change(i);
-    }
-  }
-  void maybe_set_reference(Reference* i,int index) {
-    if(i->offset!=index) { 
-      V4 << "Setting reference offset "<<ce2s(i)<<" to "<<index<<endl;
-      i->set_offset(index); note_change(i);
-    }
-  }
-  void act(Instruction* i) {
-    // Base case: set to zero or block-start
-    if(!i->prev)
-      maybe_set_location(i,(i->container?i->container->start_location():0));
-    // Otherwise get it from previous instruction
-    if(i->prev && i->prev->next_location()>=0)
-      { maybe_set_location(i,i->prev->next_location()); }
-    if(i->isA("Global")) {
-      Instruction *ptr = i->prev; // find previous global...
-      while (ptr && !ptr->isA("Global"))
-        ptr = ptr->prev;
-      if (ptr) {
-        Global *g_prev = &dynamic_cast<Global &>(*ptr);
-        ptr->dependents.insert(i); // make sure we'll get triggered when it sets
-        if(g_prev->index!=-1) maybe_set_index(i,g_prev->index+1);
-      } else { maybe_set_index(i,0); }
-    }
-    //if we can resolve the function call to its global index
-    if(i->isA("FunctionCall")) {
-       CompoundOp *compoundOp = dynamic_cast<FunctionCall &>(*i).compoundOp;
-       map<CompoundOp *, Block *>::const_iterator iterator
-         = emitter->globalNameMap.find(compoundOp);
-       if (iterator != emitter->globalNameMap.end()) {
+      // if we can resolve the function call to its global index
+      if(i->isA("FunctionCall") && i->prev && i->prev->isA("Reference")) {
+        CompoundOp *compoundOp = dynamic_cast<FunctionCall &>(*i).compoundOp;
+        map<CompoundOp *, Block *>::const_iterator iterator
+          = emitter->globalNameMap.find(compoundOp);
+        if (iterator != emitter->globalNameMap.end()) {
           Instruction *fnstart = (*iterator).second->contents;
           int index = -1;
           if (fnstart && fnstart->isA("Global"))
-             index = dynamic_cast<Global &>(*fnstart).index;
-          if(index >= 0 && i->prev && i->prev->isA("Reference"))
-            maybe_set_reference(&dynamic_cast<Reference &>(*i->prev), index);
-       }
+            index = dynamic_cast<Global &>(*fnstart).index;
+          Reference* r = &dynamic_cast<Reference &>(*i->prev);
+          if(index >= 0 && r->offset!=index) {
+            V4 << "Setting reference offset "<<ce2s(r)<<" to "<<index<<endl;
+            r->set_offset(index); changed();
+          }
+        }
+      }
     }
   }
-  int g_max; // highest global index seen
-  void preprop() { g_max = 0; }
-  void postprop() {
+
+  void resolve_sizes() {
+    for(int k=layout.size()-1;k>=0;k--) {
+      Instruction* i = layout[k].i;
+      if(i->isA("iDEF_FUN")) resolve_function(k);
+      if(i->isA("Branch")) resolve_branch(k);
+      int size;
+      if(i->isA("Block")) { // contents, if any, start in the next slot
+        bool empty = k+1>=layout.size() || layout[k+1].parent!=k;
+        size = empty ? 0 : (layout[k+1].tail_unknown ? -1 : 
+                            layout[k+1].tail_bytes);
+      } else {
+        size = i->size();
+      }
+      layout[k].size = size;
+      layout[k].tail_bytes = bytes_after(k) + max(size,0);
+      layout[k].tail_unknown = unknown_after(k) + (size<0 ? 1 : 0);
+    }
+  }
+
+  void resolve_function(int k) {
+    iDEF_FUN *df = &dynamic_cast<iDEF_FUN &>(*layout[k].i);
+    if(!df->ret) ierror("DEF_FUN_OP can't find matching RET_OP");
+    int r = later_sibling(k,df->ret);
+    if(unknown_after(k)!=layout[r].tail_unknown) return;
+    int size = 1 + bytes_after(k) - layout[r].tail_bytes; // +1 for return
+    if(df->fun_size != size) {
+      V2 << "Fun size is " << size << endl;
+      df->fun_size=size; df->parameters.clear();
+      // now adjust the op
+      if(df->fun_size>1 && df->fun_size<=MAX_DEF_FUN_OPS) 
+        df->op=(DEF_FUN_2_OP+(df->fun_size-2));
+      else
+        { df->op = DEF_FUN_OP; df->padd(df->fun_size); }
+      changed();
+    }
+  }
+
+  // A branch skips everything after it, through its target
+  void resolve_branch(int k) {
+    Branch* b = &dynamic_cast<Branch &>(*layout[k].i);
+    V5<<"Sizing branch: "<<ce2s(b)<<" over "<<ce2s(b->after_this)<<endl;
+    int t = later_sibling(k,b->after_this);
+    if(unknown_after(k)!=unknown_after(t)) return;
+    int diff = bytes_after(k) - bytes_after(t);
+    if(diff!=b->offset) {
+      V2<<"Branch offset to follow "<<ce2s(b->after_this)<<" is "<<diff<<endl;
+      b->set_offset(diff); changed();
+    }
+  }
+
+  void resolve_locations() {
+    // next free location in each chain, indexed by parent+1; -1 if unknown
+    vector<int> next(layout.size()+1,-1);
+    next[0]=0;
+    for(int k=0;k<layout.size();k++) {
+      Instruction* i = layout[k].i; int p = layout[k].parent+1;
+      int l = next[p];
+      if(l>=0 && i->start_location()!=l) {
+        V4 << "Setting location of "<<ce2s(i)<<" to "<<l<<endl;
+        i->set_location(l); changed();
+      }
+      if(i->isA("Block")) next[k+1] = l; // contents start with the block
+      next[p] = (l>=0 && layout[k].size>=0) ? l+layout[k].size : -1;
+    }
     iDEF_VM* dv = &dynamic_cast<iDEF_VM &>(*root);
     if(dv->n_globals!=g_max) {
       V3 << "Setting global max from "<<dv->n_globals<<" to "<<g_max<<endl;
-      dv->n_globals=g_max; any_changes|=true;
+      dv->n_globals=g_max; changed();
     }
   }
+
+  int g_max; // highest global index seen
+};
+
+// Superinstructions the VM implements natively.  The pairs were chosen by
+// frequency in the emitted scripts of the test suite and demos (counts are
+// out of ~2000 emitted instructions): LET_1 REF_0 (29), REF_0 REF_1 (20),
+// REF_0 REF_0 (15), REF_0 POP_LET_1 (15), REF_0 ADD (8), POP_LET_1 ADD (8),
+// REF_1 MAX (8), REF_1 MIN (7); LIT_1 ADD is the counter idiom.  The
+// REF_1 MAX/MIN pairs run once per neighbor, inside max-hood and min-hood.
+struct SuperinstructionPattern { OPCODE first, second, fused; };
+static const SuperinstructionPattern superinstruction_patterns[] = {
+  { LET_1_OP, REF_0_OP, LET_1_REF_0_OP },
+  { REF_0_OP, POP_LET_1_OP, REF_0_POP_LET_1_OP },
+  { REF_0_OP, REF_0_OP, REF_0_REF_0_OP },
+  { REF_0_OP, REF_1_OP, REF_0_REF_1_OP },
+  { REF_0_OP, ADD_OP, REF_0_ADD_OP },
+  { POP_LET_1_OP, ADD_OP, POP_LET_1_ADD_OP },
+  { REF_1_OP, MAX_OP, REF_1_MAX_OP },
+  { REF_1_OP, MIN_OP, REF_1_MIN_OP },
+  { LIT_1_OP, ADD_OP, LIT_1_ADD_OP },
+};
+
+// Peephole pass: fuses adjacent instruction pairs into superinstructions,
+// left to right within each chain.  Must run after all other resolution,
+// since it discards the Reference/iLET/PopLet objects it fuses; only
+// parameterless, non-control instructions are candidates, so branches and
+// function boundaries are never split.  Layout must be redone afterward.
+class FuseSuperinstructions : public InstructionPropagator {
+public:
+  FuseSuperinstructions(ProtoKernelEmitter* parent) 
+  { verbosity = parent->verbosity; }
+  void print(ostream* out=0) { *out<<"FuseSuperinstructions"; }
+
+  bool propagate(Instruction* chain) {
+    V1 << "Executing analyzer " << to_str() << ":"; V2 << endl;
+    double start = compiler_profiler ? get_real_secs() : 0;
+    any_changes=false; num_changes=0; root = chain_start(chain);
+    int n_fused = fuse(&root);
+    if(compiler_profiler)
+      compiler_profiler->note_rule(to_str(),"InstructionPropagator",n_fused,
+                                   num_changes,any_changes,
+                                   get_real_secs()-start);
+    V2 << "Fused " << n_fused << " superinstructions\n";
+    V1 << " changes = " << b2s(any_changes) << endl;
+    return any_changes;
+  }
+
+private:
+  static bool fusable(Instruction* i) {
+    return i->size()==1 && !i->isA("Block") && !i->isA("Branch") &&
+      !i->isA("Global") && !i->isA("FunctionCall") &&
+      !i->isA("Superinstruction");
+  }
+  static int fused_op(Instruction* a, Instruction* b) {
+    for(int k=0;k<sizeof(superinstruction_patterns)/
+                  sizeof(superinstruction_patterns[0]);k++) {
+      const SuperinstructionPattern &p = superinstruction_patterns[k];
+      if(a->op==p.first && b->op==p.second) return p.fused;
+    }
+    return -1;
+  }
+  // Returns number of fusions in the chain starting at *head
+  int fuse(Instruction** head) {
+    int n_fused=0;
+    for(Instruction* i=*head; i; i=i->next) {
+      if(i->isA("Block"))
+        n_fused += fuse(&dynamic_cast<Block &>(*i).contents);
+      Instruction* j = i->next;
+      if(!j || !fusable(i) || !fusable(j)) continue;
+      int op = fused_op(i,j);
+      if(op<0) continue;
+      Superinstruction* s = new Superinstruction(op,i,j);
+      V3 << "Fusing " << ce2s(i) << " and " << ce2s(j) << endl;
+      s->container=i->container; s->location=i->location;
+      s->prev=i->prev; s->next=j->next;
+      if(s->prev) s->prev->next=s; else *head=s;
+      if(s->next) s->next->prev=s;
+      i=s; n_fused++; any_changes=true; num_changes++;
+    }
+    return n_fused;
+  }
 };
 
 // Counts states and exports, and compute stack deltas.
@@ -2208,7 +2387,10 @@ ProtoKernelEmitter::load_ops(const string &name)
 // Load a .proto file named `name', containing not Proto code but
 // Paleo-style op extensions of the form
 //
-//   (defop <opcode> <primitive> <argument-type>*)
+//   (defop <opcode> <primitive> <argument-type>* <:attribute>*)
+//
+// where attributes are markers like those of primitive definitions, e.g.
+// :side-effect for an actuator whose result may go unused.
 
 void
 ProtoKernelEmitter::load_extension_ops(const string &filename)
@@ -2222,6 +2404,7 @@ ProtoKernelEmitter::load_extension_ops(const string &filename)
       compile_error("Can't open extension op file: " + filename);
       return;
     }
+    parent->proto_path.note_read(filename);
 
     sexpr = read_sexpr(filename, &stream);
   }
@@ -2348,8 +2531,10 @@ ProtoKernelEmitter::process_extension_op(SExpr *sexpr)
     return;
   signature->output = type;
 
-  size_t nargs = list.len() - 4;
-  for (size_t i = 4; i < list.len(); i++)
+  size_t end = 4;
+  while (end < list.len() && !list[end]->isKeyword()) end++;
+  size_t nargs = end - 4;
+  for (size_t i = 4; i < end; i++)
     if (0 != (type = parse_paleotype(list[i])))
       signature->required_inputs.push_back(type);
     else
@@ -2369,8 +2554,16 @@ ProtoKernelEmitter::process_extension_op(SExpr *sexpr)
   op_stackdeltas[opcode] = 1 - nargs;
   primitive2op[name] = opcode;
 
-  parent->interpreter->toplevel->force_bind
-    (name, new Primitive(sexpr, name, signature.release()));
+  Primitive *primitive = new Primitive(sexpr, name, signature.release());
+  for (size_t i = end; i < list.len(); i++) {
+    if (!list[i]->isKeyword()) {
+      compile_error(list[i], list[i]->to_str() + " not a keyword");
+      return;
+    }
+    primitive->attributes[dynamic_cast<SE_Symbol &>(*list[i]).name] =
+      new MarkerAttribute(true);
+  }
+  parent->interpreter->toplevel->force_bind(name, primitive);
 }
 
 // small hack for getting op debugging into low-level print functions
@@ -2388,6 +2581,7 @@ ProtoKernelEmitter::ProtoKernelEmitter(NeoCompiler *parent, Args *args)
   max_loops=args->extract_switch("--emitter-max-loops") ? args->pop_int() : 10;
   paranoid = args->extract_switch("--emitter-paranoid") | parent->paranoid;
   op_debug = args->extract_switch("--emitter-op-debug");
+  is_superinstructions = args->extract_switch("--superinstructions");
   // Load operation definitions.
   load_ops("core.ops");
   terminate_on_error();
@@ -2397,8 +2591,7 @@ ProtoKernelEmitter::ProtoKernelEmitter(NeoCompiler *parent, Args *args)
   // Setup rule collection.
   rules.push_back(new DeleteNulls(this, args));
   rules.push_back(new InsertLetPops(this, args));
-  rules.push_back(new ResolveISizes(this, args));
-  rules.push_back(new ResolveLocations(this, args));
+  rules.push_back(new LayoutInstructions(this, args));
   rules.push_back(new StackEnvSizer(this, args));
   rules.push_back(new ResolveState(this, args));
   // Program starts empty.
@@ -2674,6 +2867,7 @@ uint8_t* ProtoKernelEmitter::emit_from(DFG* g, int* len) {
   // Fill in all of the blanks
   V1<<"Resolving unknowns in instruction sequence...\n";
   for(int i=0;i<max_loops;i++) {
+    if(compiler_profiler) compiler_profiler->note_loop();
     bool changed=false;
     for(int j=0;j<rules.size();j++) {
       changed |= rules[j]->propagate(start); terminate_on_error();
@@ -2682,6 +2876,12 @@ uint8_t* ProtoKernelEmitter::emit_from(DFG* g, int* len) {
     if(i==(max_loops-1))
       compile_warn("Emitter analyzer giving up after "+i2s(max_loops)+" loops");
   }
+  if(is_superinstructions) {
+    V1<<"Fusing superinstructions...\n";
+    FuseSuperinstructions fuser(this);
+    if(fuser.propagate(start))
+      { LayoutInstructions relayout(this,NULL); relayout.propagate(start); }
+  }
   CheckResolution rchecker(this); rchecker.propagate(start);
   
   // finally, output
@@ -74,54 +74,44 @@ SExpr* sexp_err(CompilationElement *where,string msg) {
  *****************************************************************************/
 
 // specials are the tokens that are hard-wired in and thus can't be shadowed
-set<string> special_tokens;
+set<int> special_tokens;
 bool specials_populated = false;
 
 void populate_specials() {
   if (specials_populated)
     return;
-  special_tokens.insert("all");
-  special_tokens.insert("annotate");
-  special_tokens.insert("def");
-  special_tokens.insert("false");
-  special_tokens.insert("fun");
-  special_tokens.insert("include");
-  special_tokens.insert("lambda");
-  special_tokens.insert("let");
-  special_tokens.insert("let*");
-  special_tokens.insert("letfed");
-  special_tokens.insert("letfed+");
-  special_tokens.insert("macro");
-  special_tokens.insert("primitive");
-  special_tokens.insert("restrict");
-  special_tokens.insert("true");
-  special_tokens.insert("tup");
+  const char* specials[] = {
+    "all", "annotate", "def", "false", "fun", "include", "lambda", "let",
+    "let*", "letfed", "letfed+", "macro", "primitive", "restrict", "true",
+    "tup", NULL };
+  for (int i = 0; specials[i] != NULL; i++)
+    special_tokens.insert(SymbolTable::intern(specials[i]));
   specials_populated = true;
 }
 
 bool is_special(SExpr* s) {
   if(!s->isSymbol()) return false;
-  return special_tokens.count(dynamic_cast<SE_Symbol &>(*s).name);
+  return special_tokens.count(dynamic_cast<SE_Symbol &>(*s).id);
 }
 
 // tokens that need to be always available to the interpreter, for 
 // expressions that have a syntactic component
-void Env::bind(string name, CompilationElement* value) {
-  if(bindings.count(name)) 
-    compile_error(value,"Cannot bind '"+name+"': already bound");
-  force_bind(name,value);
+void Env::bind(int id, CompilationElement* value) {
+  if(bindings.count(id)) 
+    compile_error(value,"Cannot bind '"+SymbolTable::name(id)+"': already bound");
+  force_bind(id,value);
 }
 
-void Env::force_bind(string name, CompilationElement* value) {
-  if(special_tokens.count(name)) 
-    compile_error(value,"Cannot bind '"+name+"': symbol is reserved");
-  else if(core_ops.count(name))
-    compile_warn(value,"shadowing core operator '"+name+"'");
-  bindings[name]=value;
+void Env::force_bind(int id, CompilationElement* value) {
+  if(special_tokens.count(id)) 
+    compile_error(value,"Cannot bind '"+SymbolTable::name(id)+"': symbol is reserved");
+  else if(core_ops.count(id))
+    compile_warn(value,"shadowing core operator '"+SymbolTable::name(id)+"'");
+  bindings[id]=value;
 }
 
 CompilationElement* Env::lookup(SE_Symbol* sym, string type) {
-  CompilationElement* found = lookup(sym->name);
+  CompilationElement* found = lookup(sym->id);
   if(found) {
     if(found->isA(type)) return found;
     else compile_error(sym,sym->name+" is "+found->type_of()+", not "+type);
@@ -129,30 +119,33 @@ CompilationElement* Env::lookup(SE_Symbol* sym, string type) {
   return dummy(type,sym);
 }
 
-CompilationElement* Env::lookup(string name, bool recursed) {
-  if(bindings.count(name)) { return bindings[name]; // local search
-  } else if(parent) { return parent->lookup(name); // search through parents
-  } else if(!recursed) { // check for a file to define it
-    string fname = name + ".proto";
+CompilationElement* Env::lookup(int id, bool recursed) {
+  for(Env* e=this; e; e=e->parent) { // search locally, then through parents
+    map<int,CompilationElement*>::const_iterator i = e->bindings.find(id);
+    if(i!=e->bindings.end()) return i->second;
+  }
+  if(!recursed) { // check for a file to define it
+    string fname = SymbolTable::name(id) + ".proto";
     if(cp->parent->proto_path.find_in_path(fname)) {
       cp->interpret_file(fname);
-      return lookup(name,true);
+      return lookup(id,true);
     }
   }
  return NULL;
 }
 
 // Access to operators that the compiler must be able to get at unshadowed
-map<string,Operator*> Env::core_ops;
+map<int,Operator*> Env::core_ops;
 void Env::record_core_ops(Env* toplevel) {
-  map<string,CompilationElement*>::iterator i;
+  map<int,CompilationElement*>::iterator i;
   for(i=toplevel->bindings.begin();i!=toplevel->bindings.end();i++)
     if(i->second->isA("Operator"))
       core_ops[i->first]=&dynamic_cast<Operator &>(*i->second);
 }
 Operator* Env::core_op(string name) {
-  if(!core_ops.count(name)) ierror("Compiler missing core operator '"+name+"'");
-  return core_ops[name];
+  int id = SymbolTable::intern(name);
+  if(!core_ops.count(id)) ierror("Compiler missing core operator '"+name+"'");
+  return core_ops[id];
 }
 
 
@@ -346,27 +339,29 @@ SExpr* ProtoInterpreter::macro_substitute(SExpr* src, Env* e, SE_List* wrapper)
   if(is_gensym(src)) { // substitute with a gensym for this instance
     SE_Symbol *groot = &dynamic_cast<SE_Symbol &>(*src);
     SExpr *gensym;
-    CompilationElement *element = e->lookup(groot->name);
+    CompilationElement *element = e->lookup(groot->id);
     if (element == 0) {
       gensym = make_gensym(groot->name);
       gensym->inherit_attributes(src);
-      e->bind(groot->name, gensym);
+      e->bind(groot->id, gensym);
     } else {
       gensym = &dynamic_cast<SExpr &>(*element);
     }
     return gensym;
   } else if(src->isList()) { // SE_List
+    static const int comma = SymbolTable::intern("comma");
+    static const int comma_splice = SymbolTable::intern("comma-splice");
     SE_List *srcl = &dynamic_cast<SE_List &>(*src);
-    string opname
-      = ((*srcl)[0]->isSymbol() ? dynamic_cast<SE_Symbol &>(*(*srcl)[0]).name
-         : "");
-    if(opname=="comma") {
+    int opid
+      = ((*srcl)[0]->isSymbol() ? dynamic_cast<SE_Symbol &>(*(*srcl)[0]).id
+         : -1);
+    if(opid==comma) {
       if(srcl->len()!=2 || !(*srcl)[1]->isSymbol())
         return sexp_err(src,"Bad comma form: "+src->to_str());
       SE_Symbol* sn = &dynamic_cast<SE_Symbol &>(*(*srcl)[1]);
       // insert source text
       return dynamic_cast<SExpr &>(*e->lookup(sn,"SExpr")).copy();
-    } else if(opname=="comma-splice") {
+    } else if(opid==comma_splice) {
       if(wrapper==NULL)
         return sexp_err(src,"Comma-splice "+(*srcl)[0]->to_str()+" w/o list");
       if(srcl->len()!=2 || !(*srcl)[1]->isSymbol())
@@ -552,7 +547,7 @@ Field* ProtoInterpreter::let_to_graph(SE_List* s, AM* space, Env *env,
       if(d->len()==2 && (*d)[0]->isSymbol()) {
         V4 << "Creating let variable "<<ce2s((*d)[0])<<endl;
         Field* f = sexp_to_graph((*d)[1],space,(incremental?child:env));
-        child->bind(dynamic_cast<SE_Symbol &>(*(*d)[0]).name, f);
+        child->bind(dynamic_cast<SE_Symbol &>(*(*d)[0]).id, f);
       } else compile_error(d,"Malformed let statement: "+d->to_str());
     } else compile_error((*decls)[i],"Malformed let statement: "+
                          (*decls)[i]->to_str());
@@ -755,7 +750,7 @@ Field* ProtoInterpreter::sexp_to_graph(SExpr* s, AM* space, Env *env) {
   V3 << "Interpret: " << ce2s(s) << " in " << ce2s(space) << endl;
   if(s->isSymbol()) {
     // All other symbols are looked up in the environment
-    CompilationElement* elt = env->lookup(dynamic_cast<SE_Symbol &>(*s).name);
+    CompilationElement* elt = env->lookup(dynamic_cast<SE_Symbol &>(*s).id);
     if(elt==NULL) { 
       V4 << "Symbolic literal?\n";
       ProtoType* val = symbolic_literal(dynamic_cast<SE_Symbol &>(*s).name);
@@ -794,7 +789,8 @@ Field* ProtoInterpreter::sexp_to_graph(SExpr* s, AM* space, Env *env) {
     if(sl->len()==0) return field_err(sl,space,"Expression has no members"); 
     if(sl->op()->isSymbol()) { 
       // check if it's a special form
-      string opname = dynamic_cast<SE_Symbol &>(*sl->op()).name;
+      SE_Symbol *opsym = &dynamic_cast<SE_Symbol &>(*sl->op());
+      const string &opname = opsym->name;
       if(opname=="let") { return let_to_graph(sl,space,env,false);
       } else if(opname=="let*") { return let_to_graph(sl,space,env,true);
       } else if(opname=="all") { // evaluate children, returning last field
@@ -809,7 +805,7 @@ Field* ProtoInterpreter::sexp_to_graph(SExpr* s, AM* space, Env *env) {
         if(!def->isSymbol())
           return field_err(sl,space,"def name not a symbol: "+def->to_str());
         Field* f = sexp_to_graph(exp,space,env);
-        env->force_bind(dynamic_cast<SE_Symbol &>(*def).name,f);
+        env->force_bind(dynamic_cast<SE_Symbol &>(*def).id,f);
         V4 << "Defined variable: " << ce2s(f) << endl;
         return f;
       } else if(opname=="def" || opname=="primitive" || 
@@ -854,7 +850,7 @@ Field* ProtoInterpreter::sexp_to_graph(SExpr* s, AM* space, Env *env) {
         return field_err(sl,space,"Quasiquote only allowed in macros: "+sl->to_str());
       }
       // check if it's a macro
-      CompilationElement* ce = env->lookup(opname);
+      CompilationElement* ce = env->lookup(opsym->id);
       if(ce && ce->isA("Macro")) {
         V4 << "Applying macro\n";
         SExpr* new_expr;
@@ -15,6 +15,7 @@ in the file LICENSE in the MIT Proto distribution's top directory. */
 
 #include "compiler.h"
 #include "nicenames.h"
+#include "profiler.h"
 
 using namespace std;
 
@@ -902,11 +903,11 @@ void IRPropagator::queue_nbrs(AM* am, int marks) {
 }
 
 void IRPropagator::note_change(AM* am) 
-{ queued.clear(); any_changes=true; src=am; queue_nbrs(am); }
+{ queued.clear(); any_changes=true; num_changes++; src=am; queue_nbrs(am); }
 void IRPropagator::note_change(Field* f) 
-{ queued.clear(); any_changes=true; src=f; queue_nbrs(f); }
+{ queued.clear(); any_changes=true; num_changes++; src=f; queue_nbrs(f); }
 void IRPropagator::note_change(OperatorInstance* oi) 
-{ queued.clear(); any_changes=true; src=oi; queue_nbrs(oi); }
+{ queued.clear(); any_changes=true; num_changes++; src=oi; queue_nbrs(oi); }
 
 bool IRPropagator::maybe_set_range(Field* f,ProtoType* range) {
   if(!ProtoType::equal(f->range,range)) { 
@@ -920,7 +921,8 @@ bool IRPropagator::maybe_set_range(Field* f,ProtoType* range) {
 
 bool IRPropagator::propagate(DFG* g) {
   V1 << "Executing analyzer " << to_str(); V1 << endl;
-  any_changes=false; root=g;
+  double start = compiler_profiler ? get_real_secs() : 0;
+  any_changes=false; num_changes=0; root=g;
   // initialize worklists
   if(act_fields) queue_all_fields(g,this); else worklist_f.clear();
   if(act_ops) queue_all_ops(g,this); else worklist_o.clear();
@@ -929,6 +931,7 @@ bool IRPropagator::propagate(DFG* g) {
   preprop();
   int steps_remaining = 
     1+loop_abort*(worklist_f.size()+worklist_o.size()+worklist_a.size());
+  int steps_allotted = steps_remaining;
   while(steps_remaining>0 && 
         (!worklist_f.empty() || !worklist_o.empty() || !worklist_a.empty())) {
     // each time through, try executing one from each worklist
@@ -951,6 +954,10 @@ bool IRPropagator::propagate(DFG* g) {
   if(steps_remaining<=0) 
     ierror("Aborting "+ce2s(this)+" due to apparent infinite loop.");
   postprop();
+  if(compiler_profiler)
+    compiler_profiler->note_rule(to_str(),"IRPropagator",
+                                 steps_allotted-steps_remaining,num_changes,
+                                 any_changes,get_real_secs()-start);
   V2 << "Finished analyzer " << to_str();
   V1 << " changes = " << b2s(any_changes) << endl;
   return any_changes;
@@ -451,7 +451,7 @@ class IRPropagator : public CompilationElement {
   int loop_abort; // # equivalent passes through worklist before assuming loop
   // propagation work variables
   Fset worklist_f; OIset worklist_o; AMset worklist_a;
-  bool any_changes;
+  bool any_changes; int num_changes;
   DFG* root;
 
   IRPropagator(bool field, bool op, bool am=false, int abort=10)
@@ -2971,8 +2971,9 @@ parse_external_defop(SE_List &list)
   name_string.copy(name_cstr, name_size);
   name_cstr[name_size] = 0;
 
+  // trailing attributes such as :side-effect only matter to the neocompiler
   vector<TYPE *> types;
-  for (size_t i = 3; i < list.len(); i++)
+  for (size_t i = 3; i < list.len() && !list[i]->isKeyword(); i++)
     types.push_back(name_to_type(list[i]));
 
   add_op(name_cstr, opcode, 0, 0, new FUN_TYPE(&types));
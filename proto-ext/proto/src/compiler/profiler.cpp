@@ -0,0 +1,127 @@
+/* Compiler self-profiling
+Copyright (C) 2009, Jacob Beal, and contributors
+listed in the AUTHORS file in the MIT Proto distribution's top directory.
+
+This file is part of MIT Proto, and is distributed under the terms of
+the GNU General Public License, with a linking exception, as described
+in the file LICENSE in the MIT Proto distribution's top directory. */
+
+#include "profiler.h"
+
+#include <stdio.h>
+
+#include <fstream>
+
+#include "config.h"
+
+using namespace std;
+
+CompilerProfiler* compiler_profiler = NULL;
+
+PhaseProfile::PhaseProfile(const string &name, DFG* g) : before(g) {
+  this->name = name; open = true; start = get_real_secs(); secs = 0;
+  first_element = CompilationElement::max_id; elements_created = 0;
+  loops = 0;
+}
+
+CompilerProfiler::CompilerProfiler(const string &outfile) {
+  this->outfile = outfile; current_dfg = NULL;
+}
+
+void CompilerProfiler::end_phase() {
+  if(phases.empty() || !phases.back().open) return;
+  PhaseProfile &p = phases.back();
+  p.open = false; p.secs = get_real_secs() - p.start;
+  p.elements_created = CompilationElement::max_id - p.first_element;
+  p.after = IRSize(current_dfg);
+}
+
+void CompilerProfiler::begin_phase(const string &name, DFG* g) {
+  end_phase();
+  current_dfg = g;
+  phases.push_back(PhaseProfile(name,g));
+}
+
+void CompilerProfiler::note_loop() {
+  if(!phases.empty()) phases.back().loops++;
+}
+
+void CompilerProfiler::note_rule(const string &name, const string &kind,
+                                 int steps, int changes, bool changed,
+                                 double secs) {
+  if(phases.empty()) begin_phase("unphased",current_dfg);
+  PhaseProfile &p = phases.back();
+  if(!p.rule_index.count(name)) {
+    p.rule_index[name] = p.rules.size();
+    p.rules.push_back(RuleProfile(name,kind));
+  }
+  RuleProfile &r = p.rules[p.rule_index[name]];
+  r.propagations++; if(changed) r.changed_propagations++;
+  r.steps += steps; r.changes += changes; r.secs += secs;
+}
+
+void CompilerProfiler::finish(DFG* g, const string &program, int output_len) {
+  current_dfg = g; end_phase();
+  if(outfile=="-") {
+    print_json(cpout,program,output_len);
+  } else {
+    ofstream out(outfile.c_str());
+    if(out.is_open()) print_json(&out,program,output_len);
+    else compile_warn("Unable to write compiler profile to "+outfile);
+  }
+  phases.clear(); // a later compilation gets a fresh report
+}
+
+static string json_str(const string &s) {
+  string out = "\"";
+  for(size_t i=0;i<s.size();i++) {
+    char c = s[i];
+    if(c=='"' || c=='\\') { out += '\\'; out += c; }
+    else if(c=='\n') out += "\\n";
+    else if(c=='\t') out += "\\t";
+    else if((unsigned char)c<0x20) {
+      char buf[8]; snprintf(buf,sizeof buf,"\\u%04x",c); out += buf;
+    } else out += c;
+  }
+  return out + "\"";
+}
+
+static string json_num(double d) {
+  char buf[32]; snprintf(buf,sizeof buf,"%.6f",d); return buf;
+}
+
+static void print_size(ostream* out, const IRSize &s) {
+  *out << "{\"nodes\": " << s.nodes << ", \"edges\": " << s.edges
+       << ", \"spaces\": " << s.spaces << "}";
+}
+
+void CompilerProfiler::print_json(ostream* out, const string &program,
+                                  int output_len) {
+  double total = 0;
+  for(int i=0;i<phases.size();i++) total += phases[i].secs;
+  *out << "{\n  \"program\": " << json_str(program) << ",\n"
+       << "  \"output_bytes\": " << output_len << ",\n"
+       << "  \"total_secs\": " << json_num(total) << ",\n"
+       << "  \"phases\": [";
+  for(int i=0;i<phases.size();i++) {
+    PhaseProfile &p = phases[i];
+    *out << (i ? ",\n" : "\n")
+         << "    {\"name\": " << json_str(p.name) << ", \"secs\": "
+         << json_num(p.secs) << ", \"elements_created\": "
+         << p.elements_created << ", \"loops\": " << p.loops << ",\n"
+         << "     \"ir_before\": "; print_size(out,p.before);
+    *out << ", \"ir_after\": "; print_size(out,p.after);
+    *out << ",\n     \"rules\": [";
+    for(int j=0;j<p.rules.size();j++) {
+      RuleProfile &r = p.rules[j];
+      *out << (j ? ",\n" : "\n")
+           << "       {\"name\": " << json_str(r.name) << ", \"kind\": "
+           << json_str(r.kind) << ", \"propagations\": " << r.propagations
+           << ", \"changed_propagations\": " << r.changed_propagations
+           << ", \"steps\": " << r.steps << ", \"changes\": " << r.changes
+           << ", \"secs\": " << json_num(r.secs) << "}";
+    }
+    *out << (p.rules.empty() ? "]}" : "\n     ]}");
+  }
+  *out << "\n  ]\n}" << endl;
+}
@@ -0,0 +1,87 @@
+/* Compiler self-profiling
+Copyright (C) 2009, Jacob Beal, and contributors
+listed in the AUTHORS file in the MIT Proto distribution's top directory.
+
+This file is part of MIT Proto, and is distributed under the terms of
+the GNU General Public License, with a linking exception, as described
+in the file LICENSE in the MIT Proto distribution's top directory. */
+
+// The profiler measures each compilation phase (wall time, compilation
+// elements created, DFG size before and after) and each rule run within
+// it (propagations, worklist steps, changes noted, transformer loops).
+// Results are written as JSON so that compiler performance can be tracked
+// from run to run.
+
+#ifndef PROTO_COMPILER_PROFILER_H
+#define PROTO_COMPILER_PROFILER_H
+
+#include <stdint.h>
+
+#include <iostream>
+#include <map>
+#include <string>
+#include <vector>
+
+#include "ir.h"
+
+struct RuleProfile {
+  std::string name, kind; // kind = IRPropagator or InstructionPropagator
+  int propagations; // calls to propagate()
+  int changed_propagations; // ... of which reported a change
+  int steps; // worklist elements acted on, or elements processed by
+             // rules that run without a worklist
+  int changes; // calls to note_change(), or deletions for dead-code
+               // elimination
+  double secs;
+  RuleProfile(const std::string &name, const std::string &kind)
+    : name(name), kind(kind), propagations(0), changed_propagations(0),
+      steps(0), changes(0), secs(0) {}
+};
+
+// Size of the dataflow graph at a point in time
+struct IRSize {
+  int nodes, edges, spaces;
+  IRSize(DFG* g=NULL) {
+    nodes = g ? g->nodes.size() : 0; edges = g ? g->edges.size() : 0;
+    spaces = g ? g->spaces.size() : 0;
+  }
+};
+
+struct PhaseProfile {
+  std::string name;
+  bool open;
+  double start, secs;
+  uint32_t first_element, elements_created;
+  IRSize before, after;
+  int loops; // passes of a transformer's rule set to reach a fixed point
+  std::vector<RuleProfile> rules; std::map<std::string,int> rule_index;
+  PhaseProfile(const std::string &name, DFG* g);
+};
+
+class CompilerProfiler {
+ public:
+  CompilerProfiler(const std::string &outfile);
+
+  /// Close the current phase (if any) and open a new one
+  void begin_phase(const std::string &name, DFG* g);
+  /// Record one loop of a rule-set fixed-point iteration
+  void note_loop();
+  /// Record one call to a rule's propagate()
+  void note_rule(const std::string &name, const std::string &kind, int steps,
+                 int changes, bool changed, double secs);
+  /// Close the final phase and write the JSON report
+  void finish(DFG* g, const std::string &program, int output_len);
+
+ private:
+  std::string outfile;
+  std::vector<PhaseProfile> phases;
+  DFG* current_dfg;
+  void end_phase();
+  void print_json(std::ostream* out, const std::string &program,
+                  int output_len);
+};
+
+/// The compiler is not re-entrant, so one global suffices: NULL when off
+extern CompilerProfiler* compiler_profiler;
+
+#endif  // PROTO_COMPILER_PROFILER_H
@@ -40,8 +40,10 @@ Path::find_in_path(const string &filename) const
   for (list<string>::const_iterator i = dirs.begin(); i != dirs.end(); ++i) {
     string absolute_filename = *i + "/" + filename;
     scoped_ptr<ifstream> stream(new ifstream(absolute_filename.c_str()));
-    if (stream->good())
+    if (stream->good()) {
+      note_read(absolute_filename);
       return stream.release();
+    }
   }
 
   return 0;
@@ -12,6 +12,7 @@ in the file LICENSE in the MIT Proto distribution's top directory. */
 #include <fstream>
 #include <list>
 #include <string>
+#include <vector>
 
 class List;
 class Obj;
@@ -27,12 +28,17 @@ extern Obj *read_from_str(const char *str);
 // New-style path handling
 struct Path {
   std::list<std::string> dirs;
+  // every file opened through the path (or noted), in order, for the
+  // compile cache to fingerprint
+  mutable std::vector<std::string> files_read;
 
   void add_default_path(const std::string &srcdir);
   void add_to_path(const std::string &addition) { dirs.push_back(addition); }
   std::ifstream *find_in_path(const char *filename) const
     { std::string s(filename); return find_in_path(s); }
   std::ifstream *find_in_path(const std::string &filename) const;
+  void note_read(const std::string &filename) const
+    { files_read.push_back(filename); }
 };
 
 extern List *read_objects_from_dirs(const std::string &filename,
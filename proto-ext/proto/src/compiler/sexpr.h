@@ -9,7 +9,9 @@ in the file LICENSE in the MIT Proto distribution's top directory. */
 #ifndef PROTO_COMPILER_SEXPR_H
 #define PROTO_COMPILER_SEXPR_H
 
+#include <map>
 #include <stack>
+#include <string>
 #include <vector>
 
 #include "compiler-utils.h"
@@ -53,11 +55,28 @@ struct SE_Scalar: SExpr { reflection_sub(SE_Scalar, SExpr);
   }
 };
 
+/****** Symbol interning ******/
+
+// Each distinct symbol name is interned once into a small dense ID, so
+// that symbols can be compared and bound in environments by integer.
+struct SymbolTable {
+  static int intern(const std::string &name);
+  static const std::string &name(int id) { return names()[id]; }
+  static size_t size() { return names().size(); }
+
+ private:
+  // Function-local statics, so interning is safe during static init
+  static std::map<std::string, int> &ids();
+  static std::vector<std::string> &names();
+};
+
 struct SE_Symbol : SExpr { reflection_sub(SE_Symbol, SExpr);
   // Neocompiler is case sensitive, Paleo is not
   static bool case_insensitive;
 
+  // name and id must agree: never modify name after construction
   std::string name;
+  int id;
 
   SE_Symbol(const std::string &name_) : name(name_) {
     if (case_insensitive) {
@@ -65,9 +84,11 @@ struct SE_Symbol : SExpr { reflection_sub(SE_Symbol, SExpr);
       for (size_t i = 0; i < name.size(); i++)
         name[i] = tolower(name[i]);
     }
+    id = SymbolTable::intern(name);
   }
 
-  SE_Symbol(SE_Symbol *src) : name(src->name) { inherit_attributes(src); }
+  SE_Symbol(SE_Symbol *src) : name(src->name), id(src->id)
+    { inherit_attributes(src); }
 
   SExpr *copy() { return new SE_Symbol(this); }
   void print(std::ostream *out = cpout) { *out << name; }
@@ -76,7 +97,7 @@ struct SE_Symbol : SExpr { reflection_sub(SE_Symbol, SExpr);
   virtual bool operator==(const SExpr *ex) const {
     return
       ((ex->isSymbol())
-       && (name == (dynamic_cast<const SE_Symbol &>(*ex).name)));
+       && (id == (dynamic_cast<const SE_Symbol &>(*ex).id)));
   }
 };
 
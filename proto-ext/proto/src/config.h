@@ -13,6 +13,9 @@
 /* Define to 1 if you don't have `vprintf' but do have `_doprnt.' */
 /* #undef HAVE_DOPRNT */
 
+/* Define to 1 if you have the <EGL/egl.h> header file. */
+/* #undef HAVE_EGL_EGL_H */
+
 /* Define to 1 if you have the `floor' function. */
 #define HAVE_FLOOR 1
 
@@ -41,6 +44,9 @@
 /* Define to 1 if you have the <OpenGL/gl.h> header file. */
 #define HAVE_OPENGL_GL_H 1
 
+/* Define to 1 if you have the <png.h> header file. */
+/* #undef HAVE_PNG_H */
+
 /* Define to 1 if you have the `pow' function. */
 #define HAVE_POW 1
 
@@ -170,6 +176,9 @@
 /* Define if you have a GLUT library available */
 #define WANT_GLUT 1
 
+/* Define if headless snapshots can be rendered offscreen */
+/* #undef WANT_OFFSCREEN */
+
 /* Define to 1 if the X Window System is missing or not being used. */
 /* #undef X_DISPLAY_MISSING */
 
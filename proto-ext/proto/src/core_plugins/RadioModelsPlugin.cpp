@@ -10,6 +10,7 @@ in the file LICENSE in the MIT Proto distribution's top directory. */
 #include "multiradio.h"
 #include "wormhole-radio.h"
 #include "graph_link_radio.h"
+#include "protobo-radio.h"
 
 void* RadioModelsPlugin::get_sim_plugin(string type,string name,Args* args, 
                                         SpatialComputer* cpu, int n) {
@@ -17,6 +18,7 @@ void* RadioModelsPlugin::get_sim_plugin(string type,string name,Args* args,
     if(name == WORM_HOLES_NAME) { return new WormHoleRadio(args, cpu, n); }
     if(name == MULTI_RADIO_NAME) { return new MultiRadio(args, cpu, n); }
     if(name == GRAPHLINK_RADIO_NAME) { return new GraphLinkRadio(args, cpu, n); }
+    if(name == PROTOBO_RADIO_NAME) { return new ProtoboRadio(args, cpu, n); }
   }
   return NULL;
 }
@@ -25,7 +27,8 @@ string RadioModelsPlugin::inventory() {
   return "# More complex radio models\n" +
     registry_entry(LAYER_PLUGIN,WORM_HOLES_NAME,DLL_NAME) +
     registry_entry(LAYER_PLUGIN,MULTI_RADIO_NAME,DLL_NAME) +
-    registry_entry(LAYER_PLUGIN,GRAPHLINK_RADIO_NAME,DLL_NAME);
+    registry_entry(LAYER_PLUGIN,GRAPHLINK_RADIO_NAME,DLL_NAME) +
+    registry_entry(LAYER_PLUGIN,PROTOBO_RADIO_NAME,DLL_NAME);
 }
 
 extern "C" {
@@ -8,8 +8,8 @@ in the file LICENSE in the MIT Proto distribution's top directory. */
 
 #include "SimpleLifeCyclePlugin.h"
 
-#define DIE_OP "die scalar boolean"
-#define CLONE_OP "clone scalar boolean"
+#define DIE_OP "die scalar boolean :side-effect"
+#define CLONE_OP "clone scalar boolean :side-effect"
 
 /*****************************************************************************
  *  SIMPLE LIFECYCLE                                                         *
@@ -37,7 +37,7 @@ void SimpleLifeCycle::add_device(Device* d) {
 }
 
 void SimpleLifeCycle::die (Number val) {
-  if(val != 0) parent->death_q.push(device->backptr);
+  if(val != 0) parent->death_q.push_back(device->backptr);
 }
 void SimpleLifeCycle::clone_machine (Number val) {
   if(val != 0) ((SimpleLifeCycleDevice*)device->layers[id])->clone_cmd=true;
@@ -71,8 +71,8 @@ void SimpleLifeCycleDevice::clone_me() {
   cp[0] = p[0] + dp*cos(phi)*cos(theta);
   cp[1] = p[1] + dp*cos(phi)*sin(theta);
   cp[2] = p[2] + dp*sin(phi);
-  CloneReq* cr = new CloneReq(container->backptr,container,cp);
-  parent->parent->clone_q.push(cr);
+  SpatialComputer* sc = parent->parent;
+  sc->clone_q.push_back(CloneReq(sc->devices.handle(container->backptr),cp));
 }
 
 extern Machine * machine;
@@ -95,7 +95,7 @@ bool SimpleLifeCycleDevice::handle_key(KeyEvent* key) {
   if(key->normal && !key->ctrl) {
     switch(key->key) {
     case 'B': clone_me(); return true;
-    case 'K': parent->parent->death_q.push(container->backptr); return true;
+    case 'K': parent->parent->death_q.push_back(container->backptr); return true;
     }
   }
   return false;
@@ -107,14 +107,13 @@ void GraphLinkRadio::connect_device(Device* d) {
 void GraphLinkRadio::disconnect_device(Device *d) {
   GraphLinkDevice* udd = (GraphLinkDevice*)d->layers[id];
   // disconnect from each neighbor
-  for(int i=0;i<udd->neighbors.max_id();i++) {
-    GLNbrRecord* nr = (GLNbrRecord*)udd->neighbors.get(i);
-    if(nr) { 
-      GLNbrRecord* nnr = (GLNbrRecord*)nr->nbr->neighbors.remove(nr->backptr);
-      if(nnr->backptr!=i) debug("Bad nbr backptr: %d!=%d\n",i,nnr->backptr);
-      if(nnr->nbr != udd) debug("Bad local backptr\n");
-      delete nnr; delete nr;
-    }
+  for(int k=0;k<udd->neighbors.size();k++) {
+    GLNbrRecord* nr = udd->neighbors.member(k);
+    int i = udd->neighbors.slot(k);
+    GLNbrRecord* nnr = nr->nbr->neighbors.remove(nr->backptr);
+    if(nnr->backptr!=i) debug("Bad nbr backptr: %d!=%d\n",i,nnr->backptr);
+    if(nnr->nbr != udd) debug("Bad local backptr\n");
+    delete nnr; delete nr;
   }
   // purge local lists
   udd->neighbors.clear();
@@ -147,8 +146,9 @@ int GraphLinkRadio::radio_send_export (uint8_t version, Array<Data> const & data
   // walk neighbors
   GraphLinkDevice* udd = (GraphLinkDevice*)device->layers[id];
   for(int i=0;i<udd->neighbors.max_id();i++) {
-    GLNbrRecord* nr = (GLNbrRecord*)udd->neighbors.get(i);
-    if(nr && try_rx()) { // non-failing receive
+    GLNbrRecord* nr = udd->neighbors.get(i); if(!nr) continue;
+    // non-failing receive, by a device running the same script
+    if(try_rx() && nr->nbr->container->runs_version(version)) {
       // hardware->set_vm_context(nr->nbr->container);
       /*radio_receive_export(src_id, version, timeout, -nr->dp[0], -nr->dp[1],
                            -nr->dp[2], n, buf);*/
@@ -157,7 +157,7 @@ int GraphLinkRadio::radio_send_export (uint8_t version, Array<Data> const & data
       nbr.x = -nr->dp[0];
       nbr.y = -nr->dp[1];
       nbr.z = -nr->dp[2];
-      nbr.data_age = 0;
+      nbr.data_round = nr->nbr->container->vm->rounds;
     }
   }
   // hardware->set_vm_context(udd->container); // restore context
@@ -166,12 +166,34 @@ int GraphLinkRadio::radio_send_export (uint8_t version, Array<Data> const & data
 
 int GraphLinkRadio::radio_send_script_pkt (uint8_t version, uint16_t n, 
                                           uint8_t pkt_num, uint8_t *script) {
-  // currently disabled
+  if(!try_tx())  // transmission failure
+    return 0;
+
+  // walk neighbors
+  GraphLinkDevice* udd = (GraphLinkDevice*)device->layers[id];
+  for(int i=0;i<udd->neighbors.max_id();i++) {
+    GLNbrRecord* nr = udd->neighbors.get(i); if(!nr) continue;
+    Device* d = nr->nbr->container;
+    if(try_rx() && d->script) // non-failing receive
+      d->script->receive_pkt(version, n, pkt_num, script);
+  }
+  return 1;
 }
 
 int GraphLinkRadio::radio_send_digest (uint8_t version, uint16_t script_len, 
                                       uint8_t *digest) {
-  // currently disabled
+  if(!try_tx())  // transmission failure
+    return 0;
+
+  // walk neighbors
+  GraphLinkDevice* udd = (GraphLinkDevice*)device->layers[id];
+  for(int i=0;i<udd->neighbors.max_id();i++) {
+    GLNbrRecord* nr = udd->neighbors.get(i); if(!nr) continue;
+    Device* d = nr->nbr->container;
+    if(try_rx() && d->script) // non-failing receive
+      d->script->receive_digest(version, script_len, digest);
+  }
+  return 1;
 }
 
 /*****************************************************************************
@@ -183,13 +205,10 @@ GraphLinkDevice::GraphLinkDevice(GraphLinkRadio* parent, Device* container)
 
 GraphLinkDevice::~GraphLinkDevice() {
   if(parent->is_fast_prune_hood) { // delete self from each neighbor
-    for(int i=0;i<neighbors.max_id();i++) {
-      GLNbrRecord* nr = (GLNbrRecord*)neighbors.get(i);
-      if(nr) {
-	Machine* nvm = nr->nbr->container->vm;
-	NeighbourHood::iterator i = nvm->hood.find(container->uid);
-	if (i != nvm->hood.end()) nvm->hood.remove(i);
-	  }
+    for(int k=0;k<neighbors.size();k++) {
+      Machine* nvm = neighbors.member(k)->nbr->container->vm;
+      NeighbourHood::iterator i = nvm->hood.find(container->uid);
+      if (i != nvm->hood.end()) nvm->hood.remove(i);
     }
   }
   parent->disconnect_device(container);
@@ -214,9 +233,9 @@ void GraphLinkDevice::visualize() {
     }
     // do the actual draw
     glBegin(GL_LINES);
-    for(int i=0;i<neighbors.max_id();i++) {
-      GLNbrRecord* nr = (GLNbrRecord*)neighbors.get(i);
-      if(nr && (local_sharp || nr->nbr->container->uid > container->uid)) {
+    for(int k=0;k<neighbors.size();k++) {
+      GLNbrRecord* nr = neighbors.member(k);
+      if(local_sharp || nr->nbr->container->uid > container->uid) {
         glVertex3f(0,0,0);
         glVertex3f(nr->dp[0],nr->dp[1],nr->dp[2]);
       }
@@ -226,3 +245,24 @@ void GraphLinkDevice::visualize() {
   }
 #endif // WANT_GLUT
 }
+
+void GraphLinkDevice::visualize_batch(DrawBatch* batch, const flo* p) {
+#ifdef WANT_GLUT
+  if(parent->is_show_connectivity) {
+    flo rgba[4];
+    bool local_sharp=(parent->connect_display_mode==1 && 
+                      container->is_selected);
+    if(parent->connect_display_mode==2 || local_sharp)
+      palette->get_rgba(GraphLinkRadio::NET_CONNECTION_SHARP,rgba);
+    else
+      palette->get_rgba(GraphLinkRadio::NET_CONNECTION_FUZZY,rgba);
+    for(int k=0;k<neighbors.size();k++) {
+      GLNbrRecord* nr = neighbors.member(k);
+      if(local_sharp || nr->nbr->container->uid > container->uid) {
+        flo q[3] = {p[0]+nr->dp[0], p[1]+nr->dp[1], p[2]+nr->dp[2]};
+        batch->line(p,q,rgba);
+      }
+    }
+  }
+#endif // WANT_GLUT
+}
@@ -46,15 +46,17 @@ class GraphLinkRadio : public RadioSim {
   void parse_graph_file(const char* filename, bool warnfail=true);
 };
 
+struct GLNbrRecord; // internal definition
 class GraphLinkDevice : public DeviceLayer {
  public:
   GraphLinkRadio* parent;
   // these values are actually managed by the GraphLinkRadio
-  Population neighbors; // collection of NbrRecord* (internal definition)
+  SlotMap<GLNbrRecord> neighbors;
 
   GraphLinkDevice(GraphLinkRadio* parent, Device* container);
   ~GraphLinkDevice();
   void visualize();
+  void visualize_batch(DrawBatch* batch, const flo* p);
   void copy_state(DeviceLayer* src) {} // to be called during cloning
 };
 
@@ -0,0 +1,181 @@
+/* Emulation of the protobo platform's message path
+Copyright (C) 2005-2010, Jonathan Bachrach, Jacob Beal, and contributors
+listed in the AUTHORS file in the MIT Proto distribution's top directory.
+
+This file is part of MIT Proto, and is distributed under the terms of
+the GNU General Public License, with a linking exception, as described
+in the file LICENSE in the MIT Proto distribution's top directory. */
+
+#include "config.h"
+#include "protobo-radio.h"
+
+// the platform's own message limits and layouts
+extern "C" {
+#include "comm.h"
+}
+#include "protobo-msgs.h"
+
+ProtoboRadio::ProtoboRadio(Args* args, SpatialComputer* p, int n)
+  : UnitDiscRadio(args,p,n) {
+  // bit-banged bytes take roughly ten 40us bit times apiece
+  byte_time = args->extract_switch("-protobo-byte-time") ?
+    args->pop_number() : 0.0004;
+  loop_time = args->extract_switch("-protobo-loop-time") ?
+    args->pop_number() : 0.001;
+  exports = multi_packet_exports = fragments = bytes = 0;
+  receptions = deliveries = tx_drops = rx_drops = link_drops = 0;
+  total_latency = max_latency = 0;
+}
+
+ProtoboRadio::~ProtoboRadio() { report(parent->report_file()); }
+
+void ProtoboRadio::add_device(Device* d) {
+  d->layers[id] = new ProtoboDevice(this,d);
+  connect_device(d);
+}
+
+void ProtoboRadio::report(FILE* out) {
+  fprintf(out,"Protobo radio: %d-byte messages, %g s per byte, %g s to"
+          " process a message\n",MAX_MESSAGE_SIZE,byte_time,loop_time);
+  fprintf(out,"  %llu exports, %llu (%.1f%%) needing more than one message\n",
+          (unsigned long long)exports,(unsigned long long)multi_packet_exports,
+          exports ? 100.0*multi_packet_exports/exports : 0.0);
+  fprintf(out,"  %llu messages sent (%llu bytes); dropped %llu from full send"
+          " queues, %llu from full receive queues, %llu on the air\n",
+          (unsigned long long)fragments,(unsigned long long)bytes,
+          (unsigned long long)tx_drops,(unsigned long long)rx_drops,
+          (unsigned long long)link_drops);
+  fprintf(out,"  %llu of %llu receptions complete; latency mean %.4f,"
+          " max %.4f\n",(unsigned long long)deliveries,
+          (unsigned long long)receptions,
+          deliveries ? total_latency/deliveries : 0.0,max_latency);
+  fflush(out);
+}
+
+// number of COM_DATA values an export occupies: tuples carry their length
+static int com_data_count(Data const & d) {
+  if(d.type()!=Data::Type_tuple) return 1;
+  Tuple const & t = d.asTuple();
+  int n = 1;
+  for(Size i=0;i<t.size();i++) n += com_data_count(t[i]);
+  return n;
+}
+
+// Fragment a message into messages carrying at most room bytes of payload,
+// queue it at the sender, and pass it to each neighbour whose receive queue
+// has room for every fragment
+int ProtoboRadio::send(ProtoboMsg& msg, int header, int payload, int room) {
+  SECONDS now = parent->sim_time;
+  int n_frags = std::max(1,(payload+room-1)/room);
+  if(msg.kind==ProtoboMsg::HOOD) {
+    exports++; if(n_frags>1) multi_packet_exports++;
+  }
+
+  // sender: fragments go out back to back, with a short waiting queue
+  ProtoboDevice* pd = (ProtoboDevice*)device->layers[id];
+  while(!pd->tx_waiting.empty() && pd->tx_waiting.front()<=now)
+    pd->tx_waiting.pop_front();
+  std::vector<SECONDS> ends;
+  bool is_sent = true;
+  for(int f=0;f<n_frags;f++) {
+    if(pd->tx_waiting.size()>=MAX_SEND_QUEUE_LENGTH)
+      { tx_drops++; return 0; } // the rest of the message is lost
+    int size = header + std::min(room,payload-f*room);
+    SECONDS start = std::max(now,pd->tx_free);
+    if(start>now) pd->tx_waiting.push_back(start);
+    pd->tx_free = start + size*byte_time;
+    ends.push_back(pd->tx_free);
+    fragments++; bytes += size;
+    if(!try_tx()) { link_drops++; is_sent = false; } // still uses the wire
+  }
+  if(!is_sent) return 0;
+
+  // receivers: each fragment waits its turn to be processed
+  UnitDiscDevice* udd = (UnitDiscDevice*)device->layers[id];
+  for(int i=0;i<udd->neighbors.max_id();i++) {
+    NbrRecord* nr = udd->neighbors.get(i); if(!nr) continue;
+    ProtoboDevice* rd = (ProtoboDevice*)nr->nbr;
+    receptions++;
+    SECONDS done = 0;
+    bool is_received = true;
+    for(int f=0;f<n_frags;f++) {
+      if(!try_rx()) { link_drops++; is_received = false; break; }
+      while(!rd->rx_waiting.empty() && rd->rx_waiting.front()<=ends[f])
+        rd->rx_waiting.pop_front();
+      if(rd->rx_waiting.size()>=MAX_RECEIVE_QUEUE_LENGTH)
+        { rx_drops++; is_received = false; break; }
+      done = std::max(ends[f],rd->rx_waiting.empty() ? ends[f] :
+                      rd->rx_waiting.back()) + loop_time;
+      rd->rx_waiting.push_back(done);
+    }
+    if(!is_received) continue;
+    for(int i=0;i<3;i++) msg.dp[i] = -nr->dp[i];
+    msg.arrival = done;
+    rd->inbox.push_back(msg);
+    deliveries++; total_latency += done-now;
+    max_latency = std::max(max_latency,done-now);
+  }
+  return 1;
+}
+
+int ProtoboRadio::radio_send_export (uint8_t version,
+                                     Array<Data> const & data) {
+  ProtoboMsg msg;
+  msg.kind = ProtoboMsg::HOOD; msg.src = device->uid; msg.version = version;
+  msg.imports = data;
+  int values = 0;
+  for(Size i=0;i<data.size();i++) values += com_data_count(data[i]);
+  return send(msg,offsetof(HOOD_MSG,buf),values*sizeof(COM_DATA),
+              MAX_HOOD_MSGS*sizeof(COM_DATA));
+}
+
+int ProtoboRadio::radio_send_script_pkt (uint8_t version, uint16_t n,
+                                         uint8_t pkt_num, uint8_t *script) {
+  if(!parent->disseminator) return 0;
+  int chunk = parent->disseminator->chunk_size(n);
+  int len = std::min(chunk,n-pkt_num*chunk);
+  ProtoboMsg msg;
+  msg.kind = ProtoboMsg::SCRIPT; msg.src = device->uid; msg.version = version;
+  msg.n = n; msg.pkt_num = pkt_num; msg.bytes.assign(script,script+len);
+  return send(msg,offsetof(SCRIPT_MSG,script),len,MAX_SCRIPT_PKT);
+}
+
+int ProtoboRadio::radio_send_digest (uint8_t version, uint16_t script_len,
+                                     uint8_t *digest) {
+  if(!parent->disseminator) return 0;
+  int len = (parent->disseminator->num_chunks(script_len)+7)/8;
+  ProtoboMsg msg;
+  msg.kind = ProtoboMsg::DIGEST; msg.src = device->uid; msg.version = version;
+  msg.n = script_len; msg.bytes.assign(digest,digest+len);
+  return send(msg,offsetof(DIGEST_MSG,digest),len,MAX_DIGEST_PKT);
+}
+
+// messages that have arrived by this round are handed over, as the radio
+// interrupt would have done on the hardware
+void ProtoboDevice::preupdate() {
+  SECONDS now = container->parent->sim_time;
+  int kept = 0;
+  for(int i=0;i<inbox.size();i++) {
+    ProtoboMsg& m = inbox[i];
+    if(m.arrival > now) { if(kept!=i) inbox[kept] = m; kept++; continue; }
+    switch(m.kind) {
+    case ProtoboMsg::HOOD:
+      if(container->runs_version(m.version)) {
+        Neighbour & nbr = container->vm->hood[m.src];
+        for(Size j = 0; j < m.imports.size(); j++) nbr.imports[j]=m.imports[j];
+        nbr.x = m.dp[0]; nbr.y = m.dp[1]; nbr.z = m.dp[2];
+        nbr.data_round = container->vm->rounds;
+      }
+      break;
+    case ProtoboMsg::DIGEST:
+      if(container->script)
+        container->script->receive_digest(m.version,m.n,&m.bytes[0]);
+      break;
+    case ProtoboMsg::SCRIPT:
+      if(container->script)
+        container->script->receive_pkt(m.version,m.n,m.pkt_num,&m.bytes[0]);
+      break;
+    }
+  }
+  inbox.resize(kept);
+}
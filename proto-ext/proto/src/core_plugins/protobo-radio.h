@@ -0,0 +1,70 @@
+/* Emulation of the protobo platform's message path
+Copyright (C) 2005-2010, Jonathan Bachrach, Jacob Beal, and contributors
+listed in the AUTHORS file in the MIT Proto distribution's top directory.
+
+This file is part of MIT Proto, and is distributed under the terms of
+the GNU General Public License, with a linking exception, as described
+in the file LICENSE in the MIT Proto distribution's top directory. */
+
+#ifndef __PROTOBORADIO__
+#define __PROTOBORADIO__
+
+#include <deque>
+#include <vector>
+#include "unitdiscradio.h"
+
+// Unit-disc neighbourhoods, but every message goes through the protobo
+// encoding and queues (platforms/protobo: comm.h, proto_msg_structs.h,
+// messages.c): messages of the platform's sizes sent one byte at a time,
+// through its short send and receive queues.  Exports too large for one
+// message are fragmented, and reach a neighbour only if every fragment does.
+
+// a message that has been received and awaits the neighbour's next round
+struct ProtoboMsg {
+  enum Kind { HOOD, DIGEST, SCRIPT } kind;
+  int src; uint8_t version;
+  METERS dp[3];               // position of sender relative to receiver
+  Array<Data> imports;        // HOOD
+  std::vector<uint8_t> bytes; // DIGEST or SCRIPT
+  uint16_t n; uint8_t pkt_num;
+  SECONDS arrival;            // when the last fragment has been processed
+};
+
+class ProtoboRadio : public UnitDiscRadio {
+ public:
+  // model options
+  SECONDS byte_time;  // time on the wire per byte
+  SECONDS loop_time;  // time for the receiver to process one message
+  // statistics
+  uint64_t exports, multi_packet_exports, fragments, bytes;
+  uint64_t receptions, deliveries, tx_drops, rx_drops, link_drops;
+  SECONDS total_latency, max_latency;
+
+  ProtoboRadio(Args* args, SpatialComputer* parent, int n);
+  ~ProtoboRadio();
+  void add_device(Device* d);
+
+  // hardware emulation
+  int radio_send_export (uint8_t version, Array<Data> const & data);
+  int radio_send_script_pkt (uint8_t version, uint16_t n,
+                             uint8_t pkt_num, uint8_t *script);
+  int radio_send_digest (uint8_t version, uint16_t script_len,
+                         uint8_t *digest);
+  void report(FILE* out);
+ private:
+  int send(ProtoboMsg& msg, int header, int payload, int room);
+};
+
+class ProtoboDevice : public UnitDiscDevice {
+ public:
+  std::deque<SECONDS> tx_waiting;  // start times of fragments not yet sent
+  SECONDS tx_free;                 // when the last queued fragment ends
+  std::deque<SECONDS> rx_waiting;  // processing times of queued fragments
+  std::vector<ProtoboMsg> inbox;
+
+  ProtoboDevice(ProtoboRadio* parent, Device* container)
+    : UnitDiscDevice(parent,container) { tx_free = 0; }
+  void preupdate(); // hand arrived messages to the VM
+};
+
+#endif // __PROTOBORADIO__
@@ -54,9 +54,8 @@ void WormHoleRadio::attach_wormholes() {
 
 WormHoleRadioDevice *WormHoleRadio::random_device() {
   Device *d;
-  do {
-    int i = rand() % parent->devices.max_id();
-    d = (Device*)parent->devices.get(i);
+  do { // by slot, so the draws match those of earlier versions
+    d = parent->devices.get(rand() % parent->devices.max_id());
   } while(d == NULL);
   return (WormHoleRadioDevice*)(d->layers[id]);
 }
@@ -81,7 +80,7 @@ int WormHoleRadio::radio_send_export (uint8_t version, Array<Data> const & data)
   for(set<WormHoleRadioDevice*>::iterator it = dev->nbrs.begin();
       it != dev->nbrs.end(); it++) {
     WormHoleRadioDevice *o = *it;
-    if(try_rx()) {
+    if(try_rx() && o->container->runs_version(version)) {
       const flo *them = o->container->body->position();
 
       Neighbour & nbr = o->container->vm->hood[src_id];
@@ -89,49 +88,42 @@ int WormHoleRadio::radio_send_export (uint8_t version, Array<Data> const & data)
       nbr.y = me[1]-them[1];
       nbr.z = me[2]-them[2];
       nbr.imports = data;
-      nbr.data_age = 0;
+      nbr.data_round = o->container->vm->rounds;
     }
   }
 
   hardware->set_vm_context(dev->container);
+  return 1;
 }
 
 int WormHoleRadio::radio_send_script_pkt (uint8_t version, uint16_t n,
                                           uint8_t pkt_num, uint8_t *script) {
-/*  if(!try_tx())  // transmission failure
+  if(!try_tx())  // transmission failure
     return 0;
 
-  int src_id = device->uid;
   WormHoleRadioDevice *dev = (WormHoleRadioDevice*)device->layers[id];
   for(set<WormHoleRadioDevice*>::iterator it = dev->nbrs.begin();
       it != dev->nbrs.end(); it++) {
-    WormHoleRadioDevice *o = *it;
-    if(try_rx()) {
-      hardware->set_vm_context(o->container);
-      radio_receive_script_pkt(version, n, pkt_num, script);
-    }
+    Device *o = (*it)->container;
+    if(try_rx() && o->script)
+      o->script->receive_pkt(version, n, pkt_num, script);
   }
-
-  hardware->set_vm_context(dev->container);*/
+  return 1;
 }
 
 int WormHoleRadio::radio_send_digest (uint8_t version, uint16_t script_len,
                                       uint8_t *digest) {
-/*  if(!try_tx())  // transmission failure
+  if(!try_tx())  // transmission failure
     return 0;
 
-  int src_id = device->uid;
   WormHoleRadioDevice *dev = (WormHoleRadioDevice*)device->layers[id];
   for(set<WormHoleRadioDevice*>::iterator it = dev->nbrs.begin();
       it != dev->nbrs.end(); it++) {
-    WormHoleRadioDevice *o = *it;
-    if(try_rx()) {
-      hardware->set_vm_context(o->container);
-      radio_receive_digest(version, script_len, digest);
-    }
+    Device *o = (*it)->container;
+    if(try_rx() && o->script)
+      o->script->receive_digest(version, script_len, digest);
   }
-
-  hardware->set_vm_context(dev->container);-*/
+  return 1;
 }
 
 WormHoleRadioDevice::WormHoleRadioDevice(WormHoleRadio *parent, Device *container)
@@ -150,9 +150,12 @@ flo glutStrokeHeight (void *font) {
   return 119.05;
 }
 
+bool is_text_drawable = true;
+
 // Measure the size of a piece of text when drawn in the specified font.
 flo stroke_text_size (void* font, const char* text, flo *height) {
   int i; float l = 0.0;
+  if (!is_text_drawable) { *height = glutStrokeHeight(font); return l; }
   for (i=0; i<strlen(text); i++) { l += glutStrokeWidth(font, text[i]); }
   *height = glutStrokeHeight(font);
   return l;
@@ -200,6 +203,7 @@ flo stroke_multitext_size (void* font, int n, char** strs, flo *height) {
 
 void stroke_text (void *font, const char *txt) {
   int i;
+  if (!is_text_drawable) return;
   glPushMatrix();
   for (i=0; i<strlen(txt); i++)
     glutStrokeCharacter(font, txt[i]);
@@ -443,3 +447,66 @@ void rgb_to_hsv (flo r, flo g, flo b, flo *h, flo *s, flo *v) {
 }
 
 
+
+// ******   BATCHED DRAWING   ******
+
+void DrawBatch::clear () {
+  points.clear(); point_colors.clear();
+  lines.clear(); line_colors.clear();
+  triangles.clear(); triangle_colors.clear();
+}
+
+void DrawBatch::vertex (vector<flo> *v, vector<flo> *c,
+                        flo x, flo y, flo z, const flo *rgba) {
+  v->push_back(x); v->push_back(y); v->push_back(z);
+  for (int i = 0; i < 4; i++) c->push_back(rgba[i]);
+}
+
+void DrawBatch::point (const flo *p, const flo *rgba) {
+  vertex(&points, &point_colors, p[0], p[1], p[2], rgba);
+}
+
+void DrawBatch::line (const flo *a, const flo *b, const flo *rgba) {
+  vertex(&lines, &line_colors, a[0], a[1], a[2], rgba);
+  vertex(&lines, &line_colors, b[0], b[1], b[2], rgba);
+}
+
+// circles use the same cached approximation as draw_circle
+void DrawBatch::circle (const flo *c, flo r, const flo *rgba) {
+  int n = N_CIRCLE_VERTICES-1;
+  for (int i = 0; i < n; i++) {
+    Vertex *a = &circle_vertices[i], *b = &circle_vertices[(i+1)%n];
+    vertex(&lines, &line_colors, c[0]+r*a->x, c[1]+r*a->y, c[2], rgba);
+    vertex(&lines, &line_colors, c[0]+r*b->x, c[1]+r*b->y, c[2], rgba);
+  }
+}
+
+void DrawBatch::disk (const flo *c, flo r, const flo *rgba) {
+  int n = N_CIRCLE_VERTICES-1;
+  for (int i = 0; i < n; i++) {
+    Vertex *a = &circle_vertices[i], *b = &circle_vertices[(i+1)%n];
+    vertex(&triangles, &triangle_colors, c[0], c[1], c[2], rgba);
+    vertex(&triangles, &triangle_colors, c[0]+r*a->x, c[1]+r*a->y, c[2], rgba);
+    vertex(&triangles, &triangle_colors, c[0]+r*b->x, c[1]+r*b->y, c[2], rgba);
+  }
+  circle(c, r, rgba); // heavy edge, as in draw_disk
+}
+
+static void draw_arrays (GLenum mode, vector<flo> *v, vector<flo> *c) {
+  if (v->empty()) return;
+  glVertexPointer(3, GL_FLOAT, 0, &(*v)[0]);
+  glColorPointer(4, GL_FLOAT, 0, &(*c)[0]);
+  glDrawArrays(mode, 0, v->size()/3);
+}
+
+// Triangles go first, so that lines and points drawn at the same depth
+// land on top of them, as they do when drawn device by device.
+void DrawBatch::draw () {
+  glPushClientAttrib(GL_CLIENT_VERTEX_ARRAY_BIT);
+  glEnableClientState(GL_VERTEX_ARRAY);
+  glEnableClientState(GL_COLOR_ARRAY);
+  draw_arrays(GL_TRIANGLES, &triangles, &triangle_colors);
+  draw_arrays(GL_LINES, &lines, &line_colors);
+  draw_arrays(GL_POINTS, &points, &point_colors);
+  glPopClientAttrib();
+}
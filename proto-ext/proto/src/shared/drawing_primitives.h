@@ -41,4 +41,30 @@ extern void hsv_to_rgb (flo h, flo s, flo v, flo *r, flo *g, flo *b);
 extern void rgb_to_hsv (flo r, flo g, flo b, flo *h, flo *s, flo *v);
 extern void draw_pixmap (flo x, flo y, flo w, flo h, int iw, int ih, void* image);
 
+// Text is drawn with GLUT stroke fonts, which need a GLUT window; offscreen
+// rendering turns text off, and the text functions then draw nothing.
+extern bool is_text_drawable;
+
+// A DrawBatch collects primitives in world coordinates, each with its own
+// color, and draws each kind with a single vertex-array call.  It trades
+// the per-device matrix and color state changes of the routines above for
+// one pass of packing, so large populations can still be drawn every frame.
+class DrawBatch {
+ public:
+  void clear();
+  void point(const flo* p, const flo* rgba);
+  void line(const flo* a, const flo* b, const flo* rgba);
+  void circle(const flo* c, flo r, const flo* rgba); // unfilled, in XY plane
+  void disk(const flo* c, flo r, const flo* rgba); // filled, in XY plane
+  void draw(); // submit everything collected since the last clear()
+
+ private:
+  // interleaved x,y,z / r,g,b,a arrays for each kind of primitive
+  std::vector<flo> points, point_colors;
+  std::vector<flo> lines, line_colors;
+  std::vector<flo> triangles, triangle_colors;
+  void vertex(std::vector<flo>* v, std::vector<flo>* c,
+              flo x, flo y, flo z, const flo* rgba);
+};
+
 #endif // __DRAWING_PRIMITIVES__
@@ -36,6 +36,11 @@ void Palette::blend_color(Color* c1,Color* c2, flo frac1) {
 void Palette::set_background(Color* c) {
   glClearColor(c->color[0],c->color[1],c->color[2],c->color[3]);
 }
+// the values scale_color would use, for drawing without the GL color state
+void Palette::get_rgba(Color* c, flo* rgba, flo r, flo g, flo b, flo a) {
+  rgba[0]=c->color[0]*r; rgba[1]=c->color[1]*g;
+  rgba[2]=c->color[2]*b; rgba[3]=c->color[3]*a;
+}
 
 Color* Palette::register_color(string name, flo r, flo g, flo b, flo a) {
   if(colors.count(name)) {
@@ -54,6 +54,7 @@ class Palette {
   void blend_color(Color* c1,Color* c2, flo frac1); // mix c1 and c2
   // some color calls need to be fed values directly
   void set_background(Color* c);
+  void get_rgba(Color* c, flo* rgba, flo r=1, flo g=1, flo b=1, flo a=1);
 
   static Palette* default_palette;
 };
@@ -104,6 +104,9 @@ Args::remove(size_t i)
     if (save_ptrs_[j] > i)
       save_ptrs_[j]--;
 
+  if (removal_log_)
+    removal_log_->push_back(argv[i]);
+
   // Shrink the size of the list.
   argc--;
 
@@ -392,71 +395,6 @@ ensure_extension(string &base, const string &extension)
     base += extension;
 }
 
-/*****************************************************************************
- *  POPULATION CLASS                                                         *
- *****************************************************************************/
-
-size_t
-Population::add(void *member)
-{
-  size_t i;
-
-  if (recycled_.empty()) {
-    i = vector_.size();
-    vector_.push_back(member);
-  } else {
-    i = recycled_.front();
-    recycled_.pop();
-    if (vector_[i] != 0)
-      uerror("Population tried to over-write a node!");
-    vector_[i] = member;
-  }
-
-  population_size_++;
-  return i;
-}
-
-void *
-Population::remove(size_t i)
-{
-  void *member = vector_.at(i);
-
-  if (member != 0) {
-    vector_[i] = 0;
-    recycled_.push(i);
-    population_size_--;
-  }
-
-  return member;
-}
-
-void
-Population::destroy(size_t i)
-{
-  void *member = remove(i);
-  if (member)
-    free(member);
-}
-
-void
-Population::clear()
-{
-  vector_.clear();
-  while (!recycled_.empty())
-    recycled_.pop();
-  population_size_ = 0;
-}
-
-void *
-Population::get(size_t i) const
-{
-  // Note: i is always non-negative because it is a size_t, which is unsigned
-  if (i < vector_.size()) // 0 <= i && 
-    return vector_[i];
-  uerror("Attempted to access out of bounds member of Population!");
-  return 0;
-}
-
 /*****************************************************************************
  *  EVENTCONSUMER                                                            *
  *****************************************************************************/
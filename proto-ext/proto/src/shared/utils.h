@@ -134,7 +134,8 @@ class Args {
   char **argv;
 
   Args(int argc_, char** argv_)
-      : argc(argc_), argv(argv_), argp_(1), last_switch_("(no switch yet)") {
+      : argc(argc_), argv(argv_), argp_(1), last_switch_("(no switch yet)"),
+        removal_log_(NULL) {
     add_defaults();
   }
 
@@ -171,6 +172,9 @@ class Args {
   // Set pointer to the last saved, which is then unsaved.
   void restore_ptr();
 
+  // Append each argument removed from now on to log; NULL stops logging.
+  void log_removals(std::vector<std::string> *log) { removal_log_ = log; }
+
  private:
   // Index of the current argument; 0 is the command, starts at 1.
   int argp_;
@@ -181,6 +185,9 @@ class Args {
   // Stack of saved pointers.
   std::vector<int> save_ptrs_;
 
+  // Where removed arguments are recorded, if anywhere.
+  std::vector<std::string> *removal_log_;
+
   // Read args from .[appname] and ~/.[appname] files.
   void add_defaults();
   void parse_argstream(std::istream *s);
@@ -194,30 +201,167 @@ class Args {
 
 // A Population is a cross between an array and a list
 // It is designed w. fast random access, compact storage, and automatic resize
+//
+// Members keep the slot they were added at until they are removed, and
+// freed slots are recycled.  The members are also kept packed in a dense
+// array, so iterating with member(k) for k < size() never visits the
+// holes left by removed members; removal moves the last member into the
+// hole, so the dense order is stable only while nothing is removed.
+// Loops whose results depend on the order, such as ones drawing random
+// numbers per member, walk the slots (get(i) for i < max_id()) instead, so
+// that seeded runs stay the same.
+// A Handle remembers the generation of its slot: once the member is
+// removed, the handle goes stale instead of finding the slot's next owner.
 
-// FIXME: This should be templatized; void * is wrong.
-
-class Population {
+template<class T>
+class SlotMap {
  public:
-  Population() : population_size_(0) {}
+  struct Handle {
+    size_t slot; unsigned generation;
+    Handle() : slot(0), generation(0) {}
+  };
+
+  SlotMap() {}
 
-  size_t add(void *member);     // Add an item; return where it went.
-  void *remove(size_t i);       // Remove the item at i and return it.
+  size_t add(T *member);        // Add an item; return where it went.
+  T *remove(size_t i);          // Remove the item at i and return it.
   void destroy(size_t i);       // Idempotent freeing of item at location i.
-  void *get(size_t i) const;    // Return the item at i, or null if empty.
+  T *get(size_t i) const;       // Return the item at i, or null if empty.
+  T *get(Handle h) const;       // Same, or null if h's item was removed.
+  Handle handle(size_t i) const; // A reference to the item now at i.
   void clear();                 // Remove every item in the population.
+  void reserve(size_t n);       // Make room to add n items without growing.
 
-  size_t size() const { return population_size_; }
-  size_t max_id() const { return vector_.size(); }
+  size_t size() const { return dense_.size(); }
+  size_t max_id() const { return slots_.size(); }
+
+  // Dense iteration, for 0 <= k < size(): the k-th item and its slot
+  T *member(size_t k) const { return dense_[k]; }
+  size_t slot(size_t k) const { return owners_[k]; }
 
  private:
-  size_t population_size_;      // Number of slots that are full.
+  struct Slot {
+    T *member;
+    size_t dense;               // Position in dense_, or -1 if empty.
+    unsigned generation;        // Bumped each time the slot is emptied.
+  };
+  std::vector<Slot> slots_;     // Data, by slot.
+  std::vector<T *> dense_;      // The full slots' items, packed.
+  std::vector<size_t> owners_;  // Slot of each item in dense_.
   std::queue<size_t> recycled_; // Queue of slot indices to be recycled.
-  std::vector<void *> vector_;  // Data.
 
-  DISALLOW_COPY_AND_ASSIGN(Population);
+  DISALLOW_COPY_AND_ASSIGN(SlotMap);
 };
 
+template<class T>
+size_t
+SlotMap<T>::add(T *member)
+{
+  size_t i;
+
+  if (recycled_.empty()) {
+    i = slots_.size();
+    Slot s = { 0, 0, 0 };
+    slots_.push_back(s);
+  } else {
+    i = recycled_.front();
+    recycled_.pop();
+  }
+
+  slots_[i].member = member;
+  slots_[i].dense = dense_.size();
+  dense_.push_back(member);
+  owners_.push_back(i);
+  return i;
+}
+
+template<class T>
+T *
+SlotMap<T>::remove(size_t i)
+{
+  Slot &s = slots_.at(i);
+  if (s.dense == (size_t)-1)
+    return 0;
+
+  T *member = s.member;
+  size_t last = dense_.size() - 1;
+  if (s.dense != last) {        // Fill the hole with the last item.
+    dense_[s.dense] = dense_[last];
+    owners_[s.dense] = owners_[last];
+    slots_[owners_[last]].dense = s.dense;
+  }
+  dense_.pop_back();
+  owners_.pop_back();
+  s.member = 0;
+  s.dense = (size_t)-1;
+  s.generation++;
+  recycled_.push(i);
+  return member;
+}
+
+template<class T>
+void
+SlotMap<T>::destroy(size_t i)
+{
+  T *member = remove(i);
+  if (member)
+    free(member);
+}
+
+template<class T>
+void
+SlotMap<T>::reserve(size_t n)
+{
+  dense_.reserve(dense_.size() + n);
+  owners_.reserve(owners_.size() + n);
+  if (n > recycled_.size())
+    slots_.reserve(slots_.size() + n - recycled_.size());
+}
+
+template<class T>
+void
+SlotMap<T>::clear()
+{
+  slots_.clear();
+  dense_.clear();
+  owners_.clear();
+  while (!recycled_.empty())
+    recycled_.pop();
+}
+
+template<class T>
+T *
+SlotMap<T>::get(size_t i) const
+{
+  // Note: i is always non-negative because it is a size_t, which is unsigned
+  if (i < slots_.size())
+    return slots_[i].member;
+  uerror("Attempted to access out of bounds member of Population!");
+  return 0;
+}
+
+template<class T>
+T *
+SlotMap<T>::get(Handle h) const
+{
+  if (h.slot < slots_.size() && slots_[h.slot].generation == h.generation)
+    return slots_[h.slot].member;
+  return 0;
+}
+
+template<class T>
+typename SlotMap<T>::Handle
+SlotMap<T>::handle(size_t i) const
+{
+  Handle h;
+  h.slot = i;
+  h.generation = slots_.at(i).generation;
+  return h;
+}
+
+// The untyped population, for collections of mixed or non-pointer items
+typedef SlotMap<void> Population;
+
 /*****************************************************************************
  *  STL HELPERS                                                              *
  *****************************************************************************/
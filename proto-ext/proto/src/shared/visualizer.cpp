@@ -10,6 +10,11 @@ in the file LICENSE in the MIT Proto distribution's top directory. */
 #include "visualizer.h"
 #include "Trackball.h"
 #include "drawing_primitives.h"
+#ifdef WANT_OFFSCREEN
+#include <EGL/egl.h>
+#include <EGL/eglext.h>
+#include <png.h>
+#endif // WANT_OFFSCREEN
 
 Palette* palette; // current palette
 // NOTE: these interfaces need fixing!
@@ -39,7 +44,84 @@ Visualizer::Visualizer(Args* args)
   
   is_full_screen = args->extract_switch("-f");
   if(is_full_screen) { glutFullScreen(); }
-  
+  is_offscreen = false;
+  init_gl();
+}
+
+#ifdef WANT_OFFSCREEN
+// An offscreen visualizer draws into an EGL pbuffer rather than a GLUT
+// window, so it needs no display at all.  Mesa's surfaceless platform is
+// preferred, since the default platform usually wants an X server.
+Visualizer::Visualizer(int width, int height)
+  : bounds(0,1,0,1) { // default computer size, changed by spatialcomputer
+  EGLDisplay dpy = EGL_NO_DISPLAY;
+#ifdef EGL_PLATFORM_SURFACELESS_MESA
+  PFNEGLGETPLATFORMDISPLAYEXTPROC get_platform_display = 
+    (PFNEGLGETPLATFORMDISPLAYEXTPROC)
+    eglGetProcAddress("eglGetPlatformDisplayEXT");
+  if(get_platform_display)
+    dpy = get_platform_display(EGL_PLATFORM_SURFACELESS_MESA,
+                               EGL_DEFAULT_DISPLAY,NULL);
+#endif
+  if(dpy==EGL_NO_DISPLAY) dpy = eglGetDisplay(EGL_DEFAULT_DISPLAY);
+  EGLint major, minor, n_configs;
+  if(dpy==EGL_NO_DISPLAY || !eglInitialize(dpy,&major,&minor))
+    uerror("Offscreen rendering: no EGL display available");
+  EGLint config_attribs[] = {
+    EGL_SURFACE_TYPE, EGL_PBUFFER_BIT, EGL_RENDERABLE_TYPE, EGL_OPENGL_BIT,
+    EGL_RED_SIZE, 8, EGL_GREEN_SIZE, 8, EGL_BLUE_SIZE, 8, EGL_ALPHA_SIZE, 8,
+    EGL_DEPTH_SIZE, 16, EGL_NONE };
+  EGLConfig config;
+  if(!eglChooseConfig(dpy,config_attribs,&config,1,&n_configs) || n_configs<1)
+    uerror("Offscreen rendering: no EGL configuration supports OpenGL");
+  EGLint surface_attribs[] = { EGL_WIDTH, width, EGL_HEIGHT, height, EGL_NONE };
+  EGLSurface surface = eglCreatePbufferSurface(dpy,config,surface_attribs);
+  eglBindAPI(EGL_OPENGL_API);
+  EGLContext context = eglCreateContext(dpy,config,EGL_NO_CONTEXT,NULL);
+  if(surface==EGL_NO_SURFACE || context==EGL_NO_CONTEXT ||
+     !eglMakeCurrent(dpy,surface,surface,context))
+    uerror("Offscreen rendering: cannot create a %dx%d buffer",width,height);
+  egl_display=dpy; egl_surface=surface; egl_context=context;
+
+  this->width=width; this->height=height; left=top=0;
+  aspect_ratio = (flo)width/(flo)height;
+  is_full_screen = false; window = -1;
+  is_offscreen = true;
+  is_text_drawable = false; // stroke fonts belong to GLUT, which isn't up
+  init_gl();
+  glViewport(0, 0, width, height);
+}
+
+// Write the current frame as an 8-bit RGB PNG
+bool Visualizer::write_png(const char* filename) {
+  FILE* out = fopen(filename,"wb");
+  if(!out) { debug("Could not open snapshot file %s\n",filename); return false; }
+  png_structp png = png_create_write_struct(PNG_LIBPNG_VER_STRING,NULL,NULL,NULL);
+  png_infop info = png ? png_create_info_struct(png) : NULL;
+  if(!info || setjmp(png_jmpbuf(png))) {
+    png_destroy_write_struct(&png, info ? &info : NULL); fclose(out);
+    debug("Could not write snapshot file %s\n",filename); return false;
+  }
+  vector<png_byte> pixels(width*height*3);
+  glPixelStorei(GL_PACK_ALIGNMENT,1);
+  glReadPixels(0,0,width,height,GL_RGB,GL_UNSIGNED_BYTE,&pixels[0]);
+  vector<png_bytep> rows(height);
+  for(int i=0;i<height;i++) // GL rows start at the bottom
+    rows[i] = &pixels[(height-1-i)*width*3];
+  png_init_io(png,out);
+  png_set_IHDR(png,info,width,height,8,PNG_COLOR_TYPE_RGB,PNG_INTERLACE_NONE,
+               PNG_COMPRESSION_TYPE_DEFAULT,PNG_FILTER_TYPE_DEFAULT);
+  png_write_info(png,info);
+  png_write_image(png,&rows[0]);
+  png_write_end(png,NULL);
+  png_destroy_write_struct(&png,&info);
+  fclose(out);
+  return true;
+}
+#endif // WANT_OFFSCREEN
+
+// drawing state shared by windowed and offscreen visualizers
+void Visualizer::init_gl() {
   // use the default palette, register our colors, and patch files
   palette = Palette::default_palette;
   ensure_colors_registered("Visualizer");
@@ -81,6 +163,15 @@ void Visualizer::register_colors() {
 }
 
 Visualizer::~Visualizer() {
+#ifdef WANT_OFFSCREEN
+  if(is_offscreen) {
+    eglMakeCurrent(egl_display,EGL_NO_SURFACE,EGL_NO_SURFACE,EGL_NO_CONTEXT);
+    eglDestroyContext(egl_display,egl_context);
+    eglDestroySurface(egl_display,egl_surface);
+    eglTerminate(egl_display);
+    return;
+  }
+#endif // WANT_OFFSCREEN
   glutDestroyWindow(window);
 }
 
@@ -223,7 +314,8 @@ void Visualizer::end_3D() {
 
 // finish drawing a frame
 void Visualizer::complete_frame() {
-  glutSwapBuffers(); // implicitly makes sure drawing completes
+  if(is_offscreen) glFinish(); // nothing to swap: just let drawing complete
+  else glutSwapBuffers(); // implicitly makes sure drawing completes
 }
 
 void Visualizer::click_3d(int winx, int winy, double *pt) {
@@ -31,12 +31,19 @@ class Visualizer : public EventConsumer {
   Rect bounds; // area expected to be filled by computer
   int old_width,old_height; // saved pixel size of window
   int left,top; // screen location of window
+  void *egl_display, *egl_surface, *egl_context; // offscreen only
+  void init_gl(); // drawing state, once a GL context is current
  public:
   int width,height; // pixel size of window
+  bool is_offscreen; // drawing to a buffer instead of a window?
 
   
  public:
   Visualizer(Args* args);
+#ifdef WANT_OFFSCREEN
+  Visualizer(int width, int height); // windowless, for headless snapshots
+  bool write_png(const char* filename); // save the last completed frame
+#endif // WANT_OFFSCREEN
   ~Visualizer();
 
   void set_bounds(Rect* r) { 
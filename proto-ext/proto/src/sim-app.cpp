@@ -33,6 +33,7 @@ in the file LICENSE in the MIT Proto distribution's top directory. */
 map<string,uint8_t> OPCODE_MAP = create_opcode_map();
 
 void shutdown_app(void);
+void take_snapshot(void);
 
 #if USE_NEOCOMPILER
 NeoCompiler* compiler = NULL;
@@ -64,6 +65,13 @@ bool evolution_lagging = false; // is the simulator keeping up or not?
 double fps=1.0; // frames-per-second measurement
 bool show_time=false;
 string opcode_file=""; // file to look for opcodes
+// headless snapshots: an offscreen frame every snap_period of simulated time
+double snap_period = 0, next_snap = 0; // period 0 = no snapshots
+const char* snap_dir = "snaps";
+int snap_width = 640, snap_height = 480;
+double inject_time = -1; // when to inject the script again as a new version
+// the loaded script, kept for injection: a compiler can't compile twice
+uint8_t* loaded_script = NULL; int loaded_len = 0;
 
 
 // evolve all top-level items
@@ -73,8 +81,17 @@ void advance_time() {
      changed |= compiler->evolve(sim_time);
   changed |= (vis && vis->evolve(sim_time));
   changed |= computer->evolve(sim_time);
+  if(snap_period>0 && sim_time>=next_snap) {
+    take_snapshot();
+    while(next_snap <= sim_time) next_snap+=snap_period;
+  }
+  if(inject_time>=0 && sim_time>=inject_time && loaded_script) {
+    inject_time = -1;
+    computer->load_script_at_selection(loaded_script,loaded_len);
+  }
 #ifdef WANT_GLUT
-  if(changed && vis!=NULL) glutPostRedisplay(); // redraw only if needed
+  if(changed && vis!=NULL && !vis->is_offscreen)
+    glutPostRedisplay(); // redraw only if needed
 #endif // WANT_GLUT
 }
 
@@ -249,8 +266,8 @@ bool app_handle_key(KeyEvent *key) {
         last_inflection_real=get_real_secs();
         return true;
       case 'l':
-        int len; uint8_t* s = compiler->compile(compiler->last_script,&len);
-        computer->load_script_at_selection(s,len);
+        if(loaded_script)
+          computer->load_script_at_selection(loaded_script,loaded_len);
         return true;
       }
     }
@@ -335,6 +352,17 @@ void render () {
   vis->complete_frame();
 #endif // WANT_GLUT
 }
+
+// draw a frame offscreen and save it, named by its scheduled time
+void take_snapshot() {
+#ifdef WANT_OFFSCREEN
+  render();
+  char buf[1000];
+  snprintf(buf,sizeof(buf),"%s/snap%.2f.png",snap_dir,next_snap);
+  vis->write_png(buf);
+#endif // WANT_OFFSCREEN
+}
+
 // there should be something that blinks when the simulator can't keep up
 // with the time demands of its throttle [evolution_lagging==true]
 
@@ -442,12 +470,26 @@ void process_app_args(Args *args) {
   is_stepping = args->extract_switch("-step");
   // maximum time for simulation (useful for headless execution)
   if(args->extract_switch("-stop-after")) stop_time = args->pop_number();
+  // re-inject the program as a new version, to watch it spread by radio
+  if(args->extract_switch("-inject-script-at")) inject_time=args->pop_number();
   // throttle when told explicitly
   if(args->extract_switch("-throttle")) {
     is_sim_throttling=true;
     last_inflection_real=get_real_secs(); // need to know when it starts
   }
   show_time = args->extract_switch("-T");
+  // headless runs can save rendered frames at a fixed simulated interval
+  if(args->extract_switch("-snap-every")) snap_period = args->pop_number();
+  if(args->extract_switch("-snap-dir")) snap_dir = args->pop_next();
+  if(args->extract_switch("-snap-size")) {
+    snap_width = (int)args->pop_number(); snap_height = (int)args->pop_number();
+  }
+#ifndef WANT_OFFSCREEN
+  if(snap_period>0) {
+    post("WARNING: built without offscreen rendering; no snapshots taken\n");
+    snap_period = 0;
+  }
+#endif // WANT_OFFSCREEN
   // set the ratio between simulated and real time
   if(args->extract_switch("-ratio")) time_ratio = args->pop_number();
   // minimum amount of time to advance in each simulation step
@@ -553,9 +595,21 @@ int main (int argc, char *argv[]) {
 #ifdef WANT_GLUT
     palette = Palette::default_palette;
 #endif // WANT_GLUT
+#ifdef WANT_OFFSCREEN
+    if(snap_period>0) vis = new Visualizer(snap_width,snap_height);
+#endif // WANT_OFFSCREEN
+  }
+  if(snap_period>0) { // windowed or offscreen, snapshots need their directory
+#ifdef _WIN32  
+    mkdir(snap_dir);
+#else
+    mkdir(snap_dir, ACCESSPERMS);
+#endif
   }
 
   computer = new SpatialComputer(args,!test_mode);
+  // snapshots must not catch the "photo flash" of a dump
+  if(vis && vis->is_offscreen) computer->is_show_snaps = false;
 
   if(opcode_file != "") {
      post("reading opcodes from: %s\n", opcode_file.c_str());
@@ -567,10 +621,11 @@ int main (int argc, char *argv[]) {
      //   post("%d\n", s[i]);
      if(len > 0 && s != NULL) {
         computer->load_script(s,len);
+        loaded_script = s; loaded_len = len;
      }
      else
         uerror("Problem loading opcode file: %s", opcode_file.c_str());
-     if(!headless) {
+     if(vis) {
        vis->set_bounds(computer->vis_volume); // connect to computer
        register_app_colors();
      }
@@ -585,17 +640,16 @@ int main (int argc, char *argv[]) {
      string defops;
      computer->appendDefops(defops);
      compiler->setDefops(defops);
-     if(!headless) {
+     if(vis) {
         vis->set_bounds(computer->vis_volume); // connect to computer
         register_app_colors();
      }
      // load the script
-     int len;
      if(args->argc==1) {
         uerror("No program specified: all arguments consumed.");
      } else {
-       uint8_t* s = compiler->compile(args->argv[args->argc-1],&len);
-       computer->load_script(s,len);
+       loaded_script = compiler->compile(args->argv[args->argc-1],&loaded_len);
+       computer->load_script(loaded_script,loaded_len);
      }
   }
   // if in test mode, swap the C++ file for a C file for the SpatialComputer
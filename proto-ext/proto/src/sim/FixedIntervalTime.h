@@ -23,6 +23,7 @@ public:
   void next_compute(SECONDS* d_true, SECONDS* d_internal);
 
   DeviceTimer* clone_device() { return new FixedTimer(dt,internal_dt/dt); }
+  bool fixed_phase() { return dt>0; } // transmits come halfway through
   void set_internal_dt(SECONDS dt);
 
 };
@@ -38,6 +39,7 @@ public:
   DeviceTimer* next_timer(SECONDS* start_lag);
 
   SECONDS cycle_time() { return dt; }
+  bool lockstep() { return sync && dt>0; } // -sync ignores the variances
   Number set_dt (Number dt);
 
 };
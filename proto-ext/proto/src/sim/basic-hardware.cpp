@@ -301,6 +301,50 @@ void DebugDevice::visualize() {
 }
 
 
+// the sensor and LED disks of visualize, without the probe text
+void DebugDevice::visualize_batch(DrawBatch* batch, const flo* p) {
+#ifdef WANT_GLUT
+  static Color* user[N_USER_SENSORS] = {DebugLayer::USER_SENSOR_1, DebugLayer::USER_SENSOR_2,
+                           DebugLayer::USER_SENSOR_3, DebugLayer::USER_SENSOR_4}; 
+  flo rad = container->body->display_radius(), rgba[4];
+  for(int i=0;i<N_USER_SENSORS;i++) {
+    if(sensors[USER_A+i] > 0) { 
+      palette->get_rgba(user[i],rgba);
+      batch->disk(p,rad*SENSOR_RADIUS_FACTOR,rgba);
+    }
+  }
+  if (parent->is_show_leds) {
+    static Color* led_color[3] = 
+      {DebugLayer::RED_LED, DebugLayer::GREEN_LED, DebugLayer::BLUE_LED};
+    flo led[3] = { actuators[R_LED], actuators[G_LED],
+		   actuators[B_LED] };
+    if (parent->is_led_rgb) {
+      if (led[0] || led[1] || led[2]) {
+	palette->get_rgba(DebugLayer::RGB_LED,rgba,led[0],led[1],led[2],1);
+        flo q[3] = {p[0],p[1],p[2]+(parent->is_led_3d_motion ? 1 : 0)};
+        batch->disk(q,rad*2,rgba);
+      }
+    } else {
+      flo rise = 0; // unstacked LEDs climb on top of one another
+      for(int i=0;i<3;i++) {
+	if(led[i]==0) continue;
+        if(parent->is_led_ghost_mode)
+	  palette->get_rgba(led_color[i],rgba,1,1,1,led[i]);
+	else
+	  palette->get_rgba(led_color[i],rgba,led[i],led[i],led[i],1);
+        flo dz = parent->is_led_3d_motion ? led[i] : 0;
+        if(parent->is_led_fixed_stacking) {
+          if(parent->is_led_fixed_stacking==1) dz += i;
+        } else {
+          rise += dz; dz = rise;
+        }
+        flo q[3] = {p[0],p[1],p[2]+dz};
+        batch->disk(q,rad,rgba);
+      }
+    }
+  }
+#endif // WANT_GLUT
+}
 
 /*****************************************************************************
  *  PERFECT LOCALIZER                                                        *
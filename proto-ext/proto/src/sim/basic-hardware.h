@@ -84,6 +84,7 @@ public:
   DebugDevice(DebugLayer* parent, Device* container);
   void preupdate();
   void visualize();
+  void visualize_batch(DrawBatch* batch, const flo* p);
   bool handle_key(KeyEvent* event);
   void copy_state(DeviceLayer* src) {} // to be called during cloning
   void dump_state(FILE* out, int verbosity); // print state to file
@@ -0,0 +1,149 @@
+/* Over-the-air script dissemination
+Copyright (C) 2005-2010, Jonathan Bachrach, Jacob Beal, and contributors
+listed in the AUTHORS file in the MIT Proto distribution's top directory.
+
+This file is part of MIT Proto, and is distributed under the terms of
+the GNU General Public License, with a linking exception, as described
+in the file LICENSE in the MIT Proto distribution's top directory. */
+
+#include "config.h"
+#include <string.h>
+#include "utils.h"
+#include "dissemination.h"
+#include "protobo-msgs.h"
+
+// per-message overheads on the protobo radio, for bandwidth accounting
+#define DIGEST_MSG_HEADER offsetof(DIGEST_MSG,digest)
+#define SCRIPT_MSG_HEADER offsetof(SCRIPT_MSG,script)
+
+using namespace std;
+
+extern int radio_send_script_pkt(uint8_t version, uint16_t n, uint8_t pkt_num,
+                                 uint8_t *script);
+extern int radio_send_digest(uint8_t version, uint16_t script_len,
+                             uint8_t *digest);
+
+/*****************************************************************************
+ *  NETWORK-WIDE SETTINGS AND STATISTICS                                     *
+ *****************************************************************************/
+ScriptDisseminator::ScriptDisseminator(Args* args) {
+  // protobo packets carry 9 script bytes apiece
+  chunk = args->extract_switch("-script-chunk") ? args->pop_int() : 9;
+  pkts_per_round = args->extract_switch("-script-pkts-per-round") ?
+    args->pop_int() : 1;
+  advert_period = args->extract_switch("-script-advert-period") ?
+    args->pop_int() : 10;
+  chunk = max(chunk,1); pkts_per_round = max(pkts_per_round,1);
+}
+
+const uint8_t* ScriptDisseminator::image(int version, const uint8_t* script,
+                                         int len) {
+  vector<uint8_t>& img = images[version];
+  if(img.empty()) img.assign(script,script+len);
+  return &img[0];
+}
+
+void ScriptDisseminator::inject(int version, const uint8_t* script, int len,
+                                double time) {
+  image(version,script,len);
+  VersionStats* s = &stats[version];
+  s->injected = time; s->len = len;
+}
+
+void ScriptDisseminator::report(FILE* out, int n_devices) {
+  fprintf(out,"Script dissemination: %d-byte chunks, %d packets per round,"
+          " advert every %d rounds\n",chunk,pkts_per_round,advert_period);
+  map<int,VersionStats>::iterator it;
+  for(it=stats.begin(); it!=stats.end(); it++) {
+    VersionStats* s = &it->second;
+    fprintf(out,"Version %d: %d bytes in %d chunks, injected at %.2f\n",
+            it->first,s->len,num_chunks(s->len),s->injected);
+    vector<double>& l = s->latency;
+    int n = l.size();
+    if(n) {
+      sort(l.begin(),l.end());
+      double sum = 0; for(int i=0;i<n;i++) sum += l[i];
+      fprintf(out,"  installed on %d of %d devices; latency mean %.2f,"
+              " median %.2f, 90%% %.2f, max %.2f\n",n,n_devices,sum/n,
+              l[n/2],l[(n-1)*9/10],l[n-1]);
+    }
+    fprintf(out,"  sent %llu script packets (%llu bytes) and %llu digests"
+            " (%llu bytes); %llu duplicate chunks received\n",
+            (unsigned long long)s->pkts,(unsigned long long)s->pkt_bytes,
+            (unsigned long long)s->digests,(unsigned long long)s->digest_bytes,
+            (unsigned long long)s->duplicates);
+  }
+  fflush(out);
+}
+
+/*****************************************************************************
+ *  PER-DEVICE PROTOCOL                                                      *
+ *****************************************************************************/
+ScriptState::ScriptState(ScriptDisseminator* net) {
+  this->net = net; running = -1;
+  reset(-1,0);
+}
+
+void ScriptState::reset(int version, int len) {
+  this->version = version; this->len = len;
+  chunk = net->chunk_size(len); n_chunks = net->num_chunks(len);
+  n_have = n_wanted = 0;
+  buf.assign(len,0); have.assign((n_chunks+7)/8,0);
+  wanted.assign(n_chunks,false);
+  is_install_pending = false; is_advert_due = true; is_progressing = false;
+  rounds_since_advert = 0;
+}
+
+void ScriptState::seed(int version, const uint8_t* script, int len) {
+  reset(version,len);
+  memcpy(&buf[0],script,len);
+  for(int i=0;i<n_chunks;i++) have[i>>3] |= 1<<(i&7);
+  n_have = n_chunks; is_install_pending = true;
+}
+
+void ScriptState::receive_digest(uint8_t v, uint16_t n, uint8_t* digest) {
+  int fv = full_version(v);
+  if(fv > version) { reset(fv,n); return; } // ask for it at next broadcast
+  if(fv < version) { is_advert_due = true; return; } // sender is behind
+  // same version: queue whatever we hold that the sender lacks
+  for(int i=0;i<n_chunks;i++) {
+    if(holds(i) && !wanted[i] && !(digest[i>>3] & (1<<(i&7))))
+      { wanted[i] = true; n_wanted++; }
+  }
+}
+
+void ScriptState::receive_pkt(uint8_t v, uint16_t n, uint8_t pkt_num,
+                              uint8_t* data) {
+  int fv = full_version(v);
+  if(fv < version) { is_advert_due = true; return; }
+  if(fv > version) reset(fv,n);
+  if(pkt_num >= n_chunks) return;
+  if(wanted[pkt_num]) { wanted[pkt_num] = false; n_wanted--; } // overheard
+  if(holds(pkt_num)) { net->stats[version].duplicates++; return; }
+  memcpy(&buf[pkt_num*chunk],data,min(chunk,len-pkt_num*chunk));
+  have[pkt_num>>3] |= 1<<(pkt_num&7); is_progressing = true;
+  if(++n_have==n_chunks) is_install_pending = true;
+}
+
+void ScriptState::broadcast() {
+  if(version<0) return; // nothing to offer yet
+  rounds_since_advert++;
+  VersionStats* s = &net->stats[version];
+  // while chunks keep arriving, asking again would only add duplicates
+  bool is_stalled = !is_complete() && !is_progressing;
+  is_progressing = false;
+  if(n_wanted) { // serve missing chunks before advertising
+    for(int i=0, sent=0; i<n_chunks && sent<net->pkts_per_round; i++) {
+      if(!wanted[i]) continue;
+      wanted[i] = false; n_wanted--; sent++;
+      radio_send_script_pkt(version,len,i,&buf[i*chunk]);
+      s->pkts++; s->pkt_bytes += SCRIPT_MSG_HEADER+min(chunk,len-i*chunk);
+    }
+  } else if(is_stalled || is_advert_due ||
+            rounds_since_advert>=net->advert_period) {
+    // an incomplete digest doubles as a request for the missing chunks
+    radio_send_digest(version,len,&have[0]);
+    s->digests++; s->digest_bytes += DIGEST_MSG_HEADER+have.size();
+    is_advert_due = false; rounds_since_advert = 0;
+  }
+}
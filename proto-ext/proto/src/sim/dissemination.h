@@ -0,0 +1,90 @@
+/* Over-the-air script dissemination
+Copyright (C) 2005-2010, Jonathan Bachrach, Jacob Beal, and contributors
+listed in the AUTHORS file in the MIT Proto distribution's top directory.
+
+This file is part of MIT Proto, and is distributed under the terms of
+the GNU General Public License, with a linking exception, as described
+in the file LICENSE in the MIT Proto distribution's top directory. */
+
+#ifndef __DISSEMINATION__
+#define __DISSEMINATION__
+
+#include <stdint.h>
+#include <stdio.h>
+#include <algorithm>
+#include <map>
+#include <vector>
+
+class Args;
+
+// Scripts travel between devices as numbered chunks.  Every device
+// advertises the version it holds with a digest carrying one bit per chunk.
+// A device that hears of a newer version drops its partial copy and answers
+// with its own digest; neighbours holding chunks missing from that digest
+// queue them for broadcast, and drop any they overhear a neighbour send.
+
+#define MAX_SCRIPT_CHUNKS 256 // packet numbers are one byte
+
+struct VersionStats {
+  double injected;              // when the version entered the network
+  int len;                      // script bytes
+  std::vector<double> latency;  // injection to install, per device
+  uint64_t pkts, pkt_bytes, digests, digest_bytes, duplicates;
+  VersionStats() : injected(0), len(0), pkts(0), pkt_bytes(0), digests(0),
+                   digest_bytes(0), duplicates(0) {}
+};
+
+// Settings, installed script images and statistics for a whole network
+class ScriptDisseminator {
+ public:
+  int chunk;            // script bytes per packet (raised for long scripts)
+  int pkts_per_round;   // packets a device may send per broadcast
+  int advert_period;    // rounds between unprompted version adverts
+  // images stay put for the whole run, since VMs point into them
+  std::map<int,std::vector<uint8_t> > images;
+  std::map<int,VersionStats> stats;
+
+  ScriptDisseminator(Args* args);
+  int chunk_size(int len) {
+    return std::max(chunk,(len+MAX_SCRIPT_CHUNKS-1)/MAX_SCRIPT_CHUNKS);
+  }
+  int num_chunks(int len) { int c=chunk_size(len); return (len+c-1)/c; }
+  // the stable copy of a version's script, made the first time it's asked
+  const uint8_t* image(int version, const uint8_t* script, int len);
+  void inject(int version, const uint8_t* script, int len, double time);
+  void record_install(int version, double time)
+  { stats[version].latency.push_back(time-stats[version].injected); }
+  void report(FILE* out, int n_devices);
+};
+
+// One device's copy of the newest script it knows of
+class ScriptState {
+ public:
+  ScriptDisseminator* net;
+  int running;              // version installed in the VM
+  int version;              // version held or being fetched
+  int len, chunk, n_chunks, n_have, n_wanted;
+  std::vector<uint8_t> buf;  // chunks received so far
+  std::vector<uint8_t> have; // digest: one bit per chunk held
+  std::vector<bool> wanted;  // held chunks that a neighbour is missing
+  bool is_install_pending;   // complete, but not yet installed in the VM
+  bool is_advert_due;        // a neighbour is behind: advertise soon
+  bool is_progressing;       // new chunks arrived since the last broadcast
+  int rounds_since_advert;
+
+  ScriptState(ScriptDisseminator* net);
+  bool is_complete() { return n_have==n_chunks; }
+  // start holding a whole version, e.g. when injected at this device
+  void seed(int version, const uint8_t* script, int len);
+  // receive handlers, called by the radio layers
+  void receive_digest(uint8_t version, uint16_t len, uint8_t* digest);
+  void receive_pkt(uint8_t version, uint16_t n, uint8_t pkt_num,
+                   uint8_t* data);
+  void broadcast();         // send this round's packets or digest
+ private:
+  void reset(int version, int len);
+  int full_version(uint8_t v) { return version + (int8_t)(v-(uint8_t)version); }
+  bool holds(int i) { return have[i>>3] & (1<<(i&7)); }
+};
+
+#endif // __DISSEMINATION__
@@ -1,8 +1,35 @@
 
 void platform_operation(Int8); // This will be called for any unknown opcode.
 
+// Neighbour data expires once this many rounds have run without an update
+#define NEIGHBOUR_LIFETIME 2
+// Expired neighbours are removed from the hood once every this many rounds
+#define HOOD_RECLAIM_PERIOD 8
+
 class SimMachine : public Machine {
 	
+	public:
+		Counter rounds; // The number of rounds executed, used to age neighbour data.
+		
+		SimMachine() : rounds(0) {}
+		
+		// This machine itself never expires.
+		bool expired(Neighbour const & neighbour) const {
+			return rounds - neighbour.data_round > NEIGHBOUR_LIFETIME && &neighbour != &thisMachine();
+		}
+		
+		// Start a round: expired neighbours are only removed in periodic batches.
+		void next_round() {
+			rounds++;
+			if (rounds % HOOD_RECLAIM_PERIOD == 0) reclaim_expired();
+		}
+		
+		void reclaim_expired() {
+			for(NeighbourHood::iterator i = hood.begin(); i != hood.end(); ){
+				if (expired(*i)) i = hood.remove(i); else ++i;
+			}
+		}
+		
 	protected:
 		void execute_unknown(Int8 opcode) {
 			platform_operation(opcode);
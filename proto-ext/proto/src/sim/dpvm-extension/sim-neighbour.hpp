@@ -1,13 +1,13 @@
 
 class SimNeighbour : public Neighbour {
 	public:
-		Counter data_age; // The number of rounds executed since the last update of the data of this neighbour.
+		Counter data_round; // The round of the receiving machine in which the data of this neighbour was last updated.
 		Number x, y, z;
 		Number lag;
 		
 		bool in_range;
 		
-		SimNeighbour(MachineId const & id, Size imports) : Neighbour(id, imports) {x = 0; y = 0; z = 0; lag = 0; in_range = false;}
+		SimNeighbour(MachineId const & id, Size imports) : Neighbour(id, imports) {x = 0; y = 0; z = 0; lag = 0; in_range = false; data_round = 0;}
 };
 
 #undef Neighbour
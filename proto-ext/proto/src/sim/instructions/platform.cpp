@@ -75,10 +75,12 @@ namespace Instructions {
 		}
 		
 		Number machine_area(Machine & machine) {
+			machine.reclaim_expired();
 			return machine_disc_area(machine) / static_cast<Number>(machine.hood.size());
 		}
 		
 		Number machine_density(Machine & machine) {
+			machine.reclaim_expired();
 			return static_cast<Number>(machine.hood.size()) / machine_disc_area(machine);
 		}
 	}
@@ -0,0 +1,24 @@
+/* The protobo platform's radio message layouts
+Copyright (C) 2005-2010, Jonathan Bachrach, Jacob Beal, and contributors
+listed in the AUTHORS file in the MIT Proto distribution's top directory.
+
+This file is part of MIT Proto, and is distributed under the terms of
+the GNU General Public License, with a linking exception, as described
+in the file LICENSE in the MIT Proto distribution's top directory. */
+
+#ifndef __PROTOBO_MSGS__
+#define __PROTOBO_MSGS__
+
+// The message structs come from the platform; what they are sized by lives
+// in its proto_platform.h, which cannot be included here, so is repeated.
+// Needs -I$(top_srcdir)/platforms/protobo.
+
+#include <stddef.h>
+#include <stdint.h>
+
+typedef struct { uint8_t bytes[3]; } COM_DATA; // compressed export value
+#define MAX_SCRIPT_PKT 9
+#define MAX_DIGEST_PKT 4
+#include "proto_msg_structs.h"
+
+#endif // __PROTOBO_MSGS__
@@ -13,7 +13,8 @@ in the file LICENSE in the MIT Proto distribution's top directory. */
 /*****   IMPLEMENTATION *****/
 // Assuming an even distribution of N users into S time-slots, 
 // there is expected to be 4*N/S users per slot (each user has an
-// execute event and a transmit event, both generally in the front half
+// execute event and a transmit event, both generally in the front half;
+// users whose transmits have a fixed phase queue only one at a time)
 // Cycle time is the expected time of a devices' round
 Scheduler::Scheduler(int num_users, double cycle_time) {
   cur_slot=0;
@@ -22,6 +23,7 @@ Scheduler::Scheduler(int num_users, double cycle_time) {
   slot_cycle_time = cycle_time*2;
   working_min = 0; working_max = slot_cycle_time;
   cycle_safety = num_slots*10;
+  spare = NULL;
 }
 
 Scheduler::~Scheduler() {
@@ -29,11 +31,13 @@ Scheduler::~Scheduler() {
     evtList *l = queue[i];
     while(l) { evtList* next=l->next; free(l); l=next; }
   }
+  while(spare) { evtList* next=spare->next; free(spare); spare=next; }
   free(queue);
 }
 
 Event* Scheduler::insert_evt(int slot, double time) {
-  evtList *new_evt = (evtList*)malloc(sizeof(evtList));
+  evtList *new_evt = spare;
+  if(new_evt) spare=spare->next; else new_evt=(evtList*)malloc(sizeof(evtList));
   evtList *l = queue[slot];
   while(l) {
     if(time<l->e.true_time) {
@@ -84,10 +88,10 @@ int Scheduler::get_next_from_cur_slot() {
   evtList *l = queue[cur_slot];
   if(l && l->e.true_time<=bound_time) { // used to be working_max
     copy_evt(&l->e,scratch);
-    // remove event from list and deallocate
+    // remove event from list, saving it for reuse
     if(l->next) l->next->prev=l->prev;
     if(l->prev) { l->prev->next=l->next; } else { queue[cur_slot]=l->next; }
-    free(l);
+    l->next=spare; spare=l;
     return 1;
   } else return 0;
 }
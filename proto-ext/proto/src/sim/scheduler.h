@@ -44,6 +44,7 @@ class Scheduler {
   int bound_slot;                  // slot where searching may stop
   double bound_time;               // time when searching will stop
   int cycle_safety;                // infinite loop preventer
+  evtList *spare;                  // popped events, kept for reuse
   
   // internal routines
   Event* insert_evt(int slot, double time);
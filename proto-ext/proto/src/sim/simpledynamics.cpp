@@ -144,6 +144,27 @@ void SimpleBody::visualize() {
 #endif // WANT_GLUT
 }
 
+// batched bodies are drawn in the XY plane only
+void SimpleBody::visualize_batch(DrawBatch* batch, const flo* p) {
+#ifdef WANT_GLUT
+  if(!parent->is_show_bot) return; // don't display unless should be shown
+  flo rgba[4];
+  palette->get_rgba(SimpleDynamics::SIMPLE_BODY,rgba);
+  if (parent->is_mobile) {
+    batch->circle(p,radius,rgba);
+    if (parent->is_show_heading) {
+      Vek vec(v); 
+      flo l=vek_len(&vec);
+      if(l>0) vek_mul(&vec,radius/l); // normalize vel
+      flo h[3] = {p[0]+vec.x, p[1]+vec.y, p[2]+vec.z};
+      batch->line(p,h,rgba);
+    }
+  } else {
+    batch->point(p,rgba);
+  }
+#endif // WANT_GLUT
+}
+
 void SimpleBody::render_selection() {
 #ifdef WANT_GLUT
   flo x, y;
@@ -320,42 +341,40 @@ void SimpleDynamics::dump_header(FILE* out) {
 bool SimpleDynamics::evolve(SECONDS dt) {
   if(!is_mobile) return false;
   for(int i=0;i<bodies.max_id();i++) {
-    Body* b = (Body*)bodies.get(i);
-    if(b) { 
-      // device moves itself
-      Vek dp(b->velocity());
-      flo len = vek_dot(&dp,&dp);
-      if(act_err) {
-        dp.x += len*act_err*urnd(-0.5,0.5); 
-        dp.y += len*act_err*urnd(-0.5,0.5); 
-        dp.z += len*act_err*urnd(-0.5,0.5);
-      }
-      if (len > speed_lim*speed_lim) vek_mul(&dp,speed_lim/sqrt(len)); // limit velocity
-      vek_mul(&dp,dt);
-      // device is moved by walls
-      ((SimpleBody*)b)->wall_touch = false;
-      if (is_walls) {
-	for (int j=0; j<N_WALLS; j++) {
-	  Vek vec(b->position());
-	  vek_sub(&vec, &walls[j]);
-	  flo d = vek_dot(&vec, wall_normals[j]);
-	  if (d < 0.0) {
-	    vek_cpy(&vec, wall_normals[j]);
-	    vek_mul(&vec, -d * K_BOUND * dt);
-	    vek_add(&dp, &vec);
-            ((SimpleBody*)b)->wall_touch = true;
-	  }
-	}
+    SimpleBody* b = bodies.get(i); if(!b) continue;
+    // device moves itself
+    Vek dp(b->velocity());
+    flo len = vek_dot(&dp,&dp);
+    if(act_err) {
+      dp.x += len*act_err*urnd(-0.5,0.5); 
+      dp.y += len*act_err*urnd(-0.5,0.5); 
+      dp.z += len*act_err*urnd(-0.5,0.5);
+    }
+    if (len > speed_lim*speed_lim) vek_mul(&dp,speed_lim/sqrt(len)); // limit velocity
+    vek_mul(&dp,dt);
+    // device is moved by walls
+    b->wall_touch = false;
+    if (is_walls) {
+      for (int j=0; j<N_WALLS; j++) {
+        Vek vec(b->position());
+        vek_sub(&vec, &walls[j]);
+        flo d = vek_dot(&vec, wall_normals[j]);
+        if (d < 0.0) {
+          vek_cpy(&vec, wall_normals[j]);
+          vek_mul(&vec, -d * K_BOUND * dt);
+          vek_add(&dp, &vec);
+            b->wall_touch = true;
+        }
       }
-      // adjust the position
-      Vek pos(b->position());
-      b->moved = (dp.x||dp.y||dp.z);
-      vek_add(&pos,&dp);
-      if(parent->volume->dimensions()==2) { pos.z=0; }
-      // Hard floor at z=0: if the calculated pos has z < 0, reset to 0
-      else if(is_hard_floor && pos.z<0) { pos.z=0; b->moved=true; }
-      b->set_position(pos.x,pos.y,pos.z);
     }
+    // adjust the position
+    Vek pos(b->position());
+    b->moved = (dp.x||dp.y||dp.z);
+    vek_add(&pos,&dp);
+    if(parent->volume->dimensions()==2) { pos.z=0; }
+    // Hard floor at z=0: if the calculated pos has z < 0, reset to 0
+    else if(is_hard_floor && pos.z<0) { pos.z=0; b->moved=true; }
+    b->set_position(pos.x,pos.y,pos.z);
   }
   return true;
 }
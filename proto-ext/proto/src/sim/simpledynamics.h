@@ -54,6 +54,7 @@ class SimpleBody : public Body {
   ~SimpleBody();
   void preupdate();
   void visualize();
+  void visualize_batch(DrawBatch* batch, const flo* p);
   void render_selection();
   void dump_state(FILE* out, int verbosity); // print state to file
 };
@@ -65,7 +66,7 @@ class SimpleBody : public Body {
 class SimpleDynamics : public BodyDynamics, HardwarePatch {
   friend class SimpleBody;
  protected:
-  Population bodies;
+  SlotMap<SimpleBody> bodies;
   flo body_radius;
   flo act_err; // fraction by which actuation varies
   Point walls[N_WALLS];
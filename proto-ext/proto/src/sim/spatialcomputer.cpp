@@ -17,8 +17,7 @@ in the file LICENSE in the MIT Proto distribution's top directory. */
 #include "visualizer.h"
 #include "plugin_manager.h"
 #include "DefaultsPlugin.h"
-
-extern map<string,uint8_t> OPCODE_MAP;
+#include "vmprofiler.h"
 
 /*****************************************************************************
  *  DEVICE                                                                   *
@@ -47,23 +46,18 @@ Device::Device(SpatialComputer* parent, METERS *loc, DeviceTimer *timer) {
   } else {
 	  is_print_env_stack = false;
   }
+  script = parent->disseminator ? new ScriptState(parent->disseminator) : NULL;
 }
 
 // copy all state
 Device* Device::clone_device(METERS *loc) {
   Device* new_d = new Device(parent,loc,timer->clone_device());
 
-  //void Device::load_script(uint8_t* script, int len) {
-  //  new_machine(vm, uid, 0, 0, 0, 1, script, len);
-  //uint8_t *copy_src = vm->membuf, *copy_dst = new_d->vm->membuf;
-  //for(int i=0;i<vm->memlen;i++) { copy_dst[i]=copy_src[i]; }
-  new_d->load_script(vm->currentScript(),vm->currentScript().size());
-  // copy over state
-  
-  //new_d->vm->time = vm->time;  new_d->vm->last_time = vm->last_time;
-  for(size_t i = 0; i < new_d->vm->threads.size(); i++) {
-    new_d->vm->threads[i] = vm->threads[i];
-  }
+  // the clone shares the script, and takes over the installed VM state
+  // instead of executing the installation script again
+  new_d->vm->id = new_d->uid;
+  new_d->vm->install(*vm);
+  if(script) *new_d->script = *script;
   
   new_d->run_time=run_time; new_d->is_selected=is_selected; 
   //new_d->is_debug=is_debug;
@@ -82,6 +76,7 @@ Device::~Device() {
   free(layers);
   //deallocate_machine(&vm);
   delete vm;
+  delete script;
 }
 
 // dump function should produce matlab-readable data at verbosity 0
@@ -118,6 +113,8 @@ void Device::dump_state(FILE* out, int verbosity) {
     }
   }
 
+  vm->reclaim_expired(); // so that the dumped hood holds only live neighbours
+
   // dump network graph structure
   if(parent->is_dump_network) {
     char buf[1000];
@@ -164,31 +161,29 @@ void Device::load_script(uint8_t const * script, int len) {
   //new_machine(vm, uid, 0, 0, 0, 1, script, len);
   vm->id = uid;
   vm->install(Script(script,len));
-  int iStep = 0;
-  while(!vm->finished()) {
-	 	if (is_print_stack || is_print_env_stack) {
-	    	Int8 opcode = *(vm->instruction_pointer);
-	    	cout << "OpCode: " << (int)opcode;
-	    	Instruction i = instructions[opcode];
-	   		map<string,uint8_t>::iterator it;
-	   		for ( it=OPCODE_MAP.begin() ; it != OPCODE_MAP.end(); it++ ) {
-	   			if ((*it).second == opcode) {
-	   				cout << " " << (*it).first;
-    				break;
-	   			}
-	   		}
-	 	}
-	 	if (is_print_stack) {
-	 		cout << " Stack (" << iStep << "): ";
-	 		vm->print_stack(&vm->stack);
-	    }
-	 	if (is_print_env_stack) {
-	   	  cout << " Environment Stack (" << iStep << "): ";
-	   	  vm->print_stack(&vm->environment);
-	   	}
-     	iStep++;
-	    vm->step();
-    }
+  execute_vm();
+}
+
+// the VM points into the script, so it runs from the network-wide image
+void Device::install_pending_script() {
+  ScriptDisseminator* net = parent->disseminator;
+  load_script(net->image(script->version,&script->buf[0],script->len),
+              script->len);
+  script->running = script->version; script->is_install_pending = false;
+  net->record_install(script->version,parent->sim_time);
+}
+
+// run the VM until the script finishes, with the tracing policy selected
+// once per run rather than per instruction
+void Device::execute_vm() {
+  if(parent->profiler) {
+    ProfileTracer t(parent->profiler); run_to_completion(vm,t);
+  } else if(is_print_stack || is_print_env_stack) {
+    StackTracer t(is_print_stack,is_print_env_stack); run_to_completion(vm,t);
+    cout << endl;
+  } else {
+    NullTracer t; run_to_completion(vm,t);
+  }
 }
 
 // a convenient combined function
@@ -207,67 +202,36 @@ void Device::text_scale() {
 extern void radio_send_export(uint8_t version, Array<Data> const & data);
 
 void Device::internal_event(SECONDS time, DeviceEvent type) {
-  int iStep = 0;
   switch(type) {
   case COMPUTE:
+    if(script && script->is_install_pending) install_pending_script();
     body->preupdate(); // run the pre-compute update
     for(int i=0;i<num_layers;i++)
       { DeviceLayer* d = (DeviceLayer*)layers[i]; if(d) d->preupdate(); }
-    {
-      vm->thisMachine().data_age = 0;
-      for( NeighbourHood::iterator i = vm->hood.begin(); i != vm->hood.end(); ){
-        if (i->data_age > 1) {
-          i = vm->hood.remove(i);
-        } else {
-          i->data_age++;
-          ++i;
-        }
-      }
-    }
+    vm->next_round(); // ages neighbour data; stale entries are reclaimed lazily
 
     // double-delay kludge option: just run the VM a second time
-    for(int vmrun=0;vmrun<=(2*parent->is_double_delay_kludge);vmrun++) {
-      vm->run(time);
-      while(!vm->finished()) {
-    	if (is_print_stack || is_print_env_stack) {
-          Int8 opcode = *(vm->instruction_pointer);
-          cout << "OpCode: " << (int)opcode;
-          Instruction i = instructions[opcode];
-          map<string,uint8_t>::iterator it;
-          for ( it=OPCODE_MAP.begin() ; it != OPCODE_MAP.end(); it++ ) {
-            if ((*it).second == opcode) {
-              cout << " " << (*it).first;
-              break;
-            }
-          }
-
-          if (is_print_stack) {
-            cout << " Stack (" << iStep << "): ";
-            vm->print_stack(&vm->stack);
-          }
-          if (is_print_env_stack) {
-            cout << " Environment Stack (" << iStep << "): ";
-            vm->print_stack(&vm->environment);
-          }
-          iStep++;
-        }
-    	vm->step();
-      }
-      if (is_print_stack || is_print_env_stack) {
-    	cout << endl;
+    {
+      uint64_t start = parent->profiler ? profile_ticks() : 0;
+      for(int vmrun=0;vmrun<=(2*parent->is_double_delay_kludge);vmrun++) {
+        vm->run(time);
+        execute_vm();
       }
+      if(parent->profiler)
+        parent->profiler->record_round(uid,profile_ticks()-start);
     }
 
     body->update(); // run the post-compute update
     for(int i=0;i<num_layers;i++)
       { DeviceLayer* d = (DeviceLayer*)layers[i]; if(d) d->update(); }
     break;
-  case BROADCAST:
-    //export_machine();
-    /*if(script_export_needed() || (((int)vm->ticks) % 10)==0) {
-      export_script(); // send script every 10 rounds, or as needed
-    }*/
-    radio_send_export(0,vm->thisMachine().imports);
+  case BROADCAST: case ROUND_BROADCAST:
+    if(script) script->broadcast(); // script chunks or digest, as needed
+    radio_send_export(script ? script->running : 0,
+                      vm->thisMachine().imports);
+    break;
+  case COMPUTE_BROADCAST:
+    internal_event(time,COMPUTE); internal_event(time,BROADCAST);
     break;
   }
 }
@@ -352,9 +316,11 @@ void Device::visualize() {
   if(vis_context->is_show_version) {
     glPushMatrix();
     palette->use_color(SpatialComputer::DEVICE_ID);
-    //sprintf(buf, "%2d:%s", vm->scripts[vm->cur_script].version,
-	//    (vm->scripts[vm->cur_script].is_complete)?"OK":"wait");
-	strcpy(buf, "0:OK");
+    if(script)
+      sprintf(buf, "%2d:%s", script->version,
+              script->is_complete() ? "OK" : "wait");
+    else
+      strcpy(buf, "0:OK");
     draw_text(4, 4, buf);
     glPopMatrix();
   }
@@ -362,6 +328,41 @@ void Device::visualize() {
 #endif // WANT_GLUT
 }
 
+// The shapes of visualize, collected into a batch; text is left out
+void Device::visualize_batch(DrawBatch* batch) {
+#ifdef WANT_GLUT
+  const flo* p = body->position();
+  body->visualize_batch(batch,p);
+  for(int i=0;i<num_layers;i++)
+    { DeviceLayer* d = (DeviceLayer*)layers[i]; if(d) d->visualize_batch(batch,p); }
+  flo rgba[4];
+  if(is_selected) {
+    palette->get_rgba(SpatialComputer::DEVICE_SELECTED,rgba);
+    batch->circle(p,4*body->display_radius(),rgba);
+  }
+  if(debug()) {
+    flo q[3] = {p[0],p[1],p[2]-0.1f};
+    palette->get_rgba(SpatialComputer::DEVICE_DEBUG,rgba);
+    batch->disk(q,2*body->display_radius(),rgba);
+  }
+  if (vis_context->is_show_vec) {
+    Data dst = vm->threads[0].result;
+    if (dst.type()==Data::Type_tuple && dst.asTuple().size() >= 2) {
+      Tuple const & v = dst.asTuple();
+      flo x = v[0].asNumber();
+      flo y = v[1].asNumber();
+      flo z = v.size() > 2 ? v[2].asNumber() : 0;
+      flo mid[3] = {p[0]+0.8f*x, p[1]+0.8f*y, p[2]+0.8f*z};
+      flo tip[3] = {p[0]+x, p[1]+y, p[2]+z};
+      palette->get_rgba(SpatialComputer::VECTOR_BODY,rgba);
+      batch->line(p,mid,rgba);
+      palette->get_rgba(SpatialComputer::VECTOR_TIP,rgba);
+      batch->line(mid,tip,rgba);
+    }
+  }
+#endif // WANT_GLUT
+}
+
 // Special render for OpenGL selection mode
 void Device::render_selection() {
 #ifdef WANT_GLUT
@@ -455,6 +456,13 @@ SpatialComputer::SpatialComputer(Args* args, bool own_dump) {
 
   print_stack_id = (args->extract_switch("-print-stack"))?args->pop_number() : -1;
   print_env_stack_id = (args->extract_switch("-print-env-stack"))?args->pop_number() : -1;
+  profiler = NULL;
+  if(args->extract_switch("-profile-vm"))
+    profiler = new VMProfiler(args->extract_switch("-profile-top") ?
+                              max(0,(int)args->pop_number()) : 10);
+  disseminator = args->extract_switch("-disseminate") ?
+    new ScriptDisseminator(args) : NULL;
+  version = 0;
 
   int n=(args->extract_switch("-n"))?(int)args->pop_number():100; // # devices
   // load dumping variables
@@ -472,6 +480,7 @@ SpatialComputer::SpatialComputer(Args* args, bool own_dump) {
   dump_start = args->extract_switch("-dump-after") ? args->pop_number() : 0;
   dump_period = args->extract_switch("-dump-period") ? args->pop_number() : 1;
   is_own_dump_file=own_dump; // create dump files unless told otherwise
+  dump_file=NULL;
   if(own_dump) {
     dump_dir = args->extract_switch("-dump-dir") ? args->pop_next() : "dumps";
     dump_stem = args->extract_switch("-dump-stem") ? args->pop_next() : "dump";
@@ -482,6 +491,12 @@ SpatialComputer::SpatialComputer(Args* args, bool own_dump) {
   initialize_plugins(args, n);
 
   scheduler = new Scheduler(n, time_model->cycle_time());
+  is_sync_rounds = !args->extract_switch("-no-sync-rounds");
+  is_sync_rounds &= time_model->lockstep();
+  // coalesced rounds go through the queue, where the saving is
+  is_coalesce_rounds = args->extract_switch("-coalesce-rounds");
+  if(is_coalesce_rounds) is_sync_rounds = false;
+  sync_compute[0] = sync_compute[1] = 0; sync_broadcast_pending = false;
   // create the actual devices
   METERS loc[3];
   for(int i=0;i<n;i++) {
@@ -489,7 +504,8 @@ SpatialComputer::SpatialComputer(Args* args, bool own_dump) {
       SECONDS start;
       Device* d = new SimulatedDevice(this,loc,time_model->next_timer(&start));
       d->backptr = devices.add(d);
-      scheduler->schedule_event((void*)d->backptr,start,0,COMPUTE,d->uid);
+      if(!is_sync_rounds)
+        scheduler->schedule_event((void*)d->backptr,start,0,COMPUTE,d->uid);
     }
   }
   
@@ -499,6 +515,11 @@ SpatialComputer::SpatialComputer(Args* args, bool own_dump) {
   is_show_vec = args->extract_switch("-sv");
   is_show_id = args->extract_switch("-i");
   is_show_version = args->extract_switch("-show-script-version");
+  is_batch_render = args->extract_switch("-batch-render");
+  batch = NULL;
+#ifdef WANT_GLUT
+  if(is_batch_render) batch = new DrawBatch();
+#endif // WANT_GLUT
   is_debug = args->extract_switch("-g");
   hardware.is_kernel_trace = args->extract_switch("-t");
   hardware.is_kernel_debug = args->extract_switch("-debug-kernel");
@@ -506,11 +527,17 @@ SpatialComputer::SpatialComputer(Args* args, bool own_dump) {
 }
 
 SpatialComputer::~SpatialComputer() {
+  FILE* report = report_file();
+  if(profiler) { profiler->report(report); delete profiler; }
+  if(disseminator)
+    { disseminator->report(report,devices.size()); delete disseminator; }
   // delete devices first, because their "death" needs dynamics to still exist
-  for(int i=0;i<devices.max_id();i++)
-    { Device* d = (Device*)devices.get(i); if(d) delete d; }
+  for(int k=0;k<devices.size();k++) delete devices.member(k);
   // delete everything else in arbitrary order
   delete scheduler; delete volume; delete time_model; delete distribution;
+#ifdef WANT_GLUT
+  delete batch;
+#endif // WANT_GLUT
   for(int i=0;i<dynamics.max_id();i++) 
     { Layer* ec = (Layer*)dynamics.get(i); if(ec) delete ec; }
 }
@@ -618,31 +645,32 @@ void SpatialComputer::initialize_plugins(Args* args, int n) {
  *****************************************************************************/
 // for the initial loading only
 void SpatialComputer::load_script(uint8_t* script, int len) {
-  for(int i=0;i<devices.max_id();i++) { 
-    Device* d = (Device*)devices.get(i); 
-    if(d) {
-      hardware.set_vm_context(d);
+  if(disseminator) disseminator->inject(version,script,len,sim_time);
+  for(int k=0;k<devices.size();k++) { 
+    Device* d = devices.member(k); 
+    hardware.set_vm_context(d);
+    if(d->script) {
+      d->script->seed(version,script,len); d->install_pending_script();
+    } else {
       d->load_script(script,len); 
     }
   }
 }
-// install a script by injecting it as packets w. the next version
+// inject a script as the next version at the selected devices (or the
+// first device, if none are selected), to spread from there by radio
 void SpatialComputer::load_script_at_selection(uint8_t* script, int len) {
-	/*
-  for(int i=0;i<selection.max_id();i++) {
-    Device* d = (Device*)devices.get((long)selection.get(i));
-    if(d) {
-      hardware.set_vm_context(d);
-      version++;
-      for (i=0; i < (int)floor(len  / (float)MAX_SCRIPT_PKT); i++) {
-	radio_receive_script_pkt(version, len, i, &script[i*MAX_SCRIPT_PKT]);
-      }
-      if (len % MAX_SCRIPT_PKT) {
-	radio_receive_script_pkt(version, len, i, &script[i*MAX_SCRIPT_PKT]);
-      }
-    }
+  if(!disseminator)
+    { post("Script injection requires -disseminate\n"); return; }
+  if(!devices.size()) return;
+  version++;
+  disseminator->inject(version,script,len,sim_time);
+  vector<Device*> targets;
+  for(int k=0;k<selection.size();k++) {
+    Device* d = devices.get((long)selection.member(k));
+    if(d) targets.push_back(d);
   }
-  */
+  if(targets.empty()) targets.push_back(devices.member(0));
+  for(int i=0;i<targets.size();i++) targets[i]->script->seed(version,script,len);
 }
 
 bool SpatialComputer::handle_key(KeyEvent* key) {
@@ -657,8 +685,8 @@ bool SpatialComputer::handle_key(KeyEvent* key) {
     case 'a': hardware.is_kernel_trace = !hardware.is_kernel_trace; return true;
     case 'd': is_debug = !is_debug; return true;
     case 'D':
-      for(int i=0;i<selection.max_id();i++) {
-        Device* d = (Device*)devices.get((long)selection.get(i));
+      for(int k=0;k<selection.size();k++) {
+        Device* d = devices.get((long)selection.member(k));
         if(d) d->is_debug = !d->is_debug;
       }
       return true;
@@ -677,8 +705,8 @@ bool SpatialComputer::handle_key(KeyEvent* key) {
     if(d && d->handle_key(key)) return true;
   }
   bool in_selection = false;
-  for(int i=0;i<selection.max_id();i++) {
-    Device* d = (Device*)devices.get((long)selection.get(i));
+  for(int k=0;k<selection.size();k++) {
+    Device* d = devices.get((long)selection.member(k));
     if(d) in_selection |= d->handle_key(key);
   }
   return false;
@@ -697,8 +725,13 @@ void SpatialComputer::visualize() {
   physics->visualize();
   for(int i=0;i<dynamics.max_id();i++)
     { Layer* d = (Layer*)dynamics.get(i); if(d) d->visualize(); }
-  for(int i=0;i<devices.max_id();i++)
-    { Device* d = (Device*)devices.get(i); if(d) d->visualize(); }
+  if(is_batch_render) {
+    batch->clear();
+    for(int k=0;k<devices.size();k++) devices.member(k)->visualize_batch(batch);
+    batch->draw();
+  } else {
+    for(int k=0;k<devices.size();k++) devices.member(k)->visualize();
+  }
   // show "photo flashes" when dumps have occured
   SECONDS time = get_real_secs();
   if(just_dumped) { just_dumped=false; snap_vis_time = time; }
@@ -710,15 +743,14 @@ void SpatialComputer::visualize() {
 // special render for OpenGL selecting mode
 void SpatialComputer::render_selection() {
   vis_context=this;
-  for(int i=0;i<devices.max_id();i++)
-    { Device* d = (Device*)devices.get(i); if(d) d->render_selection(); }
+  for(int k=0;k<devices.size();k++) devices.member(k)->render_selection();
 }
 void SpatialComputer::update_selection() {
-  for(int i=0;i<devices.max_id();i++) // clear old selection bits
-    { Device* d = (Device*)devices.get(i); if(d) d->is_selected=false; }
-  for(int i=0;i<selection.max_id();i++) { // set new selection bits
-    int n = (long)selection.get(i);
-    Device* d = (Device*)devices.get(n); 
+  for(int k=0;k<devices.size();k++) // clear old selection bits
+    devices.member(k)->is_selected=false;
+  for(int k=0;k<selection.size();k++) { // set new selection bits
+    int n = (long)selection.member(k);
+    Device* d = devices.get(n); 
     if(d) d->is_selected=true;
   }
 }
@@ -727,9 +759,9 @@ void SpatialComputer::drag_selection(flo* delta) {
     delta[2]=0;
   }
   if(delta[0]==0 && delta[1]==0 && delta[2]==0) return;
-  for(int i=0;i<selection.max_id();i++) { // move each selected device
-    int n = (long)selection.get(i);
-    Device* d = (Device*)devices.get(n); 
+  for(int k=0;k<selection.size();k++) { // move each selected device
+    int n = (long)selection.member(k);
+    Device* d = devices.get(n); 
     if(d) { 
       const flo* p = d->body->position(); // calc new position
       d->body->set_position(p[0]+delta[0],p[1]+delta[1],p[2]+delta[2]);
@@ -739,13 +771,99 @@ void SpatialComputer::drag_selection(flo* delta) {
   }
 }
 
+// true and internal times of the next compute (t[0],t[1]) and transmit
+// (t[2],t[3]) of a device that has just computed
+void SpatialComputer::next_round_times(Device* d, SECONDS* t) {
+  d->timer->next_compute(&t[0],&t[1]); t[0]+=sim_time; t[1]+=d->run_time;
+  d->timer->next_transmit(&t[2],&t[3]); t[2]+=sim_time; t[3]+=d->run_time;
+}
+
+void SpatialComputer::schedule_round(int id, Device* d, SECONDS* t) {
+  if(d->timer->fixed_phase() && is_coalesce_rounds) {
+    // the broadcast moves up to its compute: one insert and one pop a round
+    scheduler->schedule_event((void*)id,t[0],t[1],COMPUTE_BROADCAST,d->uid);
+  } else if(d->timer->fixed_phase()) {
+    // only the broadcast is queued; it schedules the compute after it, so
+    // the queue holds one event per device, though as many are popped
+    d->next_compute[0] = t[0]; d->next_compute[1] = t[1];
+    scheduler->schedule_event((void*)id,t[2],t[3],ROUND_BROADCAST,d->uid);
+  } else {
+    scheduler->schedule_event((void*)id,t[0],t[1],COMPUTE,d->uid);
+    scheduler->schedule_event((void*)id,t[2],t[3],BROADCAST,d->uid);
+  }
+}
+
+// Lockstep devices all compute at the same moment and all broadcast at the
+// same moment, in the order the scheduler would have popped them (their
+// order in the population).  Each phase is thus a single sweep over the
+// devices, and since no broadcast lands until every device has computed,
+// no device can see data from the round it is computing.
+void SpatialComputer::run_sync_rounds(SECONDS limit) {
+  while(true) {
+    if(sync_broadcast_pending) {
+      if(sync_broadcast[0] > limit) return;
+      sim_time = sync_broadcast[0];
+      for(int i=0;i<devices.max_id();i++) {
+        Device* d = (Device*)devices.get(i);
+        if(!d) continue;
+        hardware.set_vm_context(d);
+        d->internal_event(sync_broadcast[1],BROADCAST);
+      }
+      sync_broadcast_pending = false;
+    }
+    if(sync_compute[0] > limit) return;
+    sim_time = sync_compute[0];
+    SECONDS next[4], t[4]; bool first = true;
+    for(int i=0;i<devices.max_id();i++) {
+      Device* d = (Device*)devices.get(i);
+      if(!d) continue;
+      hardware.set_vm_context(d);
+      d->internal_event(sync_compute[1],COMPUTE);
+      d->run_time = sync_compute[1];
+      next_round_times(d,t);
+      if(first) { for(int j=0;j<4;j++) next[j]=t[j]; first=false; }
+      // a device that changed its own period breaks the lockstep
+      bool same = d->timer->fixed_phase();
+      for(int j=0;j<4;j++) same &= (t[j]==next[j]);
+      if(!same) { // hand the rest of the round over to the scheduler
+        for(int j=0;j<devices.max_id();j++) {
+          Device* o = (Device*)devices.get(j);
+          if(!o) continue;
+          if(j<i) schedule_round(j,o,next);
+          else if(j==i) schedule_round(j,o,t);
+          else scheduler->schedule_event((void*)j,sim_time,sync_compute[1],
+                                         COMPUTE,o->uid);
+        }
+        is_sync_rounds = false;
+        return;
+      }
+    }
+    sync_compute[0] = next[0]; sync_compute[1] = next[1];
+    sync_broadcast[0] = next[2]; sync_broadcast[1] = next[3];
+    sync_broadcast_pending = true;
+  }
+}
+
+// queue every device's next event, between sync phases, and stop using them
+void SpatialComputer::leave_sync_rounds() {
+  SECONDS t[4] = {sync_compute[0],sync_compute[1],
+                  sync_broadcast[0],sync_broadcast[1]};
+  for(int i=0;i<devices.max_id();i++) {
+    Device* d = (Device*)devices.get(i);
+    if(!d) continue;
+    if(sync_broadcast_pending) schedule_round(i,d,t);
+    else scheduler->schedule_event((void*)i,t[0],t[1],COMPUTE,d->uid);
+  }
+  is_sync_rounds = false;
+}
+
 bool SpatialComputer::evolve(SECONDS limit) {
   SECONDS dt = limit-sim_time;
   // evolve world
   physics->evolve(dt);
   for(int i=0;i<devices.max_id();i++) { // tell layers about moving devices
-    Device* d = (Device*)devices.get(i);
-    if(d && d->body->moved) {
+    Device* d = devices.get(i); if(!d) continue;
+    if(d->body->moved) {
       for(int j=0;j<dynamics.max_id();j++) 
         { Layer* dyn = (Layer*)dynamics.get(j); if(dyn) dyn->device_moved(d); }
       d->body->moved=false;
@@ -758,6 +876,7 @@ bool SpatialComputer::evolve(SECONDS limit) {
   }
   // evolve devices
   Event e; scheduler->set_bound(limit);
+  if(is_sync_rounds) run_sync_rounds(limit); // queue is used only if it quits
   while(scheduler->pop_next_event(&e)) {
     int id = (long)e.target;
     Device* d = (Device*)devices.get(id);
@@ -765,38 +884,42 @@ bool SpatialComputer::evolve(SECONDS limit) {
       sim_time=e.true_time; // set time to new value
       hardware.set_vm_context(d); // align kernel/sim patch for this device
       d->internal_event(e.internal_time,(DeviceEvent)e.type);
-      if(e.type==COMPUTE) {
+      if(e.type==COMPUTE || e.type==COMPUTE_BROADCAST) {
         d->run_time = e.internal_time;
-        SECONDS tt, it;  // true and internal time
-        d->timer->next_compute(&tt,&it); tt+=sim_time; it+=d->run_time;
-	scheduler->schedule_event((void*)id,tt,it,COMPUTE,d->uid);
-        d->timer->next_transmit(&tt,&it); tt+=sim_time; it+=d->run_time;
-        scheduler->schedule_event((void*)id,tt,it,BROADCAST,d->uid);
+        SECONDS t[4]; next_round_times(d,t);
+        schedule_round(id,d,t);
+      } else if(e.type==ROUND_BROADCAST) {
+        scheduler->schedule_event((void*)id,d->next_compute[0],
+                                  d->next_compute[1],COMPUTE,d->uid);
       }
     }
   }
   sim_time=limit;
   
-  // clone or kill devices (at end of update period)
-  while(!death_q.empty()) {
-    int id = death_q.front(); death_q.pop(); // get next to kill
+  // clone or kill devices (at end of update period), as one batch each;
+  // the request lists keep their storage from one period to the next
+  for(int k=0;k<death_q.size();k++) {
+    int id = death_q[k];
     Device* d = (Device*)devices.get(id);
     if(d) {
       // scheduled events for dead devices are ignored; need not be deleted
       if(d->is_selected) { // fix selection (if needed)
-        for(int i=0;i<selection.max_id();i++) {
-          int n = (long)selection.get(i);
-          if(n==id) selection.remove(i);
-        }
+        for(int j=0;j<selection.size();j++)
+          if((long)selection.member(j)==id)
+            { selection.remove(selection.slot(j)); break; }
       }
       delete d;
       devices.remove(id);
     }
   }
-  while(!clone_q.empty()) {
-    CloneReq* cr = clone_q.front(); clone_q.pop(); // get next to clone
-    Device* d = (Device*)devices.get(cr->id);
-    if(d && d==cr->parent) { // check device: might have been deleted
+  death_q.clear();
+  // clones start out of phase, so they need the scheduler
+  if(is_sync_rounds && !clone_q.empty()) leave_sync_rounds();
+  devices.reserve(clone_q.size());
+  for(int k=0;k<clone_q.size();k++) {
+    CloneReq* cr = &clone_q[k];
+    Device* d = devices.get(cr->parent);
+    if(d) { // check device: might have been deleted
       Device* new_d = d->clone_device(cr->child_pos);
       new_d->backptr = devices.add(new_d);
       if(new_d->is_selected) { selection.add((void*)new_d->backptr); }
@@ -806,8 +929,8 @@ bool SpatialComputer::evolve(SECONDS limit) {
       scheduler->schedule_event((void*)new_d->backptr,tt,it,COMPUTE,
                                 new_d->uid);
     }
-    delete cr;
   }
+  clone_q.clear();
   
   // dump if needed
   if(is_dump && sim_time >= dump_start && sim_time >= next_dump) {
@@ -823,9 +946,9 @@ bool SpatialComputer::evolve(SECONDS limit) {
  *****************************************************************************/
 
 void SpatialComputer::dump_selection(FILE* out, int verbosity) {
-  for(int i=0;i<selection.max_id();i++) {
-    int n = (long)selection.get(i);
-    Device* d = (Device*)devices.get(n); if(d) d->dump_state(out,verbosity);
+  for(int k=0;k<selection.size();k++) {
+    int n = (long)selection.member(k);
+    Device* d = devices.get(n); if(d) d->dump_state(out,verbosity);
   }
 }
 
@@ -20,11 +20,12 @@ in the file LICENSE in the MIT Proto distribution's top directory. */
 #include "sim-hardware.h"
 #include "utils.h"
 #include "scheduler.h"
+#include "dissemination.h"
 
 #include "kernelversion.h"
 
 // prototype classes
-class Device; class SpatialComputer;
+class Device; class SpatialComputer; class VMProfiler; class DrawBatch;
 
 /*****************************************************************************
  *  TIME AND SPACE DISTRIBUTIONS                                             *
@@ -47,12 +48,17 @@ class DeviceTimer {
   virtual void next_transmit(SECONDS* d_true, SECONDS* d_internal)=0;
   virtual void next_compute(SECONDS* d_true, SECONDS* d_internal)=0;
   virtual DeviceTimer* clone_device()=0; // split the timer for a clone dev
+  // true if every transmit falls strictly between a compute and the next,
+  // so that a device's round can be carried by a single scheduled event
+  virtual bool fixed_phase() { return false; }
 };
 
 class TimeModel {
  public:
   virtual DeviceTimer* next_timer(SECONDS* start_lag)=0;
   virtual SECONDS cycle_time()=0; // approximate length of cycle
+  // true if all devices share one fixed schedule, starting together
+  virtual bool lockstep() { return false; }
 };
 
 
@@ -84,6 +90,8 @@ class DeviceLayer : public EventConsumer {
   virtual void preupdate() {}  // to called before computation
   virtual void update() {}  // to called after a computation
   virtual void visualize() {} // to be called at visualization
+  // batched visualization: draw in world coordinates, device centered at p
+  virtual void visualize_batch(DrawBatch* batch, const flo* p) {}
   virtual bool handle_key(KeyEvent* event) { return false; }
   virtual void copy_state(DeviceLayer* src)=0; // to be called during cloning
   virtual void dump_state(FILE* out, int verbosity) {}; // print state to file
@@ -122,13 +130,16 @@ class BodyDynamics : public Layer {
 /*****************************************************************************
  *  SPATIAL COMPUTER                                                         *
  *****************************************************************************/
-enum DeviceEvent { COMPUTE, BROADCAST };
+// A ROUND_BROADCAST is a broadcast that also schedules the following compute;
+// a COMPUTE_BROADCAST sends its broadcast right after computing
+enum DeviceEvent { COMPUTE, BROADCAST, ROUND_BROADCAST, COMPUTE_BROADCAST };
 
 class Device : public EventConsumer {
   static int top_uid;               // uids are generated in rising sequence
  public:
   int uid, backptr;                 // internal (& ext.) identifier for device
   SECONDS run_time;                 // how much internal time has elapsed?
+  SECONDS next_compute[2];          // true & internal time of next compute
   DeviceTimer* timer;               // supplies delays for compute, broadcast
   Body* body;                       // the physical part of the device
   int num_layers;                   // integration with dynamics
@@ -140,6 +151,7 @@ class Device : public EventConsumer {
   bool is_debug;                    // is this device currently a debug focus?
   bool is_print_stack;              // are we printing the stack of this device to cout after each instruction?
   bool is_print_env_stack;          // are we printing the env stack
+  ScriptState* script;              // dissemination, NULL unless -disseminate
   
   Device(SpatialComputer* parent, METERS *loc, DeviceTimer *timer);
   ~Device();
@@ -147,8 +159,14 @@ class Device : public EventConsumer {
   void internal_event(SECONDS time, DeviceEvent type); // broadcast or compute
   void text_scale();                // scale to display text about device
   void load_script(uint8_t const * script, int len);
+  void execute_vm();                // run the VM until its script finishes
+  void install_pending_script();    // switch to a newly disseminated script
+  // exports from devices running another script version are ignored
+  bool runs_version(uint8_t v)
+  { return !script || (uint8_t)script->running==v; }
   bool handle_key(KeyEvent* key);
   virtual void visualize();
+  void visualize_batch(DrawBatch* batch);
   virtual void render_selection(); // render for selection
   virtual void dump_state(FILE* out, int verbosity);
   bool debug();
@@ -156,10 +174,10 @@ class Device : public EventConsumer {
 
 // a request for cloning carries info about location and source, too
 struct CloneReq {
-  int id; Device* parent;
+  SlotMap<Device>::Handle parent; // stale if the parent has since died
   METERS child_pos[3];
-  CloneReq(int id, Device* parent, const flo* cp) {
-    this->id=id; this->parent=parent;
+  CloneReq(SlotMap<Device>::Handle parent, const flo* cp) {
+    this->parent=parent;
     for(int i=0;i<3;i++) child_pos[i] = cp[i];
   }
 };
@@ -169,8 +187,12 @@ class SpatialComputer : public EventConsumer {
  public:
   // display variables
   bool is_show_val, is_show_vec, is_show_id, is_show_version;
+  bool is_batch_render; // draw devices as one batch, without text
+  DrawBatch* batch;     // reused from frame to frame when batch rendering
   bool is_debug, is_dump_default, is_dump_hood, is_dump_value, is_dump_network; 
   int print_stack_id, print_env_stack_id; // id of device to print stack of
+  VMProfiler* profiler;     // per-opcode profiling, NULL unless -profile-vm
+  ScriptDisseminator* disseminator; // script transfer, NULL unless -disseminate
   flo display_mag; // magnifier for body display
   Population selection;     // the list of devices currently selected
   // dumping variables
@@ -179,6 +201,9 @@ class SpatialComputer : public EventConsumer {
   const char* dump_dir;  // directory where dumps will go
   const char* dump_stem; // start of the dump file name
   FILE* dump_file;
+  // end-of-run reports go with the rest of the output in test mode
+  FILE* report_file()
+  { return (!is_own_dump_file && dump_file) ? dump_file : stdout; }
   // Are we using the kludge to remove double-delays?
   bool is_double_delay_kludge;
   
@@ -188,15 +213,19 @@ class SpatialComputer : public EventConsumer {
   Distribution *distribution; // how devices are scattered in space
   Rect* vis_volume;         // preferred visualized spatial volume
   Rect* volume;             // space (start bounds: fixed, but may be exceeded)
-  Population devices;       // computation (set of devices)
+  SlotMap<Device> devices;  // computation (set of devices)
   BodyDynamics *physics;    // dynamics of bodies, always first evaluated
   Population dynamics;      // additional types of physics
   Scheduler* scheduler;     // "priority queue" for device events
+  // lockstep devices run whole rounds without the scheduler
+  bool is_sync_rounds, sync_broadcast_pending;
+  bool is_coalesce_rounds; // fixed-phase devices queue one event per round
+  SECONDS sync_compute[2], sync_broadcast[2]; // true & internal phase times
   SimulatedHardware hardware; // patch connecting VMs and dynamics
   int version;              // what software version is currently running
 
-  std::queue<int> death_q;  // nodes requesting to suicide
-  std::queue<CloneReq*> clone_q;  // nodes requesting to reproduce
+  std::vector<int> death_q;  // nodes requesting to suicide
+  std::vector<CloneReq> clone_q;  // nodes requesting to reproduce
 
  public:
   SpatialComputer(Args* args, bool own_dump);
@@ -230,6 +259,10 @@ class SpatialComputer : public EventConsumer {
   void get_volume(Args* args, int n); // shared dist constructor
   int addLayer(Layer* layer); // add a layer to dynamics & set callback vars
   int addLayer(const char* layer,Args* args,int n);// add layer from plugin
+  void next_round_times(Device* d, SECONDS* t); // next compute & transmit
+  void schedule_round(int id, Device* d, SECONDS* t);
+  void run_sync_rounds(SECONDS limit);
+  void leave_sync_rounds();
 };
 
 // global variable set to the spatial computer during visualize(),
@@ -61,8 +61,8 @@ void UnitDiscRadio::create_cell_representation() {
     ((Rect3*)p->volume)->f-range;
   lvl_size = cell_rows*cell_cols; num_cells = lvl_size*cell_lvls;
   // make and populate the cell table
-  cells = (Population**)calloc(num_cells,sizeof(Population*));
-  for(int i=0;i<num_cells;i++) cells[i] = new Population();
+  cells = (SlotMap<Device>**)calloc(num_cells,sizeof(SlotMap<Device>*));
+  for(int i=0;i<num_cells;i++) cells[i] = new SlotMap<Device>();
 }
 
 void UnitDiscRadio::change_radio_range(float newrange) {
@@ -73,8 +73,8 @@ void UnitDiscRadio::change_radio_range(float newrange) {
   // Replace with new representation
   create_cell_representation();
   // Fill new cells with all devices
-  for(int i=0;i<parent->devices.size();i++) {
-    Device* d = (Device*)parent->devices.get(i); if(d==NULL) continue;
+  for(int i=0;i<parent->devices.max_id();i++) {
+    Device* d = parent->devices.get(i); if(!d) continue;
     UnitDiscDevice* udd = (UnitDiscDevice*)d->layers[id];
     int c = udd->cell_id = device_cell(d);
     udd->cell_loc = cells[c]->add(d);
@@ -146,39 +146,29 @@ flo range3sqr(const flo* a, const flo* b) {
   return dx*dx + dy*dy + dz*dz;
 }
 
-struct NbrRecord {
-  UnitDiscDevice* nbr;
-  int backptr; // location of corresponding record in neighbor
-  METERS dp[3]; // difference in position
-  NbrRecord(UnitDiscDevice* nbr, const METERS* p, const METERS* np) {
-    this->nbr = nbr; backptr = -1;
-    for(int i=0;i<3;i++) dp[i]=np[i]-p[i];
-  }
-};
-
 // handle the actual connections of a device into a cell
 void UnitDiscRadio::connect_to_cell(Device* d,int cell_id) {
   if(cell_id<0 || cell_id>=num_cells) return; // bounds check
-  Population* c = cells[cell_id];
+  SlotMap<Device>* c = cells[cell_id];
   UnitDiscDevice* udd = (UnitDiscDevice*)d->layers[id];
   const flo* p = d->body->position();
   bool debug = is_debug_radio && d->debug();
+  // by slot: the order neighbors are found in sets their slots, and so
+  // the order in which sends draw their receive errors
   for(int i=0;i<c->max_id();i++) {
-    Device* nbrd = (Device*)c->get(i);
-    if(nbrd) {
-      const flo* nbrp = nbrd->body->position();
-      if(debug) post("Nbr? %d (dist=%f)\n",nbrd->uid,sqrt(range3sqr(p,nbrp)));
-      if(range3sqr(p,nbrp)<r_sqr) { // connect if close enough
-        UnitDiscDevice* nbr = (UnitDiscDevice*)nbrd->layers[id];
-        const flo* np = nbrd->body->position();
-        NbrRecord* nnr = new NbrRecord(udd,np,p);
-        NbrRecord* nr = new NbrRecord(nbr,p,np);
-        nr->backptr = nbr->neighbors.add(nnr);
-        nnr->backptr = udd->neighbors.add(nr);
-        if(debug) post("Accepted nbr %d\n",nbrd->uid);
-      } else {
-        if(debug) post("Rejected possible nbr %d\n",nbrd->uid);
-      }
+    Device* nbrd = c->get(i); if(!nbrd) continue;
+    const flo* nbrp = nbrd->body->position();
+    if(debug) post("Nbr? %d (dist=%f)\n",nbrd->uid,sqrt(range3sqr(p,nbrp)));
+    if(range3sqr(p,nbrp)<r_sqr) { // connect if close enough
+      UnitDiscDevice* nbr = (UnitDiscDevice*)nbrd->layers[id];
+      const flo* np = nbrd->body->position();
+      NbrRecord* nnr = new NbrRecord(udd,np,p);
+      NbrRecord* nr = new NbrRecord(nbr,p,np);
+      nr->backptr = nbr->neighbors.add(nnr);
+      nnr->backptr = udd->neighbors.add(nr);
+      if(debug) post("Accepted nbr %d\n",nbrd->uid);
+    } else {
+      if(debug) post("Rejected possible nbr %d\n",nbrd->uid);
     }
   }
 }
@@ -199,10 +189,8 @@ void UnitDiscRadio::connect_device2(Device* d, int base) {
   if(debug) {
     post("Final nbr collection:");
     UnitDiscDevice* udd = (UnitDiscDevice*)d->layers[id];
-    for(int i=0;i<udd->neighbors.max_id();i++) {
-      NbrRecord* nr = (NbrRecord*)udd->neighbors.get(i);
-      if(nr) { post(" %d",nr->nbr->container->uid); }
-    }
+    for(int k=0;k<udd->neighbors.size();k++)
+      post(" %d",udd->neighbors.member(k)->nbr->container->uid);
     post("\n");
   }
 }
@@ -222,18 +210,17 @@ void UnitDiscRadio::connect_device(Device* d) {
 void UnitDiscRadio::disconnect_device(Device *d) {
   UnitDiscDevice* udd = (UnitDiscDevice*)d->layers[id];
   // disconnect from each neighbor
-  for(int i=0;i<udd->neighbors.max_id();i++) {
-    NbrRecord* nr = (NbrRecord*)udd->neighbors.get(i);
-    if(nr) { 
-      NbrRecord* nnr = (NbrRecord*)nr->nbr->neighbors.remove(nr->backptr);
-      if(nnr->backptr!=i) debug("Bad nbr backptr: %d!=%d\n",i,nnr->backptr);
-      if(nnr->nbr != udd) debug("Bad local backptr\n");
-      delete nnr; delete nr;
-    }
+  for(int k=0;k<udd->neighbors.size();k++) {
+    NbrRecord* nr = udd->neighbors.member(k);
+    int i = udd->neighbors.slot(k);
+    NbrRecord* nnr = nr->nbr->neighbors.remove(nr->backptr);
+    if(nnr->backptr!=i) debug("Bad nbr backptr: %d!=%d\n",i,nnr->backptr);
+    if(nnr->nbr != udd) debug("Bad local backptr\n");
+    delete nnr; delete nr;
   }
   // purge local lists & remove from cell
   udd->neighbors.clear();
-  Device* removed = (Device*)cells[udd->cell_id]->remove(udd->cell_loc);
+  Device* removed = cells[udd->cell_id]->remove(udd->cell_loc);
   if(removed!=d) { debug("Bad back cell reference!\n"); }
 }
 
@@ -272,13 +259,10 @@ void UnitDiscRadio::device_moved(Device* d) {
     }
     d->vm->thisMachine().in_range = true;
     UnitDiscDevice* udd = (UnitDiscDevice*)d->layers[id];
-    for(int i=0;i<udd->neighbors.max_id();i++) {
-      NbrRecord* nr = (NbrRecord*)udd->neighbors.get(i);
-      if(nr) {
-        MachineId nid = nr->nbr->container->uid;
-        NeighbourHood::iterator nbr = d->vm->hood.find(nid);
-        if (nbr != d->vm->hood.end()) nbr->in_range = true;
-      }
+    for(int k=0;k<udd->neighbors.size();k++) {
+      MachineId nid = udd->neighbors.member(k)->nbr->container->uid;
+      NeighbourHood::iterator nbr = d->vm->hood.find(nid);
+      if (nbr != d->vm->hood.end()) nbr->in_range = true;
     }
     for(NeighbourHood::iterator i = d->vm->hood.begin(); i != d->vm->hood.end(); ){
       if (i->in_range) {
@@ -304,8 +288,9 @@ int UnitDiscRadio::radio_send_export (uint8_t version, Array<Data> const & data)
   // walk neighbors
   UnitDiscDevice* udd = (UnitDiscDevice*)device->layers[id];
   for(int i=0;i<udd->neighbors.max_id();i++) {
-    NbrRecord* nr = (NbrRecord*)udd->neighbors.get(i);
-    if(nr && try_rx()) { // non-failing receive
+    NbrRecord* nr = udd->neighbors.get(i); if(!nr) continue;
+    // non-failing receive, by a device running the same script
+    if(try_rx() && nr->nbr->container->runs_version(version)) {
       // hardware->set_vm_context(nr->nbr->container);
       /*radio_receive_export(src_id, version, timeout, -nr->dp[0], -nr->dp[1],
                            -nr->dp[2], n, buf);*/
@@ -314,7 +299,7 @@ int UnitDiscRadio::radio_send_export (uint8_t version, Array<Data> const & data)
       nbr.x = -nr->dp[0];
       nbr.y = -nr->dp[1];
       nbr.z = -nr->dp[2];
-      nbr.data_age = 0;
+      nbr.data_round = nr->nbr->container->vm->rounds;
     }
   }
   // hardware->set_vm_context(udd->container); // restore context
@@ -323,37 +308,34 @@ int UnitDiscRadio::radio_send_export (uint8_t version, Array<Data> const & data)
 
 int UnitDiscRadio::radio_send_script_pkt (uint8_t version, uint16_t n, 
                                           uint8_t pkt_num, uint8_t *script) {
-/*  if(!try_tx())  // transmission failure
+  if(!try_tx())  // transmission failure
     return 0;
 
   // walk neighbors
   UnitDiscDevice* udd = (UnitDiscDevice*)device->layers[id];
   for(int i=0;i<udd->neighbors.max_id();i++) {
-    NbrRecord* nr = (NbrRecord*)udd->neighbors.get(i);
-    if(nr && try_rx()) { // non-failing receive
-      hardware->set_vm_context(nr->nbr->container);
-      //radio_receive_script_pkt(version, n, pkt_num, script);
-    }
+    NbrRecord* nr = udd->neighbors.get(i); if(!nr) continue;
+    Device* d = nr->nbr->container;
+    if(try_rx() && d->script) // non-failing receive
+      d->script->receive_pkt(version, n, pkt_num, script);
   }
-  hardware->set_vm_context(udd->container); // restore context
-  //script_pkt_callback(pkt_num); */
+  return 1;
 }
 
 int UnitDiscRadio::radio_send_digest (uint8_t version, uint16_t script_len, 
                                       uint8_t *digest) {
-/*  if(!try_tx())
+  if(!try_tx())
     return 0;
 
   // walk neighbors
   UnitDiscDevice* udd = (UnitDiscDevice*)device->layers[id];
   for(int i=0;i<udd->neighbors.max_id();i++) {
-    NbrRecord* nr = (NbrRecord*)udd->neighbors.get(i);
-    if(nr && try_rx()) { // non-failing receive
-      hardware->set_vm_context(nr->nbr->container);
-      //radio_receive_digest(version, script_len, digest);
-    }
+    NbrRecord* nr = udd->neighbors.get(i); if(!nr) continue;
+    Device* d = nr->nbr->container;
+    if(try_rx() && d->script) // non-failing receive
+      d->script->receive_digest(version, script_len, digest);
   }
-  hardware->set_vm_context(udd->container); // restore context*/
+  return 1;
 }
 
 /*****************************************************************************
@@ -365,13 +347,10 @@ UnitDiscDevice::UnitDiscDevice(UnitDiscRadio* parent, Device* container)
 
 UnitDiscDevice::~UnitDiscDevice() {
   if(parent->is_fast_prune_hood) { // delete self from each neighbor
-    for(int i=0;i<neighbors.max_id();i++) {
-      NbrRecord* nr = (NbrRecord*)neighbors.get(i);
-      if(nr) {
-	Machine* nvm = nr->nbr->container->vm;
-	NeighbourHood::iterator i = nvm->hood.find(container->uid);
-	if (i != nvm->hood.end()) nvm->hood.remove(i);
-	  }
+    for(int k=0;k<neighbors.size();k++) {
+      Machine* nvm = neighbors.member(k)->nbr->container->vm;
+      NeighbourHood::iterator i = nvm->hood.find(container->uid);
+      if (i != nvm->hood.end()) nvm->hood.remove(i);
     }
   }
   parent->disconnect_device(container);
@@ -420,9 +399,9 @@ void UnitDiscDevice::visualize() {
     }
     // do the actual draw
     glBegin(GL_LINES);
-    for(int i=0;i<neighbors.max_id();i++) {
-      NbrRecord* nr = (NbrRecord*)neighbors.get(i);
-      if(nr && (local_sharp || nr->nbr->container->uid > container->uid)) {
+    for(int k=0;k<neighbors.size();k++) {
+      NbrRecord* nr = neighbors.member(k);
+      if(local_sharp || nr->nbr->container->uid > container->uid) {
         glVertex3f(0,0,0);
         glVertex3f(nr->dp[0],nr->dp[1],nr->dp[2]);
       }
@@ -437,6 +416,7 @@ void UnitDiscDevice::visualize() {
     glBegin(GL_LINES);
     Machine * m = container->vm;
     for(NeighbourHood::iterator i = m->hood.begin(); i != m->hood.end(); i++){
+    	if (m->expired(*i)) continue;
     	glVertex3f(0,0,0);
     	glVertex3f(i->x, i->y, i->z);
     }
@@ -445,3 +425,38 @@ void UnitDiscDevice::visualize() {
   }
 #endif // WANT_GLUT
 }
+
+// batched lines all have the same width, so fuzzy and sharp differ by color
+void UnitDiscDevice::visualize_batch(DrawBatch* batch, const flo* p) {
+#ifdef WANT_GLUT
+  flo rgba[4];
+  if(parent->is_show_radio) {
+    palette->get_rgba(UnitDiscRadio::RADIO_RANGE_RING,rgba);
+    batch->circle(p,parent->range,rgba);
+  }
+  if(parent->is_show_connectivity) {
+    bool local_sharp=(parent->connect_display_mode==1 && 
+                      container->is_selected);
+    if(parent->connect_display_mode==2 || local_sharp)
+      palette->get_rgba(UnitDiscRadio::NET_CONNECTION_SHARP,rgba);
+    else
+      palette->get_rgba(UnitDiscRadio::NET_CONNECTION_FUZZY,rgba);
+    for(int k=0;k<neighbors.size();k++) {
+      NbrRecord* nr = neighbors.member(k);
+      if(local_sharp || nr->nbr->container->uid > container->uid) {
+        flo q[3] = {p[0]+nr->dp[0], p[1]+nr->dp[1], p[2]+nr->dp[2]};
+        batch->line(p,q,rgba);
+      }
+    }
+  }
+  if(parent->is_show_logical_nbrs) {
+    palette->get_rgba(UnitDiscRadio::NET_CONNECTION_LOGICAL,rgba);
+    Machine * m = container->vm;
+    for(NeighbourHood::iterator i = m->hood.begin(); i != m->hood.end(); i++){
+      if (m->expired(*i)) continue;
+      flo q[3] = {p[0]+i->x, p[1]+i->y, p[2]+i->z};
+      batch->line(p,q,rgba);
+    }
+  }
+#endif // WANT_GLUT
+}
@@ -45,7 +45,7 @@ class UnitDiscRadio : public RadioSim {
   // storage: gridded in range-size squares to cover screen
   // an additional layer of cells coats the edges, covering all outside area
   // it performs badly when devices are not well dispersed in the screen area
-  Population** cells; // collections of Device pointers
+  SlotMap<Device>** cells; // collections of Device pointers
   int cell_rows, cell_cols, cell_lvls, num_cells, lvl_size;
   METERS cell_left, cell_bottom, cell_floor;
   int device_cell(Device* d); // which cell is a device in?
@@ -61,17 +61,29 @@ class UnitDiscRadio : public RadioSim {
   static Color *RADIO_RANGE_RING, *RADIO_CELL_INFO;
 };
 
+class UnitDiscDevice;
+struct NbrRecord {
+  UnitDiscDevice* nbr;
+  int backptr; // location of corresponding record in neighbor
+  METERS dp[3]; // difference in position
+  NbrRecord(UnitDiscDevice* nbr, const METERS* p, const METERS* np) {
+    this->nbr = nbr; backptr = -1;
+    for(int i=0;i<3;i++) dp[i]=np[i]-p[i];
+  }
+};
+
 class UnitDiscDevice : public DeviceLayer {
  public:
   UnitDiscRadio* parent;
   // these values are actually managed by the UnitDiscRadio
-  Population neighbors; // collection of NbrRecord* (internal definition)
+  SlotMap<NbrRecord> neighbors;
   int cell_id; // which cell the device was last in (before motion)
   int cell_loc; // where is the device in its cell's list
 
   UnitDiscDevice(UnitDiscRadio* parent, Device* container);
   ~UnitDiscDevice();
   void visualize();
+  void visualize_batch(DrawBatch* batch, const flo* p);
   void copy_state(DeviceLayer* src) {} // to be called during cloning
 };
 
@@ -0,0 +1,149 @@
+/* VM execution tracing and profiling
+Copyright (C) 2005-2010, Jonathan Bachrach, Jacob Beal, and contributors
+listed in the AUTHORS file in the MIT Proto distribution's top directory.
+
+This file is part of MIT Proto, and is distributed under the terms of
+the GNU General Public License, with a linking exception, as described
+in the file LICENSE in the MIT Proto distribution's top directory. */
+
+#include "config.h"
+#include <iostream>
+#include <map>
+#include <string>
+#include <string.h>
+#include <algorithm>
+#include "vmprofiler.h"
+
+using namespace std;
+
+extern map<string,uint8_t> OPCODE_MAP;
+
+const char* opcode_name(uint8_t opcode) {
+  // inverted once, rather than searching the map at every instruction
+  static vector<const char*> names;
+  if(names.empty()) {
+    names.resize(256,(const char*)NULL);
+    map<string,uint8_t>::iterator it;
+    for(it=OPCODE_MAP.begin(); it!=OPCODE_MAP.end(); it++)
+      if(!names[it->second]) names[it->second] = it->first.c_str();
+  }
+  return names[opcode];
+}
+
+void StackTracer::before(Machine* vm) {
+  Int8 opcode = *(vm->currentAddress());
+  cout << "OpCode: " << (int)opcode;
+  const char* name = opcode_name(opcode);
+  if(name) cout << " " << name;
+  if(stack) {
+    cout << " Stack (" << steps << "): ";
+    vm->print_stack(&vm->stack);
+  }
+  if(env) {
+    cout << " Environment Stack (" << steps << "): ";
+    vm->print_stack(&vm->environment);
+  }
+  steps++;
+}
+
+/*****************************************************************************
+ *  PROFILER                                                                 *
+ *****************************************************************************/
+VMProfiler::VMProfiler(int top) {
+  this->top = top;
+  memset(opcodes,0,sizeof(opcodes));
+  memset(round_histogram,0,sizeof(round_histogram));
+}
+
+void VMProfiler::record_round(int uid, uint64_t ticks) {
+  if(uid >= devices.size()) {
+    DeviceStats empty = {0,0,0};
+    devices.resize(uid+1,empty);
+  }
+  DeviceStats* d = &devices[uid];
+  d->rounds++; d->ticks += ticks; d->max_ticks = max(d->max_ticks,ticks);
+  round_histogram[bucket(ticks)]++;
+}
+
+static void print_histogram(FILE* out, const uint64_t* histogram) {
+  for(int k=0;k<PROFILE_BUCKETS;k++)
+    if(histogram[k]) fprintf(out," 2^%d:%llu",k,(unsigned long long)histogram[k]);
+}
+
+// orderings for the report: most expensive first
+struct OpcodeCmp {
+  VMProfiler* p;
+  OpcodeCmp(VMProfiler* p) { this->p=p; }
+  bool operator()(int a, int b) const
+  { return p->opcodes[a].ticks > p->opcodes[b].ticks; }
+};
+struct AddressCmp {
+  VMProfiler* p;
+  AddressCmp(VMProfiler* p) { this->p=p; }
+  bool operator()(size_t a, size_t b) const
+  { return p->addresses[a] > p->addresses[b]; }
+};
+struct DeviceCmp {
+  VMProfiler* p;
+  DeviceCmp(VMProfiler* p) { this->p=p; }
+  bool operator()(int a, int b) const
+  { return p->devices[a].ticks > p->devices[b].ticks; }
+};
+
+void VMProfiler::report(FILE* out) {
+#if defined(__GNUC__) && (defined(__i386__) || defined(__x86_64__))
+  const char* unit = "cycles";
+#else
+  const char* unit = "usecs";
+#endif
+  uint64_t instructions = 0, ticks = 0, rounds = 0;
+  vector<int> ops;
+  for(int i=0;i<256;i++) {
+    if(!opcodes[i].count) continue;
+    ops.push_back(i); instructions += opcodes[i].count; ticks += opcodes[i].ticks;
+  }
+  vector<int> devs;
+  for(int i=0;i<devices.size();i++)
+    if(devices[i].rounds) { devs.push_back(i); rounds += devices[i].rounds; }
+  fprintf(out,"VM profile: %llu instructions, %llu rounds on %d devices"
+          " (costs in %s)\n",(unsigned long long)instructions,
+          (unsigned long long)rounds,(int)devs.size(),unit);
+
+  fprintf(out,"Opcodes by total cost:\n");
+  fprintf(out,"%4s %-24s %12s %14s %8s %6s  histogram\n",
+          "op","name","count","cost","per-op","share");
+  sort(ops.begin(),ops.end(),OpcodeCmp(this));
+  for(int i=0;i<ops.size();i++) {
+    OpcodeStats* s = &opcodes[ops[i]];
+    const char* name = opcode_name(ops[i]);
+    fprintf(out,"%4d %-24s %12llu %14llu %8.1f %5.1f%% ",ops[i],
+            name ? name : "?",(unsigned long long)s->count,
+            (unsigned long long)s->ticks,(double)s->ticks/s->count,
+            ticks ? 100.0*s->ticks/ticks : 0.0);
+    print_histogram(out,s->histogram); fprintf(out,"\n");
+  }
+
+  fprintf(out,"Hottest script addresses:\n");
+  vector<size_t> addrs;
+  for(size_t i=0;i<addresses.size();i++) if(addresses[i]) addrs.push_back(i);
+  int n = min((int)addrs.size(),top);
+  partial_sort(addrs.begin(),addrs.begin()+n,addrs.end(),AddressCmp(this));
+  for(int i=0;i<n;i++) {
+    const char* name = opcode_name(address_ops[addrs[i]]);
+    fprintf(out,"  @%-6lu %-24s %12llu\n",(unsigned long)addrs[i],
+            name ? name : "?",(unsigned long long)addresses[addrs[i]]);
+  }
+
+  fprintf(out,"Round costs:");
+  print_histogram(out,round_histogram); fprintf(out,"\n");
+  fprintf(out,"Most expensive devices:\n");
+  n = min((int)devs.size(),top);
+  partial_sort(devs.begin(),devs.begin()+n,devs.end(),DeviceCmp(this));
+  for(int i=0;i<n;i++) {
+    DeviceStats* d = &devices[devs[i]];
+    fprintf(out,"  device %-6d %8llu rounds, mean %.1f, max %llu\n",devs[i],
+            (unsigned long long)d->rounds,(double)d->ticks/d->rounds,
+            (unsigned long long)d->max_ticks);
+  }
+  fflush(out);
+}
@@ -0,0 +1,108 @@
+/* VM execution tracing and profiling
+Copyright (C) 2005-2010, Jonathan Bachrach, Jacob Beal, and contributors
+listed in the AUTHORS file in the MIT Proto distribution's top directory.
+
+This file is part of MIT Proto, and is distributed under the terms of
+the GNU General Public License, with a linking exception, as described
+in the file LICENSE in the MIT Proto distribution's top directory. */
+
+#ifndef __VMPROFILER__
+#define __VMPROFILER__
+
+#include <stdint.h>
+#include <stdio.h>
+#include <sys/time.h>
+#include <vector>
+#include <machine.hpp>
+
+// Devices drive their VM through run_to_completion, parameterized by a
+// tracing policy.  Each policy gets its own copy of the dispatch loop, so
+// the ordinary (NullTracer) loop carries no tracing checks at all.
+template<class Tracer> inline void run_to_completion(Machine* vm, Tracer& t) {
+  while(!vm->finished()) {
+    t.before(vm);
+    vm->step();
+    t.after(vm);
+  }
+}
+
+struct NullTracer {
+  inline void before(Machine* vm) {}
+  inline void after(Machine* vm) {}
+};
+
+// name of an opcode, or NULL if it isn't in the opcode map
+const char* opcode_name(uint8_t opcode);
+
+// prints each instruction and the stack(s) to cout before executing it
+class StackTracer {
+  bool stack, env; int steps;
+ public:
+  StackTracer(bool stack, bool env) { this->stack=stack; this->env=env; steps=0; }
+  void before(Machine* vm);
+  inline void after(Machine* vm) {}
+};
+
+// a cheap monotonic counter: cycles on x86, microseconds elsewhere
+inline uint64_t profile_ticks() {
+#if defined(__GNUC__) && (defined(__i386__) || defined(__x86_64__))
+  uint32_t lo, hi;
+  __asm__ __volatile__("rdtsc" : "=a"(lo), "=d"(hi));
+  return ((uint64_t)hi<<32) | lo;
+#else
+  struct timeval t; gettimeofday(&t,0);
+  return (uint64_t)t.tv_sec*1000000 + t.tv_usec;
+#endif
+}
+
+#define PROFILE_BUCKETS 40 // histograms are over powers of two of ticks
+
+// Aggregates instruction and round costs over every device in a run
+class VMProfiler {
+ public:
+  struct OpcodeStats {
+    uint64_t count, ticks, histogram[PROFILE_BUCKETS];
+  };
+  struct DeviceStats { uint64_t rounds, ticks, max_ticks; };
+  OpcodeStats opcodes[256];
+  std::vector<uint64_t> addresses;  // executions by script offset
+  std::vector<uint8_t> address_ops; // opcode found at each offset
+  std::vector<DeviceStats> devices; // round costs, by device uid
+  uint64_t round_histogram[PROFILE_BUCKETS];
+  int top; // how many addresses and devices to list in the report
+
+  VMProfiler(int top);
+  // histogram bucket k holds costs in [2^k, 2^(k+1))
+  static inline int bucket(uint64_t ticks) {
+    int k = 0;
+    while(ticks > 1 && k < PROFILE_BUCKETS-1) { ticks >>= 1; k++; }
+    return k;
+  }
+  inline void record_instruction(uint8_t opcode, size_t offset,
+                                 uint64_t ticks) {
+    OpcodeStats* s = &opcodes[opcode];
+    s->count++; s->ticks += ticks; s->histogram[bucket(ticks)]++;
+    if(offset >= addresses.size())
+      { addresses.resize(offset+1,0); address_ops.resize(offset+1,0); }
+    addresses[offset]++; address_ops[offset] = opcode;
+  }
+  void record_round(int uid, uint64_t ticks);
+  void report(FILE* out);
+};
+
+// charges each executed instruction of a device to the profiler
+class ProfileTracer {
+  VMProfiler* profiler; uint8_t opcode; size_t offset; uint64_t start;
+ public:
+  ProfileTracer(VMProfiler* p) { profiler=p; }
+  inline void before(Machine* vm) {
+    Int8 const * ip = vm->currentAddress();
+    opcode = *ip; offset = ip - (Int8 const *)vm->currentScript();
+    start = profile_ticks();
+  }
+  inline void after(Machine* vm) {
+    profiler->record_instruction(opcode,offset,profile_ticks()-start);
+  }
+};
+
+#endif // __VMPROFILER__
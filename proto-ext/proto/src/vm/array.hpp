@@ -73,6 +73,7 @@ template<typename Element> class Array {
 			array = a.size() ? Memory<Element>::allocate(a.size()) : 0;
 			array_size = a.size();
 			for(Size i = 0; i < array_size; i++) new (&array[i]) Element(a[i]);
+			return *this;
 		}
 		
 		/// Clear the array.
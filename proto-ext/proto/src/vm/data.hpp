@@ -177,14 +177,14 @@ protected:
 
 public:
   inline explicit DataStack(Size capacity = 0) {
-    this->capacity = 0; reset(capacity);
+    this->capacity = 0; contents = 0; reset(capacity);
   }
   inline ~DataStack() { delete[] contents; }
 
   inline void reset(Size new_capacity = 0) {
     if(capacity) delete[] contents;
     capacity = new_capacity; subcapacity = capacity-1;
-    if(new_capacity) { contents = new Data[capacity]; }
+    contents = new_capacity ? new Data[capacity] : 0;
     top = -1; // nothing in stack
   }
 
@@ -265,4 +265,73 @@ public:
   inline FieldData popField() { return pop().asField();   }
 };
 
+/// A DataStack whose contents are shared by its copies.
+/**
+ * Copies read the same contents until one of them is pushed onto or reset,
+ * and only then does that copy get contents of its own.
+ * Elements can only be read in place.
+ */
+class SharedDataStack {
+protected:
+  struct Contents {
+    Counter references;
+    DataStack stack;
+    inline explicit Contents(Size capacity) : references(1), stack(capacity) {}
+  } * contents;
+
+  inline void release() {
+    if(!--contents->references) delete contents;
+  }
+
+  // copy on first write
+  inline void unshare() {
+    if(contents->references == 1) return;
+    Contents* own = new Contents(size() + free());
+    for(Index i = 0; i < size(); i++) own->stack.push(contents->stack[i]);
+    release(); contents = own;
+  }
+
+public:
+  inline explicit SharedDataStack(Size capacity = 0)
+    : contents(new Contents(capacity)) {}
+  inline SharedDataStack(SharedDataStack const & s) : contents(s.contents) {
+    contents->references++;
+  }
+  inline SharedDataStack & operator = (SharedDataStack const & s) {
+    s.contents->references++; release(); contents = s.contents;
+    return *this;
+  }
+  inline ~SharedDataStack() { release(); }
+
+  inline void reset(Size new_capacity = 0) {
+    if(contents->references == 1) { contents->stack.reset(new_capacity); return; }
+    release(); contents = new Contents(new_capacity);
+  }
+
+  /// The number of elements currently stored.
+  inline Size size() const { return contents->stack.size(); }
+  /// Check whether there are currently elements stored (false) or not (true).
+  inline bool empty() const { return contents->stack.empty(); }
+  /// The number of elements that can be pushed before the stack is full.
+  inline Size free() const { return contents->stack.free(); }
+  /// Check whether the stack is full.
+  inline bool full() const { return contents->stack.full(); }
+  /// The number of stacks sharing these contents, including this one.
+  inline Counter instances() const { return contents->references; }
+
+  /// Push a new element on the stack.
+  inline void push(Data const & element) {
+    unshare(); contents->stack.push(element);
+  }
+
+  /// Get an element by its offset from the top of the stack.
+  inline Data const & peek(Size offset = 0) const {
+    return contents->stack.peek(offset);
+  }
+  /// Get an element by its offset from the base of the stack.
+  inline Data const & operator [] (Index index) const {
+    return contents->stack[index];
+  }
+};
+
 #endif
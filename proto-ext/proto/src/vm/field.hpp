@@ -54,6 +54,8 @@ public:
   // 1 and 2 input pointwise applications of instructions:
   static void pointwise_instruction(Machine &machine,Instruction instruction,Data & a);
   static void pointwise_instruction(Machine &machine,Instruction instruction,Data & a, Data & b);
+  // typed fast path for fields of numbers; false if it doesn't apply
+  static bool numeric_pointwise(Machine &machine,Instruction instruction,Data & a, Data * b);
   inline const_iterator begin() const { return const_iterator(this); }
 
 public:
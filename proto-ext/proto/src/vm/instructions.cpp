@@ -29,6 +29,7 @@
 #include <instructions/feedback.cpp>
 #include <instructions/hood.cpp>
 #include <instructions/platform.cpp>
+#include <instructions/superinstructions.cpp>
 
 /** \cond */
 Instruction instructions[256] = {
@@ -35,7 +35,7 @@ struct HoodInstructions {
 	
 	static void fold_hood_step(Machine & machine) {
 		machine.environment.pop(2);
-		while(++machine.current_neighbour != machine.hood.end() && !machine.current_neighbour->imports[machine.current_import].isSet());
+		while(++machine.current_neighbour != machine.hood.end() && (!machine.current_neighbour->imports[machine.current_import].isSet() || machine.expired(*machine.current_neighbour)));
 		if (machine.current_neighbour != machine.hood.end()){
 			machine.environment.push(machine.stack.pop());
 			machine.environment.push(machine.current_neighbour->imports[machine.current_import]);
@@ -64,7 +64,7 @@ struct HoodInstructions {
 	}
 	
 	static void fold_hood_filter_next(Machine & machine){
-		while(++machine.current_neighbour != machine.hood.end() && !machine.current_neighbour->imports[machine.current_import].isSet());
+		while(++machine.current_neighbour != machine.hood.end() && (!machine.current_neighbour->imports[machine.current_import].isSet() || machine.expired(*machine.current_neighbour)));
 		if (machine.current_neighbour != machine.hood.end()){
 			machine.environment.push(machine.current_neighbour->imports[machine.current_import]);
 			Address filter = machine.stack.peek(1).asAddress();
@@ -119,7 +119,7 @@ namespace Instructions {
     NeighbourHood::iterator nbr = machine.hood.begin();
     FieldData result = FieldData();
     while(nbr != machine.hood.end()) {
-      result.push(nbr->id,nbr->id);
+      if (!machine.expired(*nbr)) result.push(nbr->id,nbr->id);
       nbr++;
     }
     machine.stack.push(result);
@@ -224,8 +224,118 @@ namespace Instructions {
 
 Data const &   FieldData::const_iterator::value() { return source->values[index]; }
 
+// Pointwise kernels for fields of numbers: operands are gathered a block
+// at a time into plain Number arrays, and each operation is a simple
+// loop (which the compiler can vectorize) instead of a trip through the
+// instruction and the stack per element.  Anything else, e.g. fields of
+// tuples, takes the generic path below.
+namespace {
+	
+	enum PointwiseKernel {
+		KERNEL_NONE, KERNEL_ADD, KERNEL_SUB, KERNEL_MUL, KERNEL_DIV,
+		KERNEL_MIN, KERNEL_MAX, KERNEL_EQ, KERNEL_NEQ, KERNEL_LT, KERNEL_LTE,
+		KERNEL_GT, KERNEL_GTE, KERNEL_NOT, KERNEL_ABS
+	};
+	
+	const Size KERNEL_BLOCK = 64;
+	
+	PointwiseKernel kernel_for(Instruction instruction) {
+		if (instruction == Instructions::ADD) return KERNEL_ADD;
+		if (instruction == Instructions::SUB) return KERNEL_SUB;
+		if (instruction == Instructions::MUL) return KERNEL_MUL;
+		if (instruction == Instructions::DIV) return KERNEL_DIV;
+		if (instruction == Instructions::MIN) return KERNEL_MIN;
+		if (instruction == Instructions::MAX) return KERNEL_MAX;
+		if (instruction == Instructions::EQ ) return KERNEL_EQ;
+#if MIT_COMPATIBILITY != MIT_ONLY
+		if (instruction == Instructions::NEQ) return KERNEL_NEQ;
+#endif
+		if (instruction == Instructions::LT ) return KERNEL_LT;
+		if (instruction == Instructions::LTE) return KERNEL_LTE;
+		if (instruction == Instructions::GT ) return KERNEL_GT;
+		if (instruction == Instructions::GTE) return KERNEL_GTE;
+		if (instruction == Instructions::NOT) return KERNEL_NOT;
+		if (instruction == Instructions::ABS) return KERNEL_ABS;
+		return KERNEL_NONE;
+	}
+	
+	// Each case matches its instruction's result on Numbers, including NaN
+	void run_kernel(PointwiseKernel kernel, Number const * a, Number const * b, Number * r, Size n) {
+		switch (kernel) {
+			case KERNEL_ADD: for(Index i = 0; i < n; i++) r[i] = a[i] + b[i]; break;
+			case KERNEL_SUB: for(Index i = 0; i < n; i++) r[i] = a[i] - b[i]; break;
+			case KERNEL_MUL: for(Index i = 0; i < n; i++) r[i] = a[i] * b[i]; break;
+			case KERNEL_DIV: for(Index i = 0; i < n; i++) r[i] = a[i] / b[i]; break;
+			case KERNEL_MIN: for(Index i = 0; i < n; i++) r[i] = a[i] < b[i] ? a[i] : b[i]; break;
+			case KERNEL_MAX: for(Index i = 0; i < n; i++) r[i] = a[i] > b[i] ? a[i] : b[i]; break;
+			case KERNEL_EQ : for(Index i = 0; i < n; i++) r[i] = a[i] == b[i] ? 1 : 0; break;
+			case KERNEL_NEQ: for(Index i = 0; i < n; i++) r[i] = a[i] == b[i] ? 0 : 1; break;
+			case KERNEL_LT : for(Index i = 0; i < n; i++) r[i] = a[i] <  b[i] ? 1 : 0; break;
+			case KERNEL_LTE: for(Index i = 0; i < n; i++) r[i] = a[i] <= b[i] ? 1 : 0; break;
+			case KERNEL_GT : for(Index i = 0; i < n; i++) r[i] = a[i] >  b[i] ? 1 : 0; break;
+			case KERNEL_GTE: for(Index i = 0; i < n; i++) r[i] = a[i] >= b[i] ? 1 : 0; break;
+			case KERNEL_NOT: for(Index i = 0; i < n; i++) r[i] = a[i] == 0 ? 1 : 0; break;
+			case KERNEL_ABS: for(Index i = 0; i < n; i++) r[i] = a[i] < 0 ? -a[i] : a[i]; break;
+			case KERNEL_NONE: break;
+		}
+	}
+	
+	bool is_numeric(Data const & d) {
+		if (d.type() == Data::Type_number) return true;
+		if (d.type() != Data::Type_field) return false;
+		for(FieldData::const_iterator i = d.asField().begin(); i.hasNext(); i++)
+			if (i.value().type() != Data::Type_number) return false;
+		return true;
+	}
+	
+	// The kernels pair elements up by position, so two fields only qualify
+	// if they hold the same neighbours in the same order
+	bool same_ids(FieldData const & a, FieldData const & b) {
+		if (a.size() != b.size()) return false;
+		for(FieldData::const_iterator ia = a.begin(), ib = b.begin(); ia.hasNext(); ia++, ib++)
+			if (ia.id() != ib.id()) return false;
+		return true;
+	}
+	
+	// Fill a block with a field's next numbers, or with a constant
+	void gather(Data const & d, FieldData::const_iterator & fi, Size n, Number * out) {
+		if (d.type() == Data::Type_number) {
+			for(Index i = 0; i < n; i++) out[i] = d.asNumber();
+		} else {
+			for(Index i = 0; i < n; i++, fi++) out[i] = fi.value().asNumber();
+		}
+	}
+	
+}
+
+// Apply a kernel if there is one for the instruction, all operands are
+// numeric and two fields line up, pushing the resulting field; b is NULL
+// for one input.
+bool FieldData::numeric_pointwise(Machine &machine,Instruction instruction,Data & a, Data * b) {
+  PointwiseKernel kernel = kernel_for(instruction);
+  if (kernel == KERNEL_NONE || !is_numeric(a) || (b && !is_numeric(*b))) return false;
+  FieldData const & ids = a.type() == Data::Type_field ? a.asField() : b->asField();
+  Size n = ids.size();
+  if (b && a.type() == Data::Type_field && b->type() == Data::Type_field && !same_ids(a.asField(), b->asField())) return false;
+  Number va[KERNEL_BLOCK], vb[KERNEL_BLOCK], vr[KERNEL_BLOCK];
+  FieldData result = FieldData(n);
+  FieldData::const_iterator fi = ids.begin(), ia = fi, ib = fi;
+  if (a.type() == Data::Type_field) ia = a.asField().begin();
+  if (b && b->type() == Data::Type_field) ib = b->asField().begin();
+  for(Index start = 0; start < n; start += KERNEL_BLOCK) {
+    Size block = n - start < KERNEL_BLOCK ? n - start : KERNEL_BLOCK;
+    gather(a, ia, block, va);
+    if (b) gather(*b, ib, block, vb);
+    run_kernel(kernel, va, vb, vr, block);
+    for(Index i = 0; i < block; i++, fi++) result.push(fi.id(), Data(vr[i]));
+  }
+  machine.stack.push(result);
+  return true;
+}
+
 // Two input pointwise:
 void FieldData::pointwise_instruction(Machine &machine,Instruction instruction,Data & a) {
+  if (numeric_pointwise(machine,instruction,a,0)) return;
   FieldData::const_iterator ia = a.asField().begin();
   FieldData result = FieldData(a.asField().size());
   while(ia.hasNext()) {
@@ -243,6 +353,7 @@ void FieldData::pointwise_instruction(Machine &machine,Instruction instruction,D
   bool a_field = a.type() == Data::Type_field;
   bool b_field = b.type() == Data::Type_field;
   assert(a_field || b_field);
+  if (numeric_pointwise(machine,instruction,a,&b)) return;
   
   if(a_field && b_field) { // Both arguments are fields:
     FieldData::const_iterator ia = a.asField().begin();
@@ -0,0 +1,84 @@
+/*   ____       _  __ _   ____            _
+ *  |  _ \  ___| |/ _| |_|  _ \ _ __ ___ | |_ ___
+ *  | | | |/ _ \ | |_| __| |_) | '__/ _ \| __/ _ \
+ *  | |_| |  __/ |  _| |_|  __/| | ( (_) | |( (_) )
+ *  |____/ \___|_|_|  \__|_|   |_|  \___/ \__\___/
+ *
+ * This file is part of DelftProto.
+ * See COPYING for license details.
+ */
+
+/// \file
+/// Provides the superinstructions.
+/**
+ * Each superinstruction behaves exactly as the sequence of instructions it is
+ * named after, but costs a single dispatch and a single byte of script.
+ * They are produced by the compiler's peephole pass (\c --superinstructions),
+ * which only fuses instructions that take no parameters.
+ */
+
+#include <machine.hpp>
+#include <instructions.hpp>
+
+namespace Instructions {
+	
+	/// \name Superinstructions
+	/// \{
+	
+	/// LET_1 followed by REF_0: bind the top of the stack, keeping it on the stack.
+	void LET_1_REF_0(Machine & machine){
+		LET_N<1>(machine);
+		REF_N<0>(machine);
+	}
+	
+	/// REF_0 followed by POP_LET_1: move the top of the environment stack to the execution stack.
+	void REF_0_POP_LET_1(Machine & machine){
+		REF_N<0>(machine);
+		POP_LET_N<1>(machine);
+	}
+	
+	/// REF_0 followed by REF_0.
+	void REF_0_REF_0(Machine & machine){
+		REF_N<0>(machine);
+		REF_N<0>(machine);
+	}
+	
+	/// REF_0 followed by REF_1.
+	void REF_0_REF_1(Machine & machine){
+		REF_N<0>(machine);
+		REF_N<1>(machine);
+	}
+	
+	/// REF_0 followed by ADD.
+	void REF_0_ADD(Machine & machine){
+		REF_N<0>(machine);
+		ADD(machine);
+	}
+	
+	/// POP_LET_1 followed by ADD.
+	void POP_LET_1_ADD(Machine & machine){
+		POP_LET_N<1>(machine);
+		ADD(machine);
+	}
+	
+	/// REF_1 followed by MAX.
+	void REF_1_MAX(Machine & machine){
+		REF_N<1>(machine);
+		MAX(machine);
+	}
+	
+	/// REF_1 followed by MIN.
+	void REF_1_MIN(Machine & machine){
+		REF_N<1>(machine);
+		MIN(machine);
+	}
+	
+	/// LIT_1 followed by ADD: increment.
+	void LIT_1_ADD(Machine & machine){
+		LIT_N<1>(machine);
+		ADD(machine);
+	}
+	
+	/// \}
+	
+}
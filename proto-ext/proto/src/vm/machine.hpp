@@ -45,7 +45,7 @@ class BasicMachine {
 		
 		/// The globals.
 		/** \memberof Machine */
-                DataStack globals;
+                SharedDataStack globals;
 		
 		/// The threads.
 		/**
@@ -257,6 +257,16 @@ class BasicMachine {
 				return *hood.begin();
 			}
 			
+			/// Check whether the data of a neighbour has expired.
+			/**
+			 * Expired neighbours are skipped by the hood instructions, even while they are still in the hood.
+			 * Always false here; extensions that age neighbour data hide this with their own check.
+			 */
+			/** \memberof Machine */
+			inline bool expired(Neighbour const & neighbour) const {
+				return false;
+			}
+			
 			inline void print_stack(Stack<Data> *s) {
 				if (s->empty()) {
 				  cout << " Empty " << endl;
@@ -349,6 +359,28 @@ class Machine : public ExtendedMachine {
 				callbacks.push(0);
 			}
 			
+			/// Install the script of another machine by copying its installed state.
+			/**
+			 * This leaves the machine as if it had executed the installation script of \p source, without executing anything.
+			 * The globals are shared with \p source until either machine writes them, which only a new installation does.
+			 * The threads are copied along, and the scratch stacks and state start out empty.
+			 *
+			 * \param source A machine that has finished installing its script.
+			 */
+			inline void install(Machine const & source) {
+				script = source.script;
+				stack.reset(source.stack.size() + source.stack.free());
+				environment.reset(source.environment.size() + source.environment.free());
+				globals = source.globals;
+				threads = source.threads;
+				state.reset(source.state.size());
+				firstFeedbackUpdate.reset(source.firstFeedbackUpdate.size() + source.firstFeedbackUpdate.free());
+				hood.reset(source.thisMachine().imports.size());
+				hood.add(id);
+				current_thread = 0;
+				callbacks.reset(source.callbacks.size() + source.callbacks.free());
+			}
+
 			/// Start the next scheduled task.
 			/**
 			 * \note This does not execute Proto code, it only prepares the next run. Call step() while not finished() to execute it.